@@ -81,11 +81,11 @@ Function<RET(ARGS...)>::operator=(Function<RET(ARGS...)>&& other)
         _invoker = other._invoker;
         _destructor = other._destructor;
         _deleter = other._deleter;
+        _relocator = other._relocator;
         if (other._callable == other._storage.data()) {
-            //copy byte-wise data
-            //Note that in this case the destructor will be called on a seemingly different object than the constructor
-            //however this is valid.
-            _storage = other._storage;
+            //move-construct the functor into our own storage since it may not be trivially relocatable
+            //(e.g. it captures a std::string using the small string optimization)
+            _relocator(_storage.data(), other._callable);
             _callable = _storage.data();
         }
         else {
@@ -134,6 +134,10 @@ void Function<RET(ARGS...)>::initFunctor(FUNCTOR&& functor, std::false_type)
     if (sizeof(FUNCTOR) <= size) {
         new (_storage.data()) FUNCTOR(std::forward<FUNCTOR>(functor));
         _callable = _storage.data();
+        _relocator = [](void* dest, void* src){
+            new (dest) FUNCTOR(std::move(*reinterpret_cast<FUNCTOR*>(src)));
+            reinterpret_cast<FUNCTOR*>(src)->~FUNCTOR(); //the source is disabled so it won't be destroyed again
+        };
     }
     else {
         _callable = new char[sizeof(FUNCTOR)];
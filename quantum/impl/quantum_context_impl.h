@@ -523,6 +523,98 @@ ICoroContext<RET>::forEachBatch(INPUT_IT first,
     return static_cast<Impl*>(this)->template forEachBatch<Ret>(first, num, std::forward<FUNC>(func));
 }
 
+template <class RET>
+template <class INPUT_IT, class FUNC, class>
+std::shared_ptr<ICoroContext<int>>
+ICoroContext<RET>::parallelFor(INPUT_IT first,
+                               INPUT_IT last,
+                               FUNC&& func,
+                               size_t grainSize)
+{
+    return static_cast<Impl*>(this)->parallelFor(first, last, std::forward<FUNC>(func), grainSize);
+}
+
+template <class RET>
+template <class INPUT_IT, class T, class FUNC, class>
+typename ICoroContext<T>::Ptr
+ICoroContext<RET>::reduce(INPUT_IT first,
+                          INPUT_IT last,
+                          T init,
+                          FUNC&& func)
+{
+    return static_cast<Impl*>(this)->reduce(first, last, std::move(init), std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class INPUT_IT, class T, class REDUCE_FUNC, class TRANSFORM_FUNC, class>
+typename ICoroContext<T>::Ptr
+ICoroContext<RET>::transformReduce(INPUT_IT first,
+                                   INPUT_IT last,
+                                   T init,
+                                   REDUCE_FUNC&& reduceFunc,
+                                   TRANSFORM_FUNC&& transformFunc)
+{
+    return static_cast<Impl*>(this)->transformReduce(first,
+                                                     last,
+                                                     std::move(init),
+                                                     std::forward<REDUCE_FUNC>(reduceFunc),
+                                                     std::forward<TRANSFORM_FUNC>(transformFunc));
+}
+
+template <class RET>
+template <class INPUT_IT, class OUTPUT_IT, class FUNC, class>
+typename ICoroContext<OUTPUT_IT>::Ptr
+ICoroContext<RET>::inclusiveScan(INPUT_IT first,
+                                 INPUT_IT last,
+                                 OUTPUT_IT outputIt,
+                                 FUNC&& func)
+{
+    return static_cast<Impl*>(this)->inclusiveScan(first, last, outputIt, std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class INPUT_IT, class OUTPUT_IT, class T, class FUNC, class>
+typename ICoroContext<OUTPUT_IT>::Ptr
+ICoroContext<RET>::exclusiveScan(INPUT_IT first,
+                                 INPUT_IT last,
+                                 OUTPUT_IT outputIt,
+                                 T init,
+                                 FUNC&& func)
+{
+    return static_cast<Impl*>(this)->exclusiveScan(first, last, outputIt, std::move(init), std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class RANDOM_IT, class COMPARE, class>
+std::shared_ptr<ICoroContext<int>>
+ICoroContext<RET>::sort(RANDOM_IT first,
+                        RANDOM_IT last,
+                        COMPARE&& compare)
+{
+    return static_cast<Impl*>(this)->sort(first, last, std::forward<COMPARE>(compare));
+}
+
+template <class RET>
+template <class RANDOM_IT, class PREDICATE, class>
+typename ICoroContext<RANDOM_IT>::Ptr
+ICoroContext<RET>::partition(RANDOM_IT first,
+                             RANDOM_IT last,
+                             PREDICATE&& predicate)
+{
+    return static_cast<Impl*>(this)->partition(first, last, std::forward<PREDICATE>(predicate));
+}
+
+template <class RET>
+template <class RANDOM_IT, class COMPARE, class>
+std::shared_ptr<ICoroContext<int>>
+ICoroContext<RET>::nthElement(RANDOM_IT first,
+                              RANDOM_IT nth,
+                              RANDOM_IT last,
+                              COMPARE&& compare)
+{
+    return static_cast<Impl*>(this)->nthElement(first, nth, last, std::forward<COMPARE>(compare));
+}
+
 template <class RET>
 template <class KEY,
           class MAPPED_TYPE,
@@ -573,20 +665,22 @@ template <class KEY,
           class REDUCED_TYPE,
           class MAPPER_FUNC,
           class REDUCER_FUNC,
+          class COMBINER_FUNC,
           class INPUT_IT,
           class>
 auto
 ICoroContext<RET>::mapReduceBatch(INPUT_IT first,
                                   INPUT_IT last,
                                   MAPPER_FUNC mapper,
-                                  REDUCER_FUNC reducer)->
+                                  REDUCER_FUNC reducer,
+                                  COMBINER_FUNC combiner)->
           CoroContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>
 {
     using Key = decltype(mappedKeyOf(mapper));
     using MappedType = decltype(mappedTypeOf(mapper));
     using ReducedType = decltype(reducedTypeOf(reducer));
     return static_cast<Impl*>(this)->template mapReduceBatch<Key, MappedType, ReducedType>
-        (first, last, std::move(mapper), std::move(reducer));
+        (first, last, std::move(mapper), std::move(reducer), std::move(combiner));
 }
 
 template <class RET>
@@ -595,20 +689,70 @@ template <class KEY,
           class REDUCED_TYPE,
           class MAPPER_FUNC,
           class REDUCER_FUNC,
+          class COMBINER_FUNC,
           class INPUT_IT,
           class>
 auto
 ICoroContext<RET>::mapReduceBatch(INPUT_IT first,
                                   size_t num,
                                   MAPPER_FUNC mapper,
-                                  REDUCER_FUNC reducer)->
+                                  REDUCER_FUNC reducer,
+                                  COMBINER_FUNC combiner)->
           CoroContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>
 {
     using Key = decltype(mappedKeyOf(mapper));
     using MappedType = decltype(mappedTypeOf(mapper));
     using ReducedType = decltype(reducedTypeOf(reducer));
     return static_cast<Impl*>(this)->template mapReduceBatch<Key, MappedType, ReducedType>
-        (first, num, std::move(mapper), std::move(reducer));
+        (first, num, std::move(mapper), std::move(reducer), std::move(combiner));
+}
+
+template <class RET>
+template <template <class...> class OUTPUT,
+          class MAPPER_FUNC,
+          class REDUCER_FUNC,
+          class COMBINER_FUNC,
+          class INPUT_IT,
+          class>
+auto
+ICoroContext<RET>::mapReducePartitioned(INPUT_IT first,
+                                        INPUT_IT last,
+                                        MAPPER_FUNC mapper,
+                                        REDUCER_FUNC reducer,
+                                        COMBINER_FUNC combiner)->
+          CoroContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                          decltype(mappedKeyOf(mapper)),
+                                                          decltype(reducedTypeOf(reducer))>::Type>
+{
+    using Key = decltype(mappedKeyOf(mapper));
+    using MappedType = decltype(mappedTypeOf(mapper));
+    using ReducedType = decltype(reducedTypeOf(reducer));
+    return static_cast<Impl*>(this)->template mapReducePartitioned<OUTPUT, Key, MappedType, ReducedType>
+        (first, last, std::move(mapper), std::move(reducer), std::move(combiner));
+}
+
+template <class RET>
+template <template <class...> class OUTPUT,
+          class MAPPER_FUNC,
+          class REDUCER_FUNC,
+          class COMBINER_FUNC,
+          class INPUT_IT,
+          class>
+auto
+ICoroContext<RET>::mapReducePartitioned(INPUT_IT first,
+                                        size_t num,
+                                        MAPPER_FUNC mapper,
+                                        REDUCER_FUNC reducer,
+                                        COMBINER_FUNC combiner)->
+          CoroContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                          decltype(mappedKeyOf(mapper)),
+                                                          decltype(reducedTypeOf(reducer))>::Type>
+{
+    using Key = decltype(mappedKeyOf(mapper));
+    using MappedType = decltype(mappedTypeOf(mapper));
+    using ReducedType = decltype(reducedTypeOf(reducer));
+    return static_cast<Impl*>(this)->template mapReducePartitioned<OUTPUT, Key, MappedType, ReducedType>
+        (first, num, std::move(mapper), std::move(reducer), std::move(combiner));
 }
 
 //==============================================================================================
@@ -1051,6 +1195,126 @@ Context<RET>::forEachBatch(INPUT_IT first,
                                                      getNumCoroutineThreads());
 }
 
+template <class RET>
+template <class INPUT_IT, class FUNC, class>
+std::shared_ptr<Context<int>>
+Context<RET>::parallelFor(INPUT_IT first,
+                          INPUT_IT last,
+                          FUNC&& func,
+                          size_t grainSize)
+{
+    return post2<int>(Util::parallelForCoro<INPUT_IT, FUNC&&>,
+                      INPUT_IT{first},
+                      size_t(std::distance(first, last)),
+                      std::forward<FUNC>(func),
+                      size_t{grainSize});
+}
+
+template <class RET>
+template <class INPUT_IT, class T, class FUNC, class>
+ContextPtr<T>
+Context<RET>::reduce(INPUT_IT first,
+                     INPUT_IT last,
+                     T init,
+                     FUNC&& func)
+{
+    return post2<T>(Util::reduceCoro<T, INPUT_IT, FUNC&&>,
+                    INPUT_IT{first},
+                    size_t(std::distance(first, last)),
+                    std::move(init),
+                    std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class INPUT_IT, class T, class REDUCE_FUNC, class TRANSFORM_FUNC, class>
+ContextPtr<T>
+Context<RET>::transformReduce(INPUT_IT first,
+                              INPUT_IT last,
+                              T init,
+                              REDUCE_FUNC&& reduceFunc,
+                              TRANSFORM_FUNC&& transformFunc)
+{
+    return post2<T>(Util::transformReduceCoro<T, INPUT_IT, REDUCE_FUNC&&, TRANSFORM_FUNC&&>,
+                    INPUT_IT{first},
+                    size_t(std::distance(first, last)),
+                    std::move(init),
+                    std::forward<REDUCE_FUNC>(reduceFunc),
+                    std::forward<TRANSFORM_FUNC>(transformFunc));
+}
+
+template <class RET>
+template <class INPUT_IT, class OUTPUT_IT, class FUNC, class>
+ContextPtr<OUTPUT_IT>
+Context<RET>::inclusiveScan(INPUT_IT first,
+                            INPUT_IT last,
+                            OUTPUT_IT outputIt,
+                            FUNC&& func)
+{
+    return post2<OUTPUT_IT>(Util::inclusiveScanCoro<INPUT_IT, OUTPUT_IT, FUNC&&>,
+                            INPUT_IT{first},
+                            size_t(std::distance(first, last)),
+                            OUTPUT_IT{outputIt},
+                            std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class INPUT_IT, class OUTPUT_IT, class T, class FUNC, class>
+ContextPtr<OUTPUT_IT>
+Context<RET>::exclusiveScan(INPUT_IT first,
+                            INPUT_IT last,
+                            OUTPUT_IT outputIt,
+                            T init,
+                            FUNC&& func)
+{
+    return post2<OUTPUT_IT>(Util::exclusiveScanCoro<T, INPUT_IT, OUTPUT_IT, FUNC&&>,
+                            INPUT_IT{first},
+                            size_t(std::distance(first, last)),
+                            OUTPUT_IT{outputIt},
+                            std::move(init),
+                            std::forward<FUNC>(func));
+}
+
+template <class RET>
+template <class RANDOM_IT, class COMPARE, class>
+std::shared_ptr<Context<int>>
+Context<RET>::sort(RANDOM_IT first,
+                   RANDOM_IT last,
+                   COMPARE&& compare)
+{
+    return post2<int>(Util::sortCoro<RANDOM_IT, COMPARE&&>,
+                      RANDOM_IT{first},
+                      size_t(std::distance(first, last)),
+                      std::forward<COMPARE>(compare));
+}
+
+template <class RET>
+template <class RANDOM_IT, class PREDICATE, class>
+ContextPtr<RANDOM_IT>
+Context<RET>::partition(RANDOM_IT first,
+                        RANDOM_IT last,
+                        PREDICATE&& predicate)
+{
+    return post2<RANDOM_IT>(Util::partitionCoro<RANDOM_IT, PREDICATE&&>,
+                            RANDOM_IT{first},
+                            size_t(std::distance(first, last)),
+                            std::forward<PREDICATE>(predicate));
+}
+
+template <class RET>
+template <class RANDOM_IT, class COMPARE, class>
+std::shared_ptr<Context<int>>
+Context<RET>::nthElement(RANDOM_IT first,
+                         RANDOM_IT nth,
+                         RANDOM_IT last,
+                         COMPARE&& compare)
+{
+    return post2<int>(Util::nthElementCoro<RANDOM_IT, COMPARE&&>,
+                      RANDOM_IT{first},
+                      size_t(std::distance(first, nth)),
+                      size_t(std::distance(first, last)),
+                      std::forward<COMPARE>(compare));
+}
+
 template <class RET>
 template <class KEY,
           class MAPPED_TYPE,
@@ -1095,9 +1359,10 @@ ContextPtr<std::map<KEY, REDUCED_TYPE>>
 Context<RET>::mapReduceBatch(INPUT_IT first,
                              INPUT_IT last,
                              Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
-                             Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer)
+                             Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                             Functions::CombineFunc<MAPPED_TYPE> combiner)
 {
-    return mapReduceBatch(first, std::distance(first, last), std::move(mapper), std::move(reducer));
+    return mapReduceBatch(first, std::distance(first, last), std::move(mapper), std::move(reducer), std::move(combiner));
 }
 
 template <class RET>
@@ -1109,14 +1374,55 @@ ContextPtr<std::map<KEY, REDUCED_TYPE>>
 Context<RET>::mapReduceBatch(INPUT_IT first,
                              size_t num,
                              Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
-                             Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer)
+                             Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                             Functions::CombineFunc<MAPPED_TYPE> combiner)
 {
     using ReducerOutput = std::map<KEY, REDUCED_TYPE>;
     return post2<ReducerOutput>(Util::mapReduceBatchCoro<KEY, MAPPED_TYPE, REDUCED_TYPE, INPUT_IT>,
                                INPUT_IT{first},
                                size_t{num},
                                Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>{std::move(mapper)},
-                               Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>{std::move(reducer)});
+                               Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>{std::move(reducer)},
+                               Functions::CombineFunc<MAPPED_TYPE>{std::move(combiner)});
+}
+
+template <class RET>
+template <template <class...> class OUTPUT,
+          class KEY,
+          class MAPPED_TYPE,
+          class REDUCED_TYPE,
+          class INPUT_IT,
+          class>
+ContextPtr<typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type>
+Context<RET>::mapReducePartitioned(INPUT_IT first,
+                                   INPUT_IT last,
+                                   Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
+                                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                                   Functions::CombineFunc<MAPPED_TYPE> combiner)
+{
+    return mapReducePartitioned<OUTPUT>(first, std::distance(first, last), std::move(mapper), std::move(reducer), std::move(combiner));
+}
+
+template <class RET>
+template <template <class...> class OUTPUT,
+          class KEY,
+          class MAPPED_TYPE,
+          class REDUCED_TYPE,
+          class INPUT_IT>
+ContextPtr<typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type>
+Context<RET>::mapReducePartitioned(INPUT_IT first,
+                                   size_t num,
+                                   Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
+                                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                                   Functions::CombineFunc<MAPPED_TYPE> combiner)
+{
+    using ReducerOutput = typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type;
+    return post2<ReducerOutput>(Util::mapReducePartitionedCoro<KEY, MAPPED_TYPE, REDUCED_TYPE, OUTPUT, INPUT_IT>,
+                               INPUT_IT{first},
+                               size_t{num},
+                               Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>{std::move(mapper)},
+                               Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>{std::move(reducer)},
+                               Functions::CombineFunc<MAPPED_TYPE>{std::move(combiner)});
 }
 
 template <class RET>
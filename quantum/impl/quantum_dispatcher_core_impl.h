@@ -59,7 +59,7 @@ DispatcherCore::DispatcherCore(const Configuration& config) :
     {
         bool hasSharedQueue = (coroId >= _coroQueueIdRangeForAny.first &&
                                coroId <= _coroQueueIdRangeForAny.second);
-        _coroQueues.emplace_back(config, hasSharedQueue ? _sharedCoroAnyQueue : nullptr);
+        _coroQueues.emplace_back(config, hasSharedQueue ? _sharedCoroAnyQueue : nullptr, coroId);
         // set thread name for coro queues
         IQueue::setThreadName(IQueue::QueueType::Coro,
                               _coroQueues.back().getThread()->native_handle(),
@@ -246,6 +246,118 @@ Dispatcher::forEachBatch(INPUT_IT first,
                  getNumCoroutineThreads());
 }
 
+template <class INPUT_IT, class FUNC, class>
+ThreadContextPtr<int>
+Dispatcher::parallelFor(INPUT_IT first,
+                        INPUT_IT last,
+                        FUNC&& func,
+                        size_t grainSize)
+{
+    return post2(Util::parallelForCoro<INPUT_IT, FUNC&&>,
+                 INPUT_IT{first},
+                 size_t(std::distance(first, last)),
+                 std::forward<FUNC>(func),
+                 size_t{grainSize});
+}
+
+template <class INPUT_IT, class T, class FUNC, class>
+ThreadContextPtr<T>
+Dispatcher::reduce(INPUT_IT first,
+                   INPUT_IT last,
+                   T init,
+                   FUNC&& func)
+{
+    return post2(Util::reduceCoro<T, INPUT_IT, FUNC&&>,
+                 INPUT_IT{first},
+                 size_t(std::distance(first, last)),
+                 std::move(init),
+                 std::forward<FUNC>(func));
+}
+
+template <class INPUT_IT, class T, class REDUCE_FUNC, class TRANSFORM_FUNC, class>
+ThreadContextPtr<T>
+Dispatcher::transformReduce(INPUT_IT first,
+                            INPUT_IT last,
+                            T init,
+                            REDUCE_FUNC&& reduceFunc,
+                            TRANSFORM_FUNC&& transformFunc)
+{
+    return post2(Util::transformReduceCoro<T, INPUT_IT, REDUCE_FUNC&&, TRANSFORM_FUNC&&>,
+                 INPUT_IT{first},
+                 size_t(std::distance(first, last)),
+                 std::move(init),
+                 std::forward<REDUCE_FUNC>(reduceFunc),
+                 std::forward<TRANSFORM_FUNC>(transformFunc));
+}
+
+template <class INPUT_IT, class OUTPUT_IT, class FUNC, class>
+ThreadContextPtr<OUTPUT_IT>
+Dispatcher::inclusiveScan(INPUT_IT first,
+                          INPUT_IT last,
+                          OUTPUT_IT outputIt,
+                          FUNC&& func)
+{
+    return post2(Util::inclusiveScanCoro<INPUT_IT, OUTPUT_IT, FUNC&&>,
+                 INPUT_IT{first},
+                 size_t(std::distance(first, last)),
+                 OUTPUT_IT{outputIt},
+                 std::forward<FUNC>(func));
+}
+
+template <class INPUT_IT, class OUTPUT_IT, class T, class FUNC, class>
+ThreadContextPtr<OUTPUT_IT>
+Dispatcher::exclusiveScan(INPUT_IT first,
+                          INPUT_IT last,
+                          OUTPUT_IT outputIt,
+                          T init,
+                          FUNC&& func)
+{
+    return post2(Util::exclusiveScanCoro<T, INPUT_IT, OUTPUT_IT, FUNC&&>,
+                 INPUT_IT{first},
+                 size_t(std::distance(first, last)),
+                 OUTPUT_IT{outputIt},
+                 std::move(init),
+                 std::forward<FUNC>(func));
+}
+
+template <class RANDOM_IT, class COMPARE, class>
+ThreadContextPtr<int>
+Dispatcher::sort(RANDOM_IT first,
+                 RANDOM_IT last,
+                 COMPARE&& compare)
+{
+    return post2(Util::sortCoro<RANDOM_IT, COMPARE&&>,
+                 RANDOM_IT{first},
+                 size_t(std::distance(first, last)),
+                 std::forward<COMPARE>(compare));
+}
+
+template <class RANDOM_IT, class PREDICATE, class>
+ThreadContextPtr<RANDOM_IT>
+Dispatcher::partition(RANDOM_IT first,
+                      RANDOM_IT last,
+                      PREDICATE&& predicate)
+{
+    return post2(Util::partitionCoro<RANDOM_IT, PREDICATE&&>,
+                 RANDOM_IT{first},
+                 size_t(std::distance(first, last)),
+                 std::forward<PREDICATE>(predicate));
+}
+
+template <class RANDOM_IT, class COMPARE, class>
+ThreadContextPtr<int>
+Dispatcher::nthElement(RANDOM_IT first,
+                       RANDOM_IT nth,
+                       RANDOM_IT last,
+                       COMPARE&& compare)
+{
+    return post2(Util::nthElementCoro<RANDOM_IT, COMPARE&&>,
+                 RANDOM_IT{first},
+                 size_t(std::distance(first, nth)),
+                 size_t(std::distance(first, last)),
+                 std::forward<COMPARE>(compare));
+}
+
 template <class KEY,
           class MAPPED_TYPE,
           class REDUCED_TYPE,
@@ -292,16 +404,18 @@ template <class KEY,
           class REDUCED_TYPE,
           class MAPPER_FUNC,
           class REDUCER_FUNC,
+          class COMBINER_FUNC,
           class INPUT_IT,
           class>
 auto
 Dispatcher::mapReduceBatch(INPUT_IT first,
                            INPUT_IT last,
                            MAPPER_FUNC mapper,
-                           REDUCER_FUNC reducer)->
+                           REDUCER_FUNC reducer,
+                           COMBINER_FUNC combiner)->
           ThreadContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>
 {
-    return mapReduceBatch(first, std::distance(first, last), std::move(mapper), std::move(reducer));
+    return mapReduceBatch(first, std::distance(first, last), std::move(mapper), std::move(reducer), std::move(combiner));
 }
 
 template <class KEY,
@@ -309,13 +423,15 @@ template <class KEY,
           class REDUCED_TYPE,
           class MAPPER_FUNC,
           class REDUCER_FUNC,
+          class COMBINER_FUNC,
           class INPUT_IT,
           class>
 auto
 Dispatcher::mapReduceBatch(INPUT_IT first,
                            size_t num,
                            MAPPER_FUNC mapper,
-                           REDUCER_FUNC reducer)->
+                           REDUCER_FUNC reducer,
+                           COMBINER_FUNC combiner)->
           ThreadContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>
 {
     using Key = decltype(mappedKeyOf(mapper));
@@ -325,7 +441,54 @@ Dispatcher::mapReduceBatch(INPUT_IT first,
                  INPUT_IT{first},
                  size_t{num},
                  Functions::MapFunc<Key, MappedType, INPUT_IT>{std::move(mapper)},
-                 Functions::ReduceFunc<Key, MappedType, ReducedType>{std::move(reducer)});
+                 Functions::ReduceFunc<Key, MappedType, ReducedType>{std::move(reducer)},
+                 Functions::CombineFunc<MappedType>{std::move(combiner)});
+}
+
+template <template <class...> class OUTPUT,
+          class MAPPER_FUNC,
+          class REDUCER_FUNC,
+          class COMBINER_FUNC,
+          class INPUT_IT,
+          class>
+auto
+Dispatcher::mapReducePartitioned(INPUT_IT first,
+                                 INPUT_IT last,
+                                 MAPPER_FUNC mapper,
+                                 REDUCER_FUNC reducer,
+                                 COMBINER_FUNC combiner)->
+          ThreadContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                            decltype(mappedKeyOf(mapper)),
+                                                            decltype(reducedTypeOf(reducer))>::Type>
+{
+    return mapReducePartitioned<OUTPUT>(first, std::distance(first, last), std::move(mapper), std::move(reducer), std::move(combiner));
+}
+
+template <template <class...> class OUTPUT,
+          class MAPPER_FUNC,
+          class REDUCER_FUNC,
+          class COMBINER_FUNC,
+          class INPUT_IT,
+          class>
+auto
+Dispatcher::mapReducePartitioned(INPUT_IT first,
+                                 size_t num,
+                                 MAPPER_FUNC mapper,
+                                 REDUCER_FUNC reducer,
+                                 COMBINER_FUNC combiner)->
+          ThreadContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                            decltype(mappedKeyOf(mapper)),
+                                                            decltype(reducedTypeOf(reducer))>::Type>
+{
+    using Key = decltype(mappedKeyOf(mapper));
+    using MappedType = decltype(mappedTypeOf(mapper));
+    using ReducedType = decltype(reducedTypeOf(reducer));
+    return post2(Util::mapReducePartitionedCoro<Key, MappedType, ReducedType, OUTPUT, INPUT_IT>,
+                 INPUT_IT{first},
+                 size_t{num},
+                 Functions::MapFunc<Key, MappedType, INPUT_IT>{std::move(mapper)},
+                 Functions::ReduceFunc<Key, MappedType, ReducedType>{std::move(reducer)},
+                 Functions::CombineFunc<MappedType>{std::move(combiner)});
 }
 
 inline
@@ -0,0 +1,251 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                 class LockStatistics
+//==============================================================================================
+inline
+LockStatistics::LockStatistics(std::string name) :
+    _name(std::move(name))
+{
+    for (auto&& bucket : _holdTimes)
+    {
+        bucket = 0;
+    }
+}
+
+inline
+const std::string& LockStatistics::name() const
+{
+    return _name;
+}
+
+inline
+size_t LockStatistics::numAcquisitions() const
+{
+    return _numAcquisitions;
+}
+
+inline
+size_t LockStatistics::numContendedAcquisitions() const
+{
+    return _numContendedAcquisitions;
+}
+
+inline
+size_t LockStatistics::numSpins() const
+{
+    return _numSpins;
+}
+
+inline
+size_t LockStatistics::numYields() const
+{
+    return _numYields;
+}
+
+inline
+size_t LockStatistics::numSleeps() const
+{
+    return _numSleeps;
+}
+
+inline
+LockStatistics::HoldTimeHistogram LockStatistics::holdTimeHistogram() const
+{
+    HoldTimeHistogram histogram;
+    for (size_t i = 0; i < numHoldTimeBuckets; ++i)
+    {
+        histogram[i] = _holdTimes[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+inline
+void LockStatistics::recordAcquisition(bool contended,
+                                       size_t spins,
+                                       size_t yields,
+                                       size_t sleeps)
+{
+    _numAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended)
+    {
+        _numContendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        _numSpins.fetch_add(spins, std::memory_order_relaxed);
+        _numYields.fetch_add(yields, std::memory_order_relaxed);
+        _numSleeps.fetch_add(sleeps, std::memory_order_relaxed);
+    }
+}
+
+inline
+void LockStatistics::recordHoldTime(std::chrono::nanoseconds holdTime)
+{
+    //find the highest bit set
+    size_t bucket = 0;
+    for (auto ns = holdTime.count(); (ns > 1) && (bucket < numHoldTimeBuckets-1); ns >>= 1)
+    {
+        ++bucket;
+    }
+    _holdTimes[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline
+void LockStatistics::reset()
+{
+    _numAcquisitions = 0;
+    _numContendedAcquisitions = 0;
+    _numSpins = 0;
+    _numYields = 0;
+    _numSleeps = 0;
+    for (auto&& bucket : _holdTimes)
+    {
+        bucket = 0;
+    }
+}
+
+inline
+void LockStatistics::print(std::ostream& out) const
+{
+    out << "Lock: " << _name << std::endl;
+    out << "Num acquisitions: " << _numAcquisitions << std::endl;
+    out << "Num contended acquisitions: " << _numContendedAcquisitions << std::endl;
+    out << "Num spins: " << _numSpins << std::endl;
+    out << "Num yields: " << _numYields << std::endl;
+    out << "Num sleeps: " << _numSleeps << std::endl;
+    for (size_t i = 0; i < numHoldTimeBuckets; ++i)
+    {
+        size_t count = _holdTimes[i].load(std::memory_order_relaxed);
+        if (count)
+        {
+            out << "Hold time >= " << (1ull << i) << "ns: " << count << std::endl;
+        }
+    }
+}
+
+inline
+std::ostream& operator<<(std::ostream& out, const LockStatistics& stats)
+{
+    stats.print(out);
+    return out;
+}
+
+//==============================================================================================
+//                                 class LockProfiler
+//==============================================================================================
+inline
+constexpr bool LockProfiler::isEnabled()
+{
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline
+LockProfiler& LockProfiler::instance()
+{
+    static LockProfiler profiler;
+    return profiler;
+}
+
+inline
+LockStatistics& LockProfiler::statistics(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& stats = _statistics[name];
+    if (!stats)
+    {
+        stats.reset(new LockStatistics(name));
+    }
+    return *stats;
+}
+
+template <class FUNC>
+void LockProfiler::forEach(FUNC&& func) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto&& entry : _statistics)
+    {
+        func(static_cast<const LockStatistics&>(*entry.second));
+    }
+}
+
+inline
+void LockProfiler::dump(std::ostream& out) const
+{
+    forEach([&out](const LockStatistics& stats)
+    {
+        out << stats << std::endl;
+    });
+}
+
+inline
+void LockProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto&& entry : _statistics)
+    {
+        entry.second->reset();
+    }
+}
+
+//==============================================================================================
+//                                 class LockProfiler::Probe
+//==============================================================================================
+inline
+LockProfiler::Probe::Probe(const char* name) :
+    _stats(name ? &LockProfiler::instance().statistics(name) : nullptr)
+{
+}
+
+inline
+void LockProfiler::Probe::acquired(const Counters& counters, bool exclusive)
+{
+    if (!_stats)
+    {
+        return;
+    }
+    _stats->recordAcquisition((counters._spins + counters._yields + counters._sleeps) > 0,
+                              counters._spins,
+                              counters._yields,
+                              counters._sleeps);
+    if (exclusive)
+    {
+        _acquireTime = std::chrono::steady_clock::now();
+    }
+}
+
+inline
+void LockProfiler::Probe::released()
+{
+    if (!_stats || (_acquireTime == std::chrono::steady_clock::time_point{}))
+    {
+        return;
+    }
+    _stats->recordHoldTime(std::chrono::steady_clock::now() - _acquireTime);
+    _acquireTime = {};
+}
+
+}}
@@ -44,6 +44,15 @@ void yield(ICoroSync::Ptr sync)
 //==============================================================================================
 //                                class Mutex
 //==============================================================================================
+inline
+Mutex::Mutex(const char* name)
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    : _probe(name)
+#endif
+{
+    (void)name;
+}
+
 inline
 void Mutex::lock()
 {
@@ -55,14 +64,38 @@ void Mutex::lock()
 inline
 void Mutex::lock(ICoroSync::Ptr sync)
 {
-    while (!tryLock())
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    while (!tryLockImpl())
+    {
+        ++counters._yields;
+        yield(sync);
+    }
+    _probe.acquired(counters, true);
+#else
+    while (!tryLockImpl())
     {
         yield(sync);
     }
+#endif
 }
 
 inline
 bool Mutex::tryLock()
+{
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    bool rc = tryLockImpl();
+    if (rc) {
+        _probe.acquired(LockProfiler::Counters{}, true);
+    }
+    return rc;
+#else
+    return tryLockImpl();
+#endif
+}
+
+inline
+bool Mutex::tryLockImpl()
 {
     assert(_taskId != local::taskId());
     bool rc = _spinlock.tryLock();
@@ -78,6 +111,9 @@ void Mutex::unlock()
 {
     assert(_taskId == local::taskId());
     _taskId = TaskId{}; //reset the task id
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    _probe.released();
+#endif
     _spinlock.unlock();
 }
 
@@ -0,0 +1,575 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+#include <quantum/quantum_local.h>
+#include <cassert>
+
+namespace Bloomberg {
+namespace quantum {
+
+void yield(ICoroSync::Ptr sync);
+
+//==============================================================================================
+//                                 ParkingReadWriteMutex
+//==============================================================================================
+inline
+ParkingReadWriteMutex::ParkingReadWriteMutex(bool preferWriters) :
+    _preferWriters(preferWriters)
+{
+}
+
+inline
+void ParkingReadWriteMutex::lockRead()
+{
+    //Application must use the other lockRead() overload if we are running inside a coroutine
+    assert(!local::context());
+    lockRead(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::lockRead(ICoroSync::Ptr sync)
+{
+    Waiter waiter = makeWaiter(sync);
+    {//========= LOCKED SCOPE =========
+        SpinLock::Guard guard(_spinlock);
+        if (canLockRead())
+        {
+            ++_numReaders;
+            return;
+        }
+        (*waiter._signal) = 0; //clear signal flag
+        _readers.push_back(waiter);
+    }
+    //========= UNLOCKED SCOPE =========
+    //Read ownership is transferred to us by the releasing writer
+    park(sync, waiter);
+}
+
+inline
+void ParkingReadWriteMutex::lockWrite()
+{
+    //Application must use the other lockWrite() overload if we are running inside a coroutine
+    assert(!local::context());
+    lockWrite(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::lockWrite(ICoroSync::Ptr sync)
+{
+    Waiter waiter = makeWaiter(sync);
+    bool mustPark = false;
+    {//========= LOCKED SCOPE =========
+        SpinLock::Guard guard(_spinlock);
+        if (canLockWrite())
+        {
+            _isWriteLocked = true;
+        }
+        else
+        {
+            (*waiter._signal) = 0; //clear signal flag
+            _writers.push_back(waiter);
+            mustPark = true;
+        }
+    }
+    //========= UNLOCKED SCOPE =========
+    if (mustPark)
+    {
+        //Write ownership is transferred to us by the last releasing owner
+        park(sync, waiter);
+    }
+    _taskId = local::taskId();
+    //task id must be valid
+    assert(_taskId != TaskId{});
+}
+
+inline
+bool ParkingReadWriteMutex::tryLockRead()
+{
+    SpinLock::Guard guard(_spinlock);
+    if (!canLockRead())
+    {
+        return false;
+    }
+    ++_numReaders;
+    return true;
+}
+
+inline
+bool ParkingReadWriteMutex::tryLockWrite()
+{
+    {//========= LOCKED SCOPE =========
+        SpinLock::Guard guard(_spinlock);
+        if (!canLockWrite())
+        {
+            return false;
+        }
+        _isWriteLocked = true;
+    }
+    //mutex is write-locked
+    _taskId = local::taskId();
+    //task id must be valid
+    assert(_taskId != TaskId{});
+    return true;
+}
+
+inline
+void ParkingReadWriteMutex::upgradeToWrite()
+{
+    //Application must use the other upgradeToWrite() overload if we are running inside a coroutine
+    assert(!local::context());
+    upgradeToWrite(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::upgradeToWrite(ICoroSync::Ptr sync)
+{
+    Waiter waiter = makeWaiter(sync);
+    bool mustPark = false;
+    {//========= LOCKED SCOPE =========
+        SpinLock::Guard guard(_spinlock);
+        assert((_numReaders > 0) && !_isWriteLocked);
+        if (_numReaders == 1)
+        {
+            //We are the only reader so upgrade directly
+            _numReaders = 0;
+            _isWriteLocked = true;
+        }
+        else
+        {
+            //Give up the read ownership and wait ahead of all other writers
+            --_numReaders;
+            (*waiter._signal) = 0; //clear signal flag
+            _upgrades.push_back(waiter);
+            mustPark = true;
+        }
+    }
+    //========= UNLOCKED SCOPE =========
+    if (mustPark)
+    {
+        park(sync, waiter);
+    }
+    _taskId = local::taskId();
+    //task id must be valid
+    assert(_taskId != TaskId{});
+}
+
+inline
+bool ParkingReadWriteMutex::tryUpgradeToWrite()
+{
+    {//========= LOCKED SCOPE =========
+        SpinLock::Guard guard(_spinlock);
+        assert((_numReaders > 0) && !_isWriteLocked);
+        if (_numReaders != 1)
+        {
+            return false;
+        }
+        _numReaders = 0;
+        _isWriteLocked = true;
+    }
+    _taskId = local::taskId();
+    //task id must be valid
+    assert(_taskId != TaskId{});
+    return true;
+}
+
+inline
+void ParkingReadWriteMutex::unlockRead()
+{
+    SpinLock::Guard guard(_spinlock);
+    if (_numReaders == 0)
+    {
+        return; //not locked
+    }
+    if (--_numReaders == 0)
+    {
+        handOver();
+    }
+}
+
+inline
+void ParkingReadWriteMutex::unlockWrite()
+{
+    assert(_taskId == local::taskId());
+    _taskId = TaskId{}; //reset the task id
+    SpinLock::Guard guard(_spinlock);
+    if (!_isWriteLocked)
+    {
+        return; //not locked
+    }
+    _isWriteLocked = false;
+    handOver();
+}
+
+inline
+bool ParkingReadWriteMutex::isLocked() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _isWriteLocked || (_numReaders > 0);
+}
+
+inline
+bool ParkingReadWriteMutex::isReadLocked() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _numReaders > 0;
+}
+
+inline
+bool ParkingReadWriteMutex::isWriteLocked() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _isWriteLocked;
+}
+
+inline
+int ParkingReadWriteMutex::numReaders() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _numReaders;
+}
+
+inline
+int ParkingReadWriteMutex::numPendingReaders() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _readers.size();
+}
+
+inline
+int ParkingReadWriteMutex::numPendingWriters() const
+{
+    SpinLock::Guard guard(_spinlock);
+    return _writers.size() + _upgrades.size();
+}
+
+inline
+bool ParkingReadWriteMutex::preferWriters() const
+{
+    return _preferWriters;
+}
+
+inline
+bool ParkingReadWriteMutex::canLockRead() const
+{
+    //Pending upgrades always take precedence over new readers
+    return !_isWriteLocked &&
+           _upgrades.empty() &&
+           (!_preferWriters || _writers.empty());
+}
+
+inline
+bool ParkingReadWriteMutex::canLockWrite() const
+{
+    //Don't barge ahead of parked writers
+    return !_isWriteLocked &&
+           (_numReaders == 0) &&
+           _upgrades.empty() &&
+           _writers.empty();
+}
+
+inline
+ParkingReadWriteMutex::ThreadParker& ParkingReadWriteMutex::threadParker()
+{
+    thread_local static ThreadParker parker;
+    return parker;
+}
+
+inline
+ParkingReadWriteMutex::Waiter ParkingReadWriteMutex::makeWaiter(ICoroSync::Ptr sync)
+{
+    if (sync)
+    {
+        return Waiter{&sync->signal(), nullptr};
+    }
+    ThreadParker& parker = threadParker();
+    return Waiter{&parker._signal, &parker};
+}
+
+inline
+void ParkingReadWriteMutex::park(ICoroSync::Ptr sync, const Waiter& waiter)
+{
+    if (waiter._parker)
+    {
+        //block the thread until ownership is transferred
+        std::unique_lock<std::mutex> lock(waiter._parker->_mutex);
+        waiter._parker->_cond.wait(lock, [&waiter]()->bool
+        {
+            return (*waiter._signal) != 0;
+        });
+    }
+    else
+    {
+        while ((*waiter._signal) == 0)
+        {
+            //coroutine is skipped by the scheduler until ownership is transferred
+            yield(sync);
+        }
+    }
+    (*waiter._signal) = -1; //reset
+}
+
+inline
+void ParkingReadWriteMutex::wake(const Waiter& waiter)
+{
+    if (waiter._parker)
+    {
+        //Notify while holding the parker mutex, otherwise the woken thread could exit
+        //and destroy its parker before it's notified.
+        std::lock_guard<std::mutex> lock(waiter._parker->_mutex);
+        (*waiter._signal) = 1;
+        waiter._parker->_cond.notify_one();
+    }
+    else
+    {
+        (*waiter._signal) = 1;
+    }
+}
+
+inline
+void ParkingReadWriteMutex::handOver()
+{
+    //NOTE: Must be called with '_spinlock' held
+    if (_isWriteLocked || (_numReaders > 0))
+    {
+        return; //still owned
+    }
+    if (!_upgrades.empty())
+    {
+        _isWriteLocked = true;
+        wake(_upgrades.front());
+        _upgrades.pop_front();
+    }
+    else if (!_writers.empty() && (_preferWriters || _readers.empty()))
+    {
+        _isWriteLocked = true;
+        wake(_writers.front());
+        _writers.pop_front();
+    }
+    else if (!_readers.empty())
+    {
+        //Wake up all the parked readers at once
+        _numReaders = static_cast<int>(_readers.size());
+        for (auto&& reader : _readers)
+        {
+            wake(reader);
+        }
+        _readers.clear();
+    }
+}
+
+//==============================================================================================
+//                                 ParkingReadWriteMutex::Guard
+//==============================================================================================
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireRead acquire) :
+    ParkingReadWriteMutex::Guard::Guard(nullptr, lock, acquire)
+{
+    //Application must use the other constructor overload if we are running inside a coroutine
+    assert(!local::context());
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireWrite acquire) :
+    ParkingReadWriteMutex::Guard::Guard(nullptr, lock, acquire)
+{
+    //Application must use the other constructor overload if we are running inside a coroutine
+    assert(!local::context());
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ICoroSync::Ptr sync,
+                                    ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireRead) :
+    _mutex(&lock),
+    _ownsLock(true),
+    _isUpgraded(false)
+{
+    _mutex->lockRead(sync);
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ICoroSync::Ptr sync,
+                                    ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireWrite) :
+    _mutex(&lock),
+    _ownsLock(true),
+    _isUpgraded(true)
+{
+    _mutex->lockWrite(sync);
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireRead,
+                                    LockTraits::TryToLock) :
+    _mutex(&lock),
+    _ownsLock(_mutex->tryLockRead()),
+    _isUpgraded(false)
+{
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::AcquireWrite,
+                                    LockTraits::TryToLock) :
+    _mutex(&lock),
+    _ownsLock(_mutex->tryLockWrite()),
+    _isUpgraded(_ownsLock)
+{
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::AdoptLock) :
+    _mutex(&lock),
+    _ownsLock(lock.isLocked()),
+    _isUpgraded(lock.isWriteLocked())
+{
+}
+
+inline
+ParkingReadWriteMutex::Guard::Guard(ParkingReadWriteMutex& lock,
+                                    LockTraits::DeferLock) :
+    _mutex(&lock)
+{
+}
+
+inline
+ParkingReadWriteMutex::Guard::~Guard()
+{
+    if (ownsLock()) {
+        unlock();
+    }
+}
+
+inline
+void ParkingReadWriteMutex::Guard::lockRead()
+{
+    //Application must use the other lock() overload if we are running inside a coroutine
+    assert(!local::context());
+    lockRead(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::Guard::lockWrite()
+{
+    //Application must use the other lock() overload if we are running inside a coroutine
+    assert(!local::context());
+    lockWrite(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::Guard::lockRead(ICoroSync::Ptr sync)
+{
+    assert(_mutex && !ownsLock());
+    _mutex->lockRead(sync);
+    _ownsLock = true;
+    _isUpgraded = false;
+}
+
+inline
+void ParkingReadWriteMutex::Guard::lockWrite(ICoroSync::Ptr sync)
+{
+    assert(_mutex && !ownsLock());
+    _mutex->lockWrite(sync);
+    _ownsLock = _isUpgraded = true;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::tryLockRead()
+{
+    assert(_mutex && !ownsLock());
+    _ownsLock = _mutex->tryLockRead();
+    return _ownsLock;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::tryLockWrite()
+{
+    assert(_mutex && !ownsLock());
+    _ownsLock = _isUpgraded = _mutex->tryLockWrite();
+    return _ownsLock;
+}
+
+inline
+void ParkingReadWriteMutex::Guard::upgradeToWrite()
+{
+    //Application must use the other upgradeToWrite() overload if we are running inside a coroutine
+    assert(!local::context());
+    upgradeToWrite(nullptr);
+}
+
+inline
+void ParkingReadWriteMutex::Guard::upgradeToWrite(ICoroSync::Ptr sync)
+{
+    assert(_mutex && ownsReadLock());
+    _mutex->upgradeToWrite(sync);
+    _isUpgraded = true;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::tryUpgradeToWrite()
+{
+    assert(_mutex && ownsReadLock());
+    _isUpgraded = _mutex->tryUpgradeToWrite();
+    return _isUpgraded;
+}
+
+inline
+void ParkingReadWriteMutex::Guard::unlock()
+{
+    assert(_mutex && ownsLock());
+    if (ownsReadLock()) {
+        _mutex->unlockRead();
+    }
+    else {
+        _mutex->unlockWrite();
+    }
+    _ownsLock = _isUpgraded = false;
+}
+
+inline
+void ParkingReadWriteMutex::Guard::release()
+{
+    _ownsLock = _isUpgraded = false;
+    _mutex = nullptr;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::ownsLock() const
+{
+    return _ownsLock;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::ownsReadLock() const
+{
+    return _ownsLock && !_isUpgraded;
+}
+
+inline
+bool ParkingReadWriteMutex::Guard::ownsWriteLock() const
+{
+    return _ownsLock && _isUpgraded;
+}
+
+}}
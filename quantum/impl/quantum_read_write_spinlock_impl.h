@@ -68,28 +68,65 @@ namespace quantum {
 //==============================================================================================
 //                                ReadWriteSpinLock
 //==============================================================================================
+inline
+ReadWriteSpinLock::ReadWriteSpinLock(const char* name)
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    : _probe(name)
+#endif
+{
+    (void)name;
+}
+
 inline
 void ReadWriteSpinLock::lockRead()
 {
-    SpinLockUtil::lockRead(_count, LockTraits::Attempt::Unlimited);
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    SpinLockUtil::lockRead(_count, LockTraits::Attempt::Unlimited, &_limits, &counters);
+    _probe.acquired(counters, false);
+#else
+    SpinLockUtil::lockRead(_count, LockTraits::Attempt::Unlimited, &_limits);
+#endif
 }
 
 inline
 void ReadWriteSpinLock::lockWrite()
 {
-    SpinLockUtil::lockWrite(_count, LockTraits::Attempt::Unlimited);
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    SpinLockUtil::lockWrite(_count, LockTraits::Attempt::Unlimited, &_limits, &counters);
+    _probe.acquired(counters, true);
+#else
+    SpinLockUtil::lockWrite(_count, LockTraits::Attempt::Unlimited, &_limits);
+#endif
 }
 
 inline
 bool ReadWriteSpinLock::tryLockRead()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    bool rc = SpinLockUtil::lockRead(_count, LockTraits::Attempt::Once);
+    if (rc) {
+        _probe.acquired(LockProfiler::Counters{}, false);
+    }
+    return rc;
+#else
     return SpinLockUtil::lockRead(_count, LockTraits::Attempt::Once);
+#endif
 }
 
 inline
 bool ReadWriteSpinLock::tryLockWrite()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    bool rc = SpinLockUtil::lockWrite(_count, LockTraits::Attempt::Once);
+    if (rc) {
+        _probe.acquired(LockProfiler::Counters{}, true);
+    }
+    return rc;
+#else
     return SpinLockUtil::lockWrite(_count, LockTraits::Attempt::Once);
+#endif
 }
 
 inline
@@ -101,25 +138,53 @@ void ReadWriteSpinLock::unlockRead()
 inline
 void ReadWriteSpinLock::unlockWrite()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    if (isWriteLocked()) {
+        _probe.released();
+    }
+#endif
     SpinLockUtil::unlockWrite(_count);
 }
 
 inline
 void ReadWriteSpinLock::upgradeToWrite()
 {
-    SpinLockUtil::upgradeToWrite(_count, LockTraits::Attempt::Unlimited);
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    SpinLockUtil::upgradeToWrite(_count, LockTraits::Attempt::Unlimited, &_limits, &counters);
+    _probe.acquired(counters, true);
+#else
+    SpinLockUtil::upgradeToWrite(_count, LockTraits::Attempt::Unlimited, &_limits);
+#endif
 }
 
 inline
 bool ReadWriteSpinLock::tryUpgradeToWrite()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    bool rc = SpinLockUtil::upgradeToWrite(_count, LockTraits::Attempt::Once);
+    if (rc) {
+        _probe.acquired(LockProfiler::Counters{}, true);
+    }
+    return rc;
+#else
     return SpinLockUtil::upgradeToWrite(_count, LockTraits::Attempt::Once);
+#endif
 }
 
 inline
 bool ReadWriteSpinLock::tryUpgradeToWrite(bool& pendingUpgrade)
 {
-    return SpinLockUtil::upgradeToWrite(_count, pendingUpgrade, LockTraits::Attempt::Reentrant);
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    bool rc = SpinLockUtil::upgradeToWrite(_count, pendingUpgrade, LockTraits::Attempt::Reentrant, &_limits, &counters);
+    if (rc) {
+        _probe.acquired(counters, true);
+    }
+    return rc;
+#else
+    return SpinLockUtil::upgradeToWrite(_count, pendingUpgrade, LockTraits::Attempt::Reentrant, &_limits);
+#endif
 }
 
 inline
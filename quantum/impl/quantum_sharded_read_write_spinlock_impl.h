@@ -0,0 +1,409 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+/*
+Readers increment the slot assigned to their thread and then check the writer flag. If a writer
+is present, the reader backs out by decrementing the same slot and waits for the flag to clear.
+Writers set the flag first (Unlocked -> WritePending) and then wait until the sum of all slots
+drops to zero before taking ownership (WritePending -> WriteLocked). Both sides use sequentially
+consistent operations so that either the reader sees the writer flag or the writer sees the
+reader's slot increment.
+
+Slots are owned by threads, so a reader must release the lock on the thread which acquired it.
+Releasing never brings a slot below zero, so an unmatched unlockRead() cannot prevent writers
+from seeing the sum of the slots drop to zero.
+*/
+
+#include <quantum/util/quantum_spinlock_util.h>
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                ShardedReadWriteSpinLock
+//==============================================================================================
+inline
+ShardedReadWriteSpinLock::ShardedReadWriteSpinLock(size_t numSlots) :
+    _slots(numSlots ? numSlots : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+inline
+void ShardedReadWriteSpinLock::lockRead()
+{
+    Slot& readerSlot = slot();
+    while (!enterSlot(readerSlot))
+    {
+        SpinLockUtil::spinWait([this]()->bool
+        {
+            return _writer.load(std::memory_order_acquire) != Unlocked;
+        }, &_limits);
+    }
+}
+
+inline
+void ShardedReadWriteSpinLock::lockWrite()
+{
+    ++_numPendingWriters;
+    acquireWriteFlag(LockTraits::Attempt::Unlimited);
+    waitForReaders();
+    --_numPendingWriters;
+}
+
+inline
+bool ShardedReadWriteSpinLock::tryLockRead()
+{
+    return enterSlot(slot());
+}
+
+inline
+bool ShardedReadWriteSpinLock::tryLockWrite()
+{
+    if (!acquireWriteFlag(LockTraits::Attempt::Once))
+    {
+        return false;
+    }
+    if (sumReaders() != 0)
+    {
+        //back out
+        _writer.store(Unlocked, std::memory_order_release);
+        return false;
+    }
+    _writer.store(WriteLocked, std::memory_order_release);
+    return true;
+}
+
+inline
+void ShardedReadWriteSpinLock::unlockRead()
+{
+    if (isWriteLocked())
+    {
+        return; //no-op if it's write-locked
+    }
+    Slot& readerSlot = slot();
+    int32_t count = readerSlot._count.load(std::memory_order_relaxed);
+    while ((count > 0) &&
+           !readerSlot._count.compare_exchange_weak(count, count-1, std::memory_order_release))
+    {
+        //retry with the updated count
+    }
+}
+
+inline
+void ShardedReadWriteSpinLock::unlockWrite()
+{
+    uint32_t expected = WriteLocked;
+    //no-op if the lock is not write-locked
+    _writer.compare_exchange_strong(expected, Unlocked, std::memory_order_acq_rel);
+}
+
+inline
+void ShardedReadWriteSpinLock::upgradeToWrite()
+{
+    if (acquireWriteFlag(LockTraits::Attempt::Once))
+    {
+        //We are the only writer. Leave the reader slot and wait for the others.
+        ++_numPendingWriters;
+        slot()._count.fetch_sub(1, std::memory_order_seq_cst);
+        waitForReaders();
+        --_numPendingWriters;
+        return;
+    }
+    //Another writer is pending and waiting for us to leave
+    unlockRead();
+    lockWrite();
+}
+
+inline
+bool ShardedReadWriteSpinLock::tryUpgradeToWrite()
+{
+    if (!acquireWriteFlag(LockTraits::Attempt::Once))
+    {
+        return false;
+    }
+    Slot& readerSlot = slot();
+    readerSlot._count.fetch_sub(1, std::memory_order_seq_cst);
+    if (sumReaders() != 0)
+    {
+        //Restore the read lock. No other writer could have entered since we own the flag.
+        readerSlot._count.fetch_add(1, std::memory_order_seq_cst);
+        _writer.store(Unlocked, std::memory_order_release);
+        return false;
+    }
+    _writer.store(WriteLocked, std::memory_order_release);
+    return true;
+}
+
+inline
+bool ShardedReadWriteSpinLock::isLocked() const
+{
+    return isWriteLocked() || (numReaders() > 0);
+}
+
+inline
+bool ShardedReadWriteSpinLock::isReadLocked() const
+{
+    return !isWriteLocked() && (numReaders() > 0);
+}
+
+inline
+bool ShardedReadWriteSpinLock::isWriteLocked() const
+{
+    return _writer.load(std::memory_order_acquire) == WriteLocked;
+}
+
+inline
+int ShardedReadWriteSpinLock::numReaders() const
+{
+    return static_cast<int>(std::max(int64_t{0}, sumReaders()));
+}
+
+inline
+int ShardedReadWriteSpinLock::numPendingWriters() const
+{
+    return _numPendingWriters.load(std::memory_order_acquire);
+}
+
+inline
+size_t ShardedReadWriteSpinLock::numSlots() const
+{
+    return _slots.size();
+}
+
+inline
+size_t ShardedReadWriteSpinLock::threadIndex()
+{
+    static std::atomic_size_t s_numThreads{0};
+    thread_local static size_t s_index = s_numThreads++;
+    return s_index;
+}
+
+inline
+ShardedReadWriteSpinLock::Slot& ShardedReadWriteSpinLock::slot()
+{
+    return _slots[threadIndex() % _slots.size()];
+}
+
+inline
+bool ShardedReadWriteSpinLock::enterSlot(Slot& readerSlot)
+{
+    readerSlot._count.fetch_add(1, std::memory_order_seq_cst);
+    if (_writer.load(std::memory_order_seq_cst) == Unlocked)
+    {
+        return true;
+    }
+    //writer is present so back out
+    readerSlot._count.fetch_sub(1, std::memory_order_seq_cst);
+    return false;
+}
+
+inline
+bool ShardedReadWriteSpinLock::acquireWriteFlag(LockTraits::Attempt attempt)
+{
+    uint32_t expected = Unlocked;
+    while (!_writer.compare_exchange_strong(expected, WritePending, std::memory_order_seq_cst))
+    {
+        if (attempt == LockTraits::Attempt::Once)
+        {
+            return false;
+        }
+        SpinLockUtil::spinWait([this]()->bool
+        {
+            return _writer.load(std::memory_order_acquire) != Unlocked;
+        }, &_limits);
+        expected = Unlocked;
+    }
+    return true;
+}
+
+inline
+void ShardedReadWriteSpinLock::waitForReaders()
+{
+    SpinLockUtil::spinWait([this]()->bool
+    {
+        return sumReaders() != 0;
+    }, &_limits);
+    _writer.store(WriteLocked, std::memory_order_release);
+}
+
+inline
+int64_t ShardedReadWriteSpinLock::sumReaders() const
+{
+    int64_t sum = 0;
+    for (const Slot& readerSlot : _slots)
+    {
+        sum += readerSlot._count.load(std::memory_order_seq_cst);
+    }
+    return sum;
+}
+
+//==============================================================================================
+//                                ShardedReadWriteSpinLock::Guard
+//==============================================================================================
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::AcquireRead) :
+    _spinlock(lock),
+    _ownsLock(true),
+    _isUpgraded(false)
+{
+    _spinlock.lockRead();
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::AcquireWrite) :
+    _spinlock(lock),
+    _ownsLock(true),
+    _isUpgraded(true)
+{
+    _spinlock.lockWrite();
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::AcquireRead,
+                                       LockTraits::TryToLock) :
+    _spinlock(lock),
+    _ownsLock(_spinlock.tryLockRead()),
+    _isUpgraded(false)
+{
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::AcquireWrite,
+                                       LockTraits::TryToLock) :
+    _spinlock(lock),
+    _ownsLock(_spinlock.tryLockWrite()),
+    _isUpgraded(_ownsLock)
+{
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::AdoptLock) :
+    _spinlock(lock),
+    _ownsLock(lock.isLocked()),
+    _isUpgraded(lock.isWriteLocked())
+{
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::Guard(ShardedReadWriteSpinLock& lock,
+                                       LockTraits::DeferLock) :
+    _spinlock(lock)
+{
+}
+
+inline
+ShardedReadWriteSpinLock::Guard::~Guard()
+{
+    if (ownsLock()) {
+        unlock();
+    }
+}
+
+inline
+void ShardedReadWriteSpinLock::Guard::lockRead()
+{
+    assert (!ownsLock());
+    _spinlock.lockRead();
+    _ownsLock = true;
+    _isUpgraded = false;
+}
+
+inline
+void ShardedReadWriteSpinLock::Guard::lockWrite()
+{
+    assert (!ownsLock());
+    _spinlock.lockWrite();
+    _ownsLock = _isUpgraded = true;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::tryLockRead()
+{
+    assert (!ownsLock());
+    _ownsLock = _spinlock.tryLockRead();
+    _isUpgraded = false;
+    return _ownsLock;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::tryLockWrite()
+{
+    assert (!ownsLock());
+    _ownsLock = _isUpgraded = _spinlock.tryLockWrite();
+    return _ownsLock;
+}
+
+inline
+void ShardedReadWriteSpinLock::Guard::upgradeToWrite()
+{
+    assert (ownsLock());
+    _spinlock.upgradeToWrite();
+    _isUpgraded = true;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::tryUpgradeToWrite()
+{
+    assert (ownsLock());
+    _isUpgraded = _spinlock.tryUpgradeToWrite();
+    return _isUpgraded;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::ownsLock() const
+{
+    return _ownsLock;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::ownsReadLock() const
+{
+    return _ownsLock && !_isUpgraded;
+}
+
+inline
+bool ShardedReadWriteSpinLock::Guard::ownsWriteLock() const
+{
+    return _ownsLock && _isUpgraded;
+}
+
+inline
+void ShardedReadWriteSpinLock::Guard::unlock()
+{
+    assert(ownsLock());
+    if (ownsReadLock()) {
+        _spinlock.unlockRead();
+    }
+    else {
+        _spinlock.unlockWrite();
+    }
+    _ownsLock = _isUpgraded = false;
+}
+
+}
+}
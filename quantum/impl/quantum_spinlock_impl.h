@@ -28,21 +28,47 @@ namespace quantum {
 //==============================================================================
 //                                   SpinLock
 //==============================================================================
+inline
+SpinLock::SpinLock(const char* name)
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    : _probe(name)
+#endif
+{
+    (void)name;
+}
+
 inline
 void SpinLock::lock()
 {
-    SpinLockUtil::lockWrite(_flag, LockTraits::Attempt::Unlimited);
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Counters counters;
+    SpinLockUtil::lockWrite(_flag, LockTraits::Attempt::Unlimited, &_limits, &counters);
+    _probe.acquired(counters, true);
+#else
+    SpinLockUtil::lockWrite(_flag, LockTraits::Attempt::Unlimited, &_limits);
+#endif
 }
 
 inline
 bool SpinLock::tryLock()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    bool rc = SpinLockUtil::lockWrite(_flag, LockTraits::Attempt::Once);
+    if (rc) {
+        _probe.acquired(LockProfiler::Counters{}, true);
+    }
+    return rc;
+#else
     return SpinLockUtil::lockWrite(_flag, LockTraits::Attempt::Once);
+#endif
 }
 
 inline
 void SpinLock::unlock()
 {
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    _probe.released();
+#endif
     return SpinLockUtil::unlockWrite(_flag);
 }
 
@@ -19,6 +19,8 @@
 //#################################### IMPLEMENTATIONS #########################################
 //##############################################################################################
 
+#include <algorithm>
+
 namespace Bloomberg {
 namespace quantum {
 
@@ -52,5 +54,45 @@ SpinLockTraits::backoffPolicy() {
     return backoffPolicy;
 }
 
+//==============================================================================
+//                              AdaptiveSpinLimits
+//==============================================================================
+inline size_t
+AdaptiveSpinLimits::spinLimit() const {
+    //Allow twice the average so that acquisitions slightly above average still succeed by spinning
+    size_t limit = SpinLockTraits::minSpins() + 2*(_spins.load(std::memory_order_relaxed) >> fractionBits);
+    return std::min(limit, SpinLockTraits::maxSpins());
+}
+
+inline std::chrono::microseconds
+AdaptiveSpinLimits::sleepDuration() const {
+    //Wake up about twice during an average wait
+    std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds((_waitTime.load(std::memory_order_relaxed) >> fractionBits)/2));
+    return std::max(std::chrono::microseconds(1), std::min(duration, SpinLockTraits::sleepDuration()));
+}
+
+inline void
+AdaptiveSpinLimits::update(size_t spins,
+                           bool spinLimitReached,
+                           std::chrono::nanoseconds waitTime) {
+    //Concurrent updates may occasionally lose a sample which is harmless for an average.
+    //When the spin limit was reached the lock was held for at least that long, so recording the
+    //limit lets it grow towards maxSpins. Otherwise the average moves towards the spins it took.
+    if (spinLimitReached) {
+        spins = std::max(spins, spinLimit());
+    }
+    average(_spins, static_cast<int64_t>(spins));
+    average(_waitTime, static_cast<int64_t>(waitTime.count()));
+}
+
+inline void
+AdaptiveSpinLimits::average(std::atomic<int64_t>& scaledAverage, int64_t sample) {
+    //Exponential moving average with a weight of 1/8 kept in fixed point, i.e. scaled by 8,
+    //so that small differences between the sample and the average are not truncated away.
+    int64_t scaled = scaledAverage.load(std::memory_order_relaxed);
+    scaledAverage.store(scaled + sample - (scaled >> fractionBits), std::memory_order_relaxed);
+}
+
 }}
 
@@ -51,13 +51,17 @@ TaskQueue::TaskQueue() :
 }
 
 inline
-TaskQueue::TaskQueue(const Configuration& configuration, std::shared_ptr<TaskQueue> sharedQueue) :
+TaskQueue::TaskQueue(const Configuration& configuration,
+                     std::shared_ptr<TaskQueue> sharedQueue,
+                     int queueId) :
     _alloc(Allocator<QueueListAllocator>::instance(AllocatorTraits::queueListAllocSize())),
     _runQueue(_alloc),
     _waitQueue(_alloc),
     _queueIt(_runQueue.end()),
     _blockedIt(_runQueue.end()),
     _isBlocked(false),
+    _runQueueLock(lockName("runQueueLock", queueId).c_str()),
+    _waitQueueLock(lockName("waitQueueLock", queueId).c_str()),
     _isEmpty(true),
     _isSharedQueueEmpty(true),
     _isInterrupted(false),
@@ -92,6 +96,15 @@ TaskQueue::TaskQueue(const TaskQueue&) :
 
 }
 
+inline
+std::string TaskQueue::lockName(const char* name, int queueId)
+{
+    //Each queue records its contention separately. The shared queue is named 'any'.
+    return std::string("TaskQueue[") +
+           ((queueId < 0) ? std::string("any") : std::to_string(queueId)) +
+           "]::" + name;
+}
+
 inline
 TaskQueue::~TaskQueue()
 {
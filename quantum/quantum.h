@@ -57,12 +57,15 @@
 #include <quantum/quantum_io_queue.h>
 #include <quantum/quantum_io_task.h>
 #include <quantum/quantum_local.h>
+#include <quantum/quantum_lock_profiler.h>
 #include <quantum/quantum_macros.h>
 #include <quantum/quantum_mutex.h>
+#include <quantum/quantum_parking_read_write_mutex.h>
 #include <quantum/quantum_promise.h>
 #include <quantum/quantum_queue_statistics.h>
 #include <quantum/quantum_read_write_mutex.h>
 #include <quantum/quantum_read_write_spinlock.h>
+#include <quantum/quantum_sharded_read_write_spinlock.h>
 #include <quantum/quantum_shared_state.h>
 #include <quantum/quantum_spinlock.h>
 #include <quantum/quantum_spinlock_traits.h>
@@ -75,6 +78,7 @@
 #include <quantum/quantum_thread_traits.h>
 #include <quantum/quantum_traits.h>
 #include <quantum/quantum_yielding_thread.h>
+#include <quantum/util/quantum_async_cache.h>
 #include <quantum/util/quantum_drain_guard.h>
 #include <quantum/util/quantum_future_joiner.h>
 #include <quantum/util/quantum_generic_future.h>
@@ -70,6 +70,7 @@ class Function<RET(ARGS...)>
     using Callback = RET(*)(void*, ARGS...);
     using Destructor = void(*)(void*);
     using Deleter = void(*)(void*);
+    using Relocator = void(*)(void* dest, void* src);
     
 public:
     // Ctors
@@ -101,6 +102,7 @@ private:
     Callback                _invoker{nullptr};
     Destructor              _destructor{dummy};
     Deleter                 _deleter{dummy};
+    Relocator               _relocator{nullptr}; //only set when the functor is stored in '_storage'
 };
 
 }}
@@ -21,6 +21,7 @@
 #include <quantum/quantum_io_task.h>
 #include <quantum/quantum_dispatcher_core.h>
 #include <quantum/quantum_traits.h>
+#include <functional>
 #include <iterator>
 
 namespace Bloomberg {
@@ -252,6 +253,52 @@ public:
     typename Context<std::vector<std::vector<OTHER_RET>>>::Ptr
     forEachBatch(INPUT_IT first, size_t num, FUNC&& func);
 
+    template <class INPUT_IT, class FUNC, class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    std::shared_ptr<Context<int>>
+    parallelFor(INPUT_IT first, INPUT_IT last, FUNC&& func, size_t grainSize);
+
+    //===================================
+    //           REDUCE & SCAN
+    //===================================
+    template <class INPUT_IT, class T, class FUNC, class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    typename Context<T>::Ptr
+    reduce(INPUT_IT first, INPUT_IT last, T init, FUNC&& func);
+
+    template <class INPUT_IT,
+              class T,
+              class REDUCE_FUNC,
+              class TRANSFORM_FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    typename Context<T>::Ptr
+    transformReduce(INPUT_IT first, INPUT_IT last, T init, REDUCE_FUNC&& reduceFunc, TRANSFORM_FUNC&& transformFunc);
+
+    template <class INPUT_IT, class OUTPUT_IT, class FUNC, class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    typename Context<OUTPUT_IT>::Ptr
+    inclusiveScan(INPUT_IT first, INPUT_IT last, OUTPUT_IT outputIt, FUNC&& func);
+
+    template <class INPUT_IT, class OUTPUT_IT, class T, class FUNC, class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    typename Context<OUTPUT_IT>::Ptr
+    exclusiveScan(INPUT_IT first, INPUT_IT last, OUTPUT_IT outputIt, T init, FUNC&& func);
+
+    //===================================
+    //          SORT & PARTITION
+    //===================================
+    template <class RANDOM_IT,
+              class COMPARE = std::less<typename std::iterator_traits<RANDOM_IT>::value_type>,
+              class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    std::shared_ptr<Context<int>>
+    sort(RANDOM_IT first, RANDOM_IT last, COMPARE&& compare = COMPARE());
+
+    template <class RANDOM_IT, class PREDICATE, class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    typename Context<RANDOM_IT>::Ptr
+    partition(RANDOM_IT first, RANDOM_IT last, PREDICATE&& predicate);
+
+    template <class RANDOM_IT,
+              class COMPARE = std::less<typename std::iterator_traits<RANDOM_IT>::value_type>,
+              class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    std::shared_ptr<Context<int>>
+    nthElement(RANDOM_IT first, RANDOM_IT nth, RANDOM_IT last, COMPARE&& compare = COMPARE());
+
     //===================================
     //           MAP REDUCE
     //===================================
@@ -285,7 +332,8 @@ public:
     mapReduceBatch(INPUT_IT first,
                    INPUT_IT last,
                    Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
-                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer);
+                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                   Functions::CombineFunc<MAPPED_TYPE> combiner = nullptr);
 
     template <class KEY,
               class MAPPED_TYPE,
@@ -295,7 +343,33 @@ public:
     mapReduceBatch(INPUT_IT first,
                    size_t num,
                    Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
-                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer);
+                   Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                   Functions::CombineFunc<MAPPED_TYPE> combiner = nullptr);
+
+    template <template <class...> class OUTPUT,
+              class KEY,
+              class MAPPED_TYPE,
+              class REDUCED_TYPE,
+              class INPUT_IT,
+              class = Traits::IsInputIterator<INPUT_IT>>
+    typename Context<typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type>::Ptr
+    mapReducePartitioned(INPUT_IT first,
+                         INPUT_IT last,
+                         Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
+                         Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                         Functions::CombineFunc<MAPPED_TYPE> combiner = nullptr);
+
+    template <template <class...> class OUTPUT,
+              class KEY,
+              class MAPPED_TYPE,
+              class REDUCED_TYPE,
+              class INPUT_IT>
+    typename Context<typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type>::Ptr
+    mapReducePartitioned(INPUT_IT first,
+                         size_t num,
+                         Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT> mapper,
+                         Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE> reducer,
+                         Functions::CombineFunc<MAPPED_TYPE> combiner = nullptr);
 
     //===================================
     //           NEW / DELETE
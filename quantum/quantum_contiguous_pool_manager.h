@@ -127,7 +127,7 @@ private:
         index_type*         _freeBlocks{nullptr};
         ssize_t             _freeBlockIndex{-1};
         size_t              _numHeapAllocatedBlocks{0};
-        mutable SpinLock    _spinlock;
+        mutable SpinLock    _spinlock{"ContiguousPoolManager::spinlock"};
     };
     std::shared_ptr<Control>  _control;
 };
@@ -82,7 +82,7 @@ private:
     ssize_t             _freeBlockIndex;
     size_t              _numHeapAllocatedBlocks;
     size_t              _stackSize;
-    mutable SpinLock    _spinlock;
+    mutable SpinLock    _spinlock{"CoroutinePoolAllocator::spinlock"};
 };
 
 template <typename STACK_TRAITS>
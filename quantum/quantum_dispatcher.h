@@ -20,6 +20,7 @@
 #include <quantum/quantum_configuration.h>
 #include <quantum/quantum_macros.h>
 #include <quantum/util/quantum_drain_guard.h>
+#include <functional>
 #include <iterator>
 #include <chrono>
 
@@ -234,6 +235,135 @@ public:
     auto forEachBatch(INPUT_IT first, size_t num, FUNC&& func)
         ->ThreadContextPtr<std::vector<std::vector<decltype(coroResult(func))>>>;
     
+    /// @brief Applies the given function to all the elements in the range [first,last) and waits until
+    ///        all of them have been processed. This function runs in parallel.
+    /// @tparam INPUT_IT The type of iterator. Must meet the requirements of a RandomAccessIterator.
+    /// @tparam FUNC A function of type 'void(VoidContextPtr, *INPUT_IT)'.
+    /// @param[in] first The first element in the range.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] func The function.
+    /// @param[in] grainSize The number of elements processed between two yields of a worker coroutine.
+    ///                      If 0, it is tuned automatically so that each chunk runs for about 100us.
+    /// @return A future which is set to 0 once all the elements have been processed.
+    /// @note One worker coroutine runs on each coroutine queue (see IQueue::QueueId::Any) and initially
+    ///       owns an equal share of the range. A worker which runs out of elements steals half of the largest
+    ///       remaining share, so the load stays balanced when the cost of the elements varies.
+    ///       Prefer this function over forEachBatch() for large ranges or when FUNC returns no value.
+    /// @note If FUNC throws, the remaining elements are skipped and the first exception is re-thrown by the future.
+    /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
+    ///          However it should *not* be set and this will result in undefined behavior.
+    template <class INPUT_IT,
+              class FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    ThreadContextPtr<int> parallelFor(INPUT_IT first, INPUT_IT last, FUNC&& func, size_t grainSize = 0);
+    
+    /// @brief Reduces the range [first,last) in parallel, like std::reduce().
+    /// @tparam INPUT_IT The type of iterator. Must meet the requirements of a RandomAccessIterator.
+    /// @tparam T The type of the result.
+    /// @tparam FUNC An associative binary function of type 'T(T, T)'. The elements are combined in order
+    ///         so the function does not need to be commutative.
+    /// @param[in] first The first element in the range.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] init The initial value, which is combined with the reduction of the range.
+    /// @param[in] func The binary function.
+    /// @return A future to the reduced value, or 'init' if the range is empty.
+    /// @note The range is split into one chunk per coroutine queue (see IQueue::QueueId::Any). Each chunk is
+    ///       reduced on its own queue and the partial results are then combined pairwise in a tree of coroutines.
+    template <class INPUT_IT,
+              class T,
+              class FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    ThreadContextPtr<T> reduce(INPUT_IT first, INPUT_IT last, T init, FUNC&& func);
+    
+    /// @brief Applies 'transformFunc' to every element in the range [first,last) and reduces the results
+    ///        in parallel with 'reduceFunc', like std::transform_reduce(). The transformed values are not stored.
+    /// @tparam TRANSFORM_FUNC A unary function of type 'T(*INPUT_IT)'.
+    /// @note See reduce() for details.
+    template <class INPUT_IT,
+              class T,
+              class REDUCE_FUNC,
+              class TRANSFORM_FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    ThreadContextPtr<T> transformReduce(INPUT_IT first,
+                                    INPUT_IT last,
+                                    T init,
+                                    REDUCE_FUNC&& reduceFunc,
+                                    TRANSFORM_FUNC&& transformFunc);
+    
+    /// @brief Computes the inclusive prefix reductions of the range [first,last) in parallel,
+    ///        like std::inclusive_scan().
+    /// @tparam OUTPUT_IT The type of the output iterator. Must meet the requirements of a RandomAccessIterator.
+    /// @tparam FUNC An associative binary function of type 'T(T, T)' where T is the value type of INPUT_IT.
+    /// @param[in] first The first element in the range.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] outputIt The beginning of the output range. May be equal to 'first'.
+    /// @param[in] func The binary function.
+    /// @return A future to the end of the output range.
+    /// @note Each chunk of the range (see reduce()) is reduced in parallel, then each chunk is scanned in parallel
+    ///       starting from the reduction of the chunks before it. The first chunk is scanned in the first pass.
+    template <class INPUT_IT,
+              class OUTPUT_IT,
+              class FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    ThreadContextPtr<OUTPUT_IT> inclusiveScan(INPUT_IT first, INPUT_IT last, OUTPUT_IT outputIt, FUNC&& func);
+    
+    /// @brief Same as inclusiveScan() but excludes the i-th input element from the i-th output element and
+    ///        starts from 'init', like std::exclusive_scan().
+    template <class INPUT_IT,
+              class OUTPUT_IT,
+              class T,
+              class FUNC,
+              class = Traits::IsRandomAccessIterator<INPUT_IT>>
+    ThreadContextPtr<OUTPUT_IT> exclusiveScan(INPUT_IT first, INPUT_IT last, OUTPUT_IT outputIt, T init, FUNC&& func);
+    
+    /// @brief Sorts the range [first,last) in parallel, like std::sort().
+    /// @tparam RANDOM_IT The type of iterator. Must meet the requirements of a RandomAccessIterator.
+    /// @tparam COMPARE A comparison function of type 'bool(const T&, const T&)' which returns true if the first
+    ///         argument is less than the second one.
+    /// @param[in] first The first element in the range.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] compare The comparison function.
+    /// @return A future which completes once the range is sorted.
+    /// @note The range is split into blocks which are sorted in parallel on the coroutine queues
+    ///       (see IQueue::QueueId::Any), then adjacent blocks are merged pairwise, each merge being cut into
+    ///       slices which also run in parallel. Blocks and slices are bounded in size and the workers yield
+    ///       between them, so that the other coroutines sharing their queues keep making progress.
+    /// @note The merges go through a buffer as large as the range, hence the value type must be
+    ///       default-constructible. The sort is not stable.
+    template <class RANDOM_IT,
+              class COMPARE = std::less<typename std::iterator_traits<RANDOM_IT>::value_type>,
+              class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    ThreadContextPtr<int> sort(RANDOM_IT first, RANDOM_IT last, COMPARE&& compare = COMPARE());
+    
+    /// @brief Reorders the range [first,last) in parallel so that the elements satisfying 'predicate' precede
+    ///        the ones which don't, like std::partition().
+    /// @tparam PREDICATE A unary function of type 'bool(const T&)'.
+    /// @param[in] first The first element in the range.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] predicate The predicate.
+    /// @return A future to the first element which does not satisfy the predicate.
+    /// @note The blocks of the range (see sort()) are partitioned in parallel, then the elements on the wrong side
+    ///       of the partition point are swapped in parallel. The relative order of the elements is not preserved.
+    template <class RANDOM_IT,
+              class PREDICATE,
+              class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    ThreadContextPtr<RANDOM_IT> partition(RANDOM_IT first, RANDOM_IT last, PREDICATE&& predicate);
+    
+    /// @brief Reorders the range [first,last) in parallel so that the element pointed at by 'nth' is the one which
+    ///        would be there if the range was sorted, and no element after it is less than any element before it,
+    ///        like std::nth_element().
+    /// @param[in] first The first element in the range.
+    /// @param[in] nth The element to select.
+    /// @param[in] last The last element in the range (exclusive).
+    /// @param[in] compare The comparison function. See sort().
+    /// @return A future which completes once the element is selected.
+    /// @note The range is narrowed down with parallel partitions (see partition()) around the median of a sample,
+    ///       until it is small enough to be handled by std::nth_element().
+    template <class RANDOM_IT,
+              class COMPARE = std::less<typename std::iterator_traits<RANDOM_IT>::value_type>,
+              class = Traits::IsRandomAccessIterator<RANDOM_IT>>
+    ThreadContextPtr<int> nthElement(RANDOM_IT first, RANDOM_IT nth, RANDOM_IT last, COMPARE&& compare = COMPARE());
+    
     /// @brief Implementation of map-reduce functionality.
     /// @tparam KEY The KEY type used for mapping and reducing.
     /// @tparam MAPPED_TYPE The output type after a map operation.
@@ -282,18 +412,23 @@ public:
     /// @brief This version of mapReduce() runs both the mapper and the reducer functions in batches
     ///        for improved performance. This should be used in the case where the functions are
     ///        more CPU intensive with little or no IO.
+    /// @tparam COMBINER_FUNC Optional combiner having the signature 'void(MAPPED_TYPE&, MAPPED_TYPE&&)'. It folds a mapped
+    ///         value into the value previously mapped to the same key by the same batch, so that each batch passes at most
+    ///         one value per key to the reducer. Only valid if the reduction is associative (e.g. counts, sums, min/max).
     /// @note Use this function if InputIt meets the requirement of a RandomAccessIterator.
     template <class KEY = Deprecated,
               class MAPPED_TYPE = Deprecated,
               class REDUCED_TYPE = Deprecated,
               class MAPPER_FUNC,
               class REDUCER_FUNC,
+              class COMBINER_FUNC = std::nullptr_t,
               class INPUT_IT,
               class = Traits::IsInputIterator<INPUT_IT>>
     auto mapReduceBatch(INPUT_IT first,
                         INPUT_IT last,
                         MAPPER_FUNC mapper,
-                        REDUCER_FUNC reducer)->
+                        REDUCER_FUNC reducer,
+                        COMBINER_FUNC combiner = nullptr)->
           ThreadContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>;
     
     /// @brief Same as mapReduceBatch() but takes a length as second argument in case INPUT_IT
@@ -303,14 +438,56 @@ public:
               class REDUCED_TYPE = Deprecated,
               class MAPPER_FUNC,
               class REDUCER_FUNC,
+              class COMBINER_FUNC = std::nullptr_t,
               class INPUT_IT,
               class = Traits::IsInputIterator<INPUT_IT>>
     auto mapReduceBatch(INPUT_IT first,
                         size_t num,
                         MAPPER_FUNC mapper,
-                        REDUCER_FUNC reducer)->
+                        REDUCER_FUNC reducer,
+                        COMBINER_FUNC combiner = nullptr)->
           ThreadContextPtr<std::map<decltype(mappedKeyOf(mapper)), decltype(reducedTypeOf(reducer))>>;
 
+    /// @brief This version of mapReduce() shuffles the mapped values in parallel. The keys are hash-partitioned
+    ///        across the coroutine queues: each mapper batch writes its output into one bucket per partition and
+    ///        each partition then groups and reduces its own keys, so no single coroutine indexes all the values.
+    /// @tparam OUTPUT The container template of the result. Can be std::unordered_map (default), std::map
+    ///         for sorted keys or std::vector for a vector of key-value pairs in no particular order.
+    /// @tparam COMBINER_FUNC Optional combiner. See mapReduceBatch() for details.
+    /// @note KEY must be hashable with std::hash.
+    /// @note Use this function if InputIt meets the requirement of a RandomAccessIterator.
+    template <template <class...> class OUTPUT = std::unordered_map,
+              class MAPPER_FUNC,
+              class REDUCER_FUNC,
+              class COMBINER_FUNC = std::nullptr_t,
+              class INPUT_IT,
+              class = Traits::IsInputIterator<INPUT_IT>>
+    auto mapReducePartitioned(INPUT_IT first,
+                              INPUT_IT last,
+                              MAPPER_FUNC mapper,
+                              REDUCER_FUNC reducer,
+                              COMBINER_FUNC combiner = nullptr)->
+          ThreadContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                            decltype(mappedKeyOf(mapper)),
+                                                            decltype(reducedTypeOf(reducer))>::Type>;
+    
+    /// @brief Same as mapReducePartitioned() but takes a length as second argument in case INPUT_IT
+    ///        is not a random access iterator.
+    template <template <class...> class OUTPUT = std::unordered_map,
+              class MAPPER_FUNC,
+              class REDUCER_FUNC,
+              class COMBINER_FUNC = std::nullptr_t,
+              class INPUT_IT,
+              class = Traits::IsInputIterator<INPUT_IT>>
+    auto mapReducePartitioned(INPUT_IT first,
+                              size_t num,
+                              MAPPER_FUNC mapper,
+                              REDUCER_FUNC reducer,
+                              COMBINER_FUNC combiner = nullptr)->
+          ThreadContextPtr<typename Traits::MapReduceOutput<OUTPUT,
+                                                            decltype(mappedKeyOf(mapper)),
+                                                            decltype(reducedTypeOf(reducer))>::Type>;
+
     /// @brief Signal all threads to immediately terminate and exit. All other pending coroutines and IO tasks will not complete.
     ///        Call this function for a fast shutdown of the dispatcher.
     /// @note This function blocks.
@@ -43,6 +43,9 @@ struct Functions
     template <class KEY, class MAPPED_TYPE, class REDUCED_TYPE>
     using ReduceFunc = std::function<std::pair<KEY, REDUCED_TYPE>(VoidContextPtr,
                                                                   std::pair<KEY, std::vector<MAPPED_TYPE>>&&)>;
+    
+    template <class MAPPED_TYPE>
+    using CombineFunc = std::function<void(MAPPED_TYPE&, MAPPED_TYPE&&)>;
 };
 
 }}
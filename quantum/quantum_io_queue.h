@@ -109,7 +109,7 @@ private:
     size_t                          _loadBalanceBackoffNum;
     std::shared_ptr<std::thread>    _thread;
     TaskList                        _queue;
-    mutable SpinLock                _spinlock;
+    mutable SpinLock                _spinlock{"IoQueue::spinlock"};
     std::mutex                      _notEmptyMutex; //for accessing the condition variable
     std::condition_variable         _notEmptyCond;
     std::atomic_bool                _isEmpty;
@@ -0,0 +1,188 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+#ifndef BLOOMBERG_QUANTUM_LOCK_PROFILER_H
+#define BLOOMBERG_QUANTUM_LOCK_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                 class LockStatistics
+//==============================================================================================
+/// @class LockStatistics
+/// @brief Contention counters and hold-time histogram for a named lock.
+/// @note All locks constructed with the same name share the same statistics object.
+class LockStatistics
+{
+public:
+    /// @brief Number of hold-time histogram buckets. Bucket 'i' counts the hold times
+    ///        in the range [2^i, 2^(i+1)) nanoseconds. The last bucket is unbounded.
+    static constexpr size_t numHoldTimeBuckets = 32;
+    using HoldTimeHistogram = std::array<size_t, numHoldTimeBuckets>;
+
+    /// @brief Constructor.
+    /// @param[in] name The name of the lock(s) being profiled.
+    explicit LockStatistics(std::string name);
+
+    /// @brief Get the lock name.
+    /// @return The name.
+    const std::string& name() const;
+
+    /// @brief Total number of times the lock was acquired.
+    size_t numAcquisitions() const;
+
+    /// @brief Number of acquisitions which did not succeed on the first attempt.
+    size_t numContendedAcquisitions() const;
+
+    /// @brief Total number of spin iterations (i.e. CPU pauses) while waiting for the lock.
+    size_t numSpins() const;
+
+    /// @brief Total number of thread or coroutine yields while waiting for the lock.
+    size_t numYields() const;
+
+    /// @brief Total number of thread sleeps while waiting for the lock.
+    size_t numSleeps() const;
+
+    /// @brief Returns a snapshot of the exclusive hold-time histogram.
+    /// @return The histogram. See numHoldTimeBuckets for the bucket ranges.
+    HoldTimeHistogram holdTimeHistogram() const;
+
+    /// @brief Records a single lock acquisition.
+    /// @param[in] contended True if the lock was not obtained on the first attempt.
+    /// @param[in] spins Number of spin iterations while acquiring.
+    /// @param[in] yields Number of yields while acquiring.
+    /// @param[in] sleeps Number of sleeps while acquiring.
+    void recordAcquisition(bool contended,
+                           size_t spins,
+                           size_t yields,
+                           size_t sleeps);
+
+    /// @brief Records the amount of time the lock was held exclusively.
+    /// @param[in] holdTime The hold time.
+    void recordHoldTime(std::chrono::nanoseconds holdTime);
+
+    /// @brief Resets all counters.
+    void reset();
+
+    /// @brief Prints the counters and the non-empty histogram buckets.
+    /// @param[in] out The output stream.
+    void print(std::ostream& out) const;
+
+private:
+    std::string                                         _name;
+    std::atomic_size_t                                  _numAcquisitions{0};
+    std::atomic_size_t                                  _numContendedAcquisitions{0};
+    std::atomic_size_t                                  _numSpins{0};
+    std::atomic_size_t                                  _numYields{0};
+    std::atomic_size_t                                  _numSleeps{0};
+    std::array<std::atomic_size_t, numHoldTimeBuckets>  _holdTimes;
+};
+
+std::ostream& operator<<(std::ostream& out, const LockStatistics& stats);
+
+//==============================================================================================
+//                                 class LockProfiler
+//==============================================================================================
+/// @class LockProfiler
+/// @brief Process-wide registry of lock contention statistics.
+/// @details Lock profiling is enabled at compile time by defining __QUANTUM_ENABLE_LOCK_PROFILING
+///          (see the QUANTUM_ENABLE_LOCK_PROFILING cmake option). When enabled, SpinLock, Mutex and
+///          ReadWriteSpinLock objects constructed with a name record their acquisitions into the
+///          statistics registered under that name. Internal library locks (task queue locks,
+///          pool allocator locks, etc.) are always named. Unnamed locks are never profiled.
+///          When disabled, the registry is empty and the locks carry no profiling overhead.
+class LockProfiler
+{
+public:
+    /// @brief Cost of a single acquisition, counted by the lock while it waits.
+    struct Counters
+    {
+        size_t  _spins{0};
+        size_t  _yields{0};
+        size_t  _sleeps{0};
+    };
+
+    /// @brief Indicates if lock profiling was compiled in.
+    static constexpr bool isEnabled();
+
+    /// @brief Get the registry instance.
+    static LockProfiler& instance();
+
+    /// @brief Get or create the statistics for a lock name.
+    /// @param[in] name Lock name.
+    /// @return Reference to the statistics which remains valid for the lifetime of the process.
+    LockStatistics& statistics(const std::string& name);
+
+    /// @brief Iterate over all the registered statistics in name order.
+    /// @param[in] func Callable with signature void(const LockStatistics&).
+    template <class FUNC>
+    void forEach(FUNC&& func) const;
+
+    /// @brief Prints all the registered statistics.
+    /// @param[in] out The output stream.
+    void dump(std::ostream& out) const;
+
+    /// @brief Resets the counters of all the registered statistics.
+    void reset();
+
+    //==============================================================================================
+    //                                 class LockProfiler::Probe
+    //==============================================================================================
+    /// @class LockProfiler::Probe
+    /// @brief Per-lock recording helper.
+    /// @note For internal use only.
+    class Probe
+    {
+    public:
+        /// @brief Constructor.
+        /// @param[in] name Lock name. If null, the probe is disabled.
+        explicit Probe(const char* name);
+
+        /// @brief Records an acquisition.
+        /// @param[in] counters Spins, yields and sleeps performed by this acquisition only.
+        /// @param[in] exclusive True if the lock is held exclusively and its hold time must be measured.
+        /// @note The acquisition is considered contended if it spun, yielded or slept.
+        void acquired(const Counters& counters, bool exclusive);
+
+        /// @brief Records the hold time of an exclusive owner.
+        void released();
+
+    private:
+        LockStatistics*                         _stats{nullptr};
+        std::chrono::steady_clock::time_point   _acquireTime;
+    };
+
+private:
+    LockProfiler() = default;
+
+    mutable std::mutex                                      _mutex;
+    std::map<std::string, std::unique_ptr<LockStatistics>>  _statistics;
+};
+
+}}
+
+#include <quantum/impl/quantum_lock_profiler_impl.h>
+
+#endif //BLOOMBERG_QUANTUM_LOCK_PROFILER_H
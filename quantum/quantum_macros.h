@@ -28,5 +28,6 @@
 #define QUANTUM_BACKOFF_EXPONENTIAL 1
 #define QUANTUM_BACKOFF_EQUALSTEP 2
 #define QUANTUM_BACKOFF_RANDOM 3
+#define QUANTUM_BACKOFF_ADAPTIVE 4
 
 #endif //BLOOMBERG_QUANTUM_MACROS_H
@@ -40,6 +40,11 @@ public:
     /// @brief Constructor. The object is in the unlocked state.
     Mutex() = default;
     
+    /// @brief Constructs a named mutex which is in the unlocked state.
+    /// @param[in] name Name under which contention statistics are recorded when lock profiling
+    ///                 is enabled. See LockProfiler for more details.
+    explicit Mutex(const char* name);
+    
     Mutex(const Mutex& other) = delete;
     Mutex& operator=(const Mutex& other) = delete;
     
@@ -154,9 +159,14 @@ public:
     };
     
 private:
+    bool tryLockImpl();
+    
     //Members
     mutable SpinLock  _spinlock;
     mutable TaskId    _taskId;
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Probe _probe{nullptr};
+#endif
 };
 
 }}
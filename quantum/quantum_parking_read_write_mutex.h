@@ -0,0 +1,272 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+#ifndef BLOOMBERG_QUANTUM_PARKING_READ_WRITE_MUTEX_H
+#define BLOOMBERG_QUANTUM_PARKING_READ_WRITE_MUTEX_H
+
+#include <quantum/quantum_spinlock.h>
+#include <quantum/interface/quantum_icoro_sync.h>
+#include <quantum/quantum_task_id.h>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                 class ParkingReadWriteMutex
+//==============================================================================================
+/// @class ParkingReadWriteMutex
+/// @brief Coroutine-compatible reader/writer mutex which parks waiters instead of spinning.
+/// @details Contending readers and writers are placed on separate FIFO wait queues and their
+///          coroutine is marked as blocked so that it is skipped by the scheduler until the lock
+///          is handed over to it. Contending threads block on a condition variable. On release,
+///          ownership is transferred directly to the next writer or to the entire batch of waiting
+///          readers at once.
+/// @note When writer preference is enabled, new readers queue behind any waiting writer so that
+///       writers cannot be starved by a continuous stream of readers. Otherwise readers are
+///       admitted as long as no writer holds the lock.
+/// @warning Handing the lock over to a parked waiter is slower than letting it spin or yield.
+///          With short critical sections under heavy contention ReadWriteMutex has a much higher
+///          throughput. This mutex is meant for long critical sections, for callers which must not
+///          burn CPU while waiting, or when writers must not be starved.
+class ParkingReadWriteMutex
+{
+public:
+    /// @brief Constructor. The object is in the unlocked state.
+    /// @param[in] preferWriters If true, waiting writers are served ahead of new and waiting readers.
+    explicit ParkingReadWriteMutex(bool preferWriters = true);
+
+    /// @brief Copy constructor
+    ParkingReadWriteMutex(const ParkingReadWriteMutex&) = delete;
+
+    /// @brief Move constructor
+    ParkingReadWriteMutex(ParkingReadWriteMutex&&) = delete;
+
+    /// @brief Copy assignment operator
+    ParkingReadWriteMutex& operator=(const ParkingReadWriteMutex&) = delete;
+
+    /// @brief Move assignment operator
+    ParkingReadWriteMutex& operator=(ParkingReadWriteMutex&&) = delete;
+
+    /// @brief Lock this object as a reader (shared with other readers)
+    /// @details The current context will be parked until the lock is acquired.
+    /// @note From a non-coroutine context, call the first. From a coroutine context,
+    ///       call the second.
+    /// @warning Wrongfully calling the first version from a coroutine context will
+    ///          block all coroutines running on the same queue and result in noticeable
+    ///          performance degradation.
+    void lockRead();
+    void lockRead(ICoroSync::Ptr sync);
+
+    /// @brief Lock this object as a writer (exclusive)
+    /// @details The current context will be parked until the lock is acquired.
+    /// @note From a non-coroutine context, call the first. From a coroutine context,
+    ///       call the second.
+    /// @warning Wrongfully calling the first version from a coroutine context will
+    ///          block all coroutines running on the same queue and result in noticeable
+    ///          performance degradation.
+    void lockWrite();
+    void lockWrite(ICoroSync::Ptr sync);
+
+    /// @brief Attempts to lock this object as a reader (shared with other readers)
+    /// @return True if the lock operation succeeded, false otherwise.
+    bool tryLockRead();
+
+    /// @brief Attempts to lock this object as a writer (exclusive)
+    /// @return True if the lock operation succeeded, false otherwise.
+    bool tryLockWrite();
+
+    /// @brief Upgrade this reader to a writer
+    /// @note Blocks until upgrade is performed. If other readers hold the lock, the read
+    ///       ownership is released and the caller is parked ahead of all other writers.
+    /// @note The lock must already be owned prior to invoking this function.
+    void upgradeToWrite();
+    void upgradeToWrite(ICoroSync::Ptr sync);
+
+    /// @brief Try to upgrade this reader to a writer.
+    /// @return True is succeeded.
+    /// @note Does not block.
+    /// @note The lock must already be owned prior to invoking this function.
+    bool tryUpgradeToWrite();
+
+    /// @brief Unlocks the reader lock.
+    /// @warning Locking this object as a writer and incorrectly unlocking it as a reader results in undefined behavior.
+    void unlockRead();
+
+    /// @brief Unlocks the writer lock.
+    /// @warning Locking this object as a reader and incorrectly unlocking it as a writer results in undefined behavior.
+    void unlockWrite();
+
+    /// @brief Determines if this object is either read or write locked.
+    /// @return True if locked, false otherwise.
+    bool isLocked() const;
+
+    /// @brief Determines if this object is read locked.
+    /// @return True if locked, false otherwise.
+    bool isReadLocked() const;
+
+    /// @brief Determines if this object is write locked.
+    /// @return True if locked, false otherwise.
+    bool isWriteLocked() const;
+
+    /// @brief Returns the number of readers holding the lock.
+    /// @return The number of readers.
+    int numReaders() const;
+
+    /// @brief Returns the number of parked readers.
+    /// @return The number of readers.
+    int numPendingReaders() const;
+
+    /// @brief Returns the number of parked writers, including pending upgrades.
+    /// @return The number of writers.
+    int numPendingWriters() const;
+
+    /// @brief Indicates if this mutex gives preference to writers.
+    /// @return True if writers are preferred.
+    bool preferWriters() const;
+
+    //==============================================================================================
+    //                                class ParkingReadWriteMutex::Guard
+    //==============================================================================================
+    class Guard
+    {
+    public:
+        /// @brief Construct this object and lock the passed-in mutex.
+        /// @param[in] lock ParkingReadWriteMutex which protects a scope during the lifetime of the Guard.
+        /// @param[in] acquire Determines the type of ownership.
+        /// @note Blocks the current thread until the mutex is acquired.
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::AcquireRead acquire);
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::AcquireWrite acquire);
+        Guard(ICoroSync::Ptr sync,
+              ParkingReadWriteMutex& lock,
+              LockTraits::AcquireRead acquire);
+        Guard(ICoroSync::Ptr sync,
+              ParkingReadWriteMutex& lock,
+              LockTraits::AcquireWrite acquire);
+
+        /// @brief Construct this object and try to lock the passed-in mutex.
+        /// @param[in] lock ParkingReadWriteMutex which protects a scope during the lifetime of the Guard.
+        /// @param[in] acquire Determines the type of ownership.
+        /// @param[in] tryLock Tag. Not used.
+        /// @note Attempts to lock the mutex. Does not block.
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::AcquireRead acquire,
+              LockTraits::TryToLock tryLock);
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::AcquireWrite acquire,
+              LockTraits::TryToLock tryToLock);
+
+        /// @brief Construct this object and depending on the flag may assume ownership.
+        /// @param[in] lock ParkingReadWriteMutex which protects a scope during the lifetime of the Guard.
+        /// @param[in] adoptLock If supplied, assumes the current 'locked' state of the lock.
+        /// @param[in] deferLock If supplied, assumes the lock is 'unlocked' and does not lock it.
+        /// @note Does not block.
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::AdoptLock adoptLock);
+        Guard(ParkingReadWriteMutex& lock,
+              LockTraits::DeferLock deferLock);
+
+        /// @brief Destroy this object and unlocks the underlying mutex if it has ownership.
+        ~Guard();
+
+        /// @brief Acquire the underlying mutex as reader or writer.
+        /// @note Blocks.
+        void lockRead();
+        void lockRead(ICoroSync::Ptr sync);
+        void lockWrite();
+        void lockWrite(ICoroSync::Ptr sync);
+
+        /// @brief Try to acquire the underlying mutex.
+        /// @return True if mutex is locked, false otherwise.
+        /// @note Does not block.
+        bool tryLockRead();
+        bool tryLockWrite();
+
+        /// @brief Upgrade this reader to a writer.
+        /// @note Blocks until upgrade is performed.
+        /// @note The lock must already be owned prior to invoking this function.
+        void upgradeToWrite();
+        void upgradeToWrite(ICoroSync::Ptr sync);
+
+        /// @brief Try to upgrade this reader to a writer.
+        /// @return True is succeeded.
+        /// @note Does not block.
+        /// @note The lock must already be owned prior to invoking this function.
+        bool tryUpgradeToWrite();
+
+        /// @brief Unlocks the underlying mutex if it has ownership.
+        void unlock();
+
+        /// @brief Release the associated mutex without unlocking it.
+        void release();
+
+        /// @brief Indicates if this object owns the underlying mutex.
+        /// @return True if ownership is acquired.
+        bool ownsLock() const;
+        bool ownsReadLock() const;
+        bool ownsWriteLock() const;
+
+    private:
+        ParkingReadWriteMutex*  _mutex{nullptr};
+        bool                    _ownsLock{false};
+        bool                    _isUpgraded{false};
+    };
+
+private:
+    // Blocking primitive used by threads (i.e. non-coroutine callers)
+    struct ThreadParker
+    {
+        std::atomic_int             _signal{-1};
+        std::mutex                  _mutex;
+        std::condition_variable     _cond;
+    };
+
+    struct Waiter
+    {
+        std::atomic_int*    _signal;
+        ThreadParker*       _parker; //null for coroutines
+    };
+    using WaitQueue = std::list<Waiter>;
+
+    static ThreadParker& threadParker();
+    static Waiter makeWaiter(ICoroSync::Ptr sync);
+    static void park(ICoroSync::Ptr sync, const Waiter& waiter);
+    static void wake(const Waiter& waiter);
+    bool canLockRead() const;
+    bool canLockWrite() const;
+    void handOver();
+
+    // Members
+    mutable SpinLock    _spinlock;
+    WaitQueue           _readers;
+    WaitQueue           _writers;
+    WaitQueue           _upgrades;
+    int                 _numReaders{0};
+    bool                _isWriteLocked{false};
+    const bool          _preferWriters;
+    TaskId              _taskId;
+};
+
+}
+}
+
+#include <quantum/impl/quantum_parking_read_write_mutex_impl.h>
+
+#endif //BLOOMBERG_QUANTUM_PARKING_READ_WRITE_MUTEX_H
@@ -0,0 +1,223 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+#ifndef BLOOMBERG_QUANTUM_SHARDED_READ_WRITE_SPINLOCK_H
+#define BLOOMBERG_QUANTUM_SHARDED_READ_WRITE_SPINLOCK_H
+
+#include <quantum/quantum_spinlock_traits.h>
+#include <atomic>
+#include <vector>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                 class ShardedReadWriteSpinLock
+//==============================================================================================
+/// @class ShardedReadWriteSpinLock
+/// @brief Reader/writer spinlock optimized for read-mostly workloads.
+/// @details Instead of a single shared counter, readers register themselves in one of several
+///          cache-line aligned slots selected by the calling thread. Readers on different threads
+///          therefore never touch the same cache line. A writer first announces itself via a
+///          separate flag, which prevents new readers from entering, and then scans all the slots
+///          until every reader has left.
+/// @note Readers are cheaper and scale with the number of cores while writers are more expensive
+///       than with ReadWriteSpinLock since they must visit every slot. Use ReadWriteSpinLock when
+///       writes are frequent.
+/// @warning A read lock must be released on the same thread which acquired it, since it is recorded
+///          in that thread's slot. Coroutines which may resume on a different thread (e.g. when using
+///          shared queues) or locks handed over between threads must use ReadWriteSpinLock instead.
+class ShardedReadWriteSpinLock
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] numSlots Number of reader slots. If 0, the number of hardware threads is used.
+    explicit ShardedReadWriteSpinLock(size_t numSlots = 0);
+
+    /// @brief Copy constructor.
+    ShardedReadWriteSpinLock(const ShardedReadWriteSpinLock&) = delete;
+
+    /// @brief Move constructor.
+    ShardedReadWriteSpinLock(ShardedReadWriteSpinLock&&) = delete;
+
+    /// @brief Copy assignment operator.
+    ShardedReadWriteSpinLock& operator=(const ShardedReadWriteSpinLock&) = delete;
+
+    /// @brief Move assignment operator.
+    ShardedReadWriteSpinLock& operator=(ShardedReadWriteSpinLock&&) = delete;
+
+    /// @brief Lock this object as a reader (shared with other readers)
+    void lockRead();
+
+    /// @brief Lock this object as a writer (exclusive)
+    void lockWrite();
+
+    /// @brief Attempts to lock this object as a reader (shared with other readers). This operation never blocks.
+    /// @return True if the lock operation succeeded, false otherwise.
+    bool tryLockRead();
+
+    /// @brief Attempts to lock this object as a writer (exclusive). This operation never blocks.
+    /// @return True if the lock operation succeeded, false otherwise.
+    bool tryLockWrite();
+
+    /// @brief Unlocks the reader lock.
+    /// @note This is a no-op if the slot of the calling thread holds no readers.
+    /// @warning Locking this object as a writer and incorrectly unlocking it as a reader results in undefined behavior.
+    void unlockRead();
+
+    /// @brief Unlocks the writer lock.
+    /// @warning Locking this object as a reader and incorrectly unlocking it as a writer results in undefined behavior.
+    void unlockWrite();
+
+    /// @brief Upgrades a Reader to a Writer.
+    /// @note If another writer is already pending, the read lock is released before acquiring the write lock.
+    /// @warning Calling this while not owning the read lock results in undefined behavior.
+    void upgradeToWrite();
+
+    /// @brief Attempts to upgrade a reader lock to a writer lock. This operation never blocks.
+    /// @return True if the lock operation succeeded, false otherwise.
+    bool tryUpgradeToWrite();
+
+    /// @brief Determines if this object is either read or write locked.
+    /// @return True if locked, false otherwise.
+    bool isLocked() const;
+
+    /// @brief Determines if this object is read locked.
+    /// @return True if locked, false otherwise.
+    bool isReadLocked() const;
+
+    /// @brief Determines if this object is write locked.
+    /// @return True if locked, false otherwise.
+    bool isWriteLocked() const;
+
+    /// @brief Returns the number of readers holding the lock.
+    /// @return The number of readers.
+    /// @note: This is not an atomic operation
+    int numReaders() const;
+
+    /// @brief Returns the number of writers (including upgrading readers) waiting to acquire the lock.
+    /// @return The number of writers.
+    int numPendingWriters() const;
+
+    /// @brief Returns the number of reader slots.
+    /// @return The number of slots.
+    size_t numSlots() const;
+
+    //==============================================================================================
+    //                                class ShardedReadWriteSpinLock::Guard
+    //==============================================================================================
+    class Guard
+    {
+    public:
+        /// @brief Construct this object and lock the passed-in spinlock as a reader.
+        /// @param[in] lock ShardedReadWriteSpinLock which protects a scope during the lifetime of the Guard.
+        /// @param[in] acquire Determines the type of ownership.
+        /// @note Blocks the current thread until the spinlock is acquired.
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::AcquireRead acquire);
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::AcquireWrite acquire);
+
+        /// @brief Construct this object and tries to lock the passed-in spinlock as a reader.
+        /// @param[in] lock ShardedReadWriteSpinLock which protects a scope during the lifetime of the Guard.
+        /// @param[in] acquire Determines the type of ownership.
+        /// @param[in] tryLock Tag. Not used.
+        /// @note Attempts to lock the spinlock. Does not block.
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::AcquireRead acquire,
+              LockTraits::TryToLock tryLock);
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::AcquireWrite acquire,
+              LockTraits::TryToLock tryLock);
+
+        /// @brief Construct this object and depending on the flag may assume ownership.
+        /// @param[in] lock ShardedReadWriteSpinLock which protects a scope during the lifetime of the Guard.
+        /// @param[in] adoptLock If supplied, assumes the current 'locked' state of the lock.
+        /// @param[in] deferLock If supplied, assumes the lock is 'unlocked' and does not lock it.
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::AdoptLock adoptLock);
+        Guard(ShardedReadWriteSpinLock& lock,
+              LockTraits::DeferLock deferLock);
+
+        /// @brief Destroy this object and unlock the underlying spinlock.
+        ~Guard();
+
+        /// @brief Acquire the underlying spinlock.
+        /// @note Blocks.
+        void lockRead();
+        void lockWrite();
+
+        /// @brief Try to acquire the underlying spinlock.
+        /// @return True if spinlock is locked, false otherwise.
+        /// @note Does not block.
+        bool tryLockRead();
+        bool tryLockWrite();
+
+        /// @brief Upgrade this reader to a writer.
+        /// @note Blocks until upgrade is performed.
+        void upgradeToWrite();
+
+        /// @brief Try to upgrade this reader to a writer.
+        /// @return True is succeeded.
+        /// @note Does not block.
+        bool tryUpgradeToWrite();
+
+        /// @brief Indicates if this object owns the underlying spinlock.
+        /// @return True if ownership is acquired.
+        bool ownsLock() const;
+        bool ownsReadLock() const;
+        bool ownsWriteLock() const;
+
+        /// @brief Unlocks the underlying spinlock if it has ownership.
+        void unlock();
+    private:
+        ShardedReadWriteSpinLock&   _spinlock;
+        bool                        _ownsLock{false};
+        bool                        _isUpgraded{false};
+    };
+
+private:
+    enum WriterState : uint32_t
+    {
+        Unlocked = 0,
+        WritePending = 1,   ///< Writer waits for the readers to leave
+        WriteLocked = 2
+    };
+
+    struct alignas(128) Slot
+    {
+        std::atomic_int32_t _count{0};
+    };
+
+    static size_t threadIndex();
+    Slot& slot();
+    bool enterSlot(Slot& slot);
+    bool acquireWriteFlag(LockTraits::Attempt attempt);
+    void waitForReaders();
+    int64_t sumReaders() const;
+
+    // Members
+    std::vector<Slot>                   _slots;
+    alignas(128) std::atomic_uint32_t   _writer{0};
+    std::atomic_int                     _numPendingWriters{0};
+    alignas(128) AdaptiveSpinLimits     _limits; //shared by readers and writers, see SpinLockTraits::BackoffPolicy::Adaptive
+};
+
+}
+}
+
+#include <quantum/impl/quantum_sharded_read_write_spinlock_impl.h>
+
+#endif //BLOOMBERG_QUANTUM_SHARDED_READ_WRITE_SPINLOCK_H
@@ -17,6 +17,7 @@
 #define BLOOMBERG_QUANTUM_SPINLOCK_H
 
 #include <quantum/quantum_spinlock_traits.h>
+#include <quantum/quantum_lock_profiler.h>
 #include <atomic>
 #include <mutex>
 
@@ -35,6 +36,11 @@ public:
     /// @brief Spinlock is in unlocked state
     SpinLock() = default;
     
+    /// @brief Constructs a named spinlock which is in unlocked state.
+    /// @param[in] name Name under which contention statistics are recorded when lock profiling
+    ///                 is enabled. See LockProfiler for more details.
+    explicit SpinLock(const char* name);
+    
     /// @brief Copy constructor.
     SpinLock(const SpinLock&) = delete;
     
@@ -144,6 +150,10 @@ public:
     
 private:
     alignas(128) std::atomic_uint32_t _flag{0};
+    alignas(128) AdaptiveSpinLimits   _limits; //kept apart from the lock word which is written on every acquisition
+#ifdef __QUANTUM_ENABLE_LOCK_PROFILING
+    LockProfiler::Probe               _probe{nullptr};
+#endif
 };
 
 }}
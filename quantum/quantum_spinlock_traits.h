@@ -17,6 +17,7 @@
 #define QUANTUM_QUANTUM_SPINLOCK_TRAITS_H
 
 #include <quantum/quantum_macros.h>
+#include <atomic>
 #include <mutex>
 #include <chrono>
 
@@ -51,7 +52,9 @@ struct SpinLockTraits {
         Linear = QUANTUM_BACKOFF_LINEAR,           ///< Linear backoff
         Exponential = QUANTUM_BACKOFF_EXPONENTIAL, ///< Exponential backoff (doubles every time)
         EqualStep = QUANTUM_BACKOFF_EQUALSTEP,     ///< Identical backoff amount
-        Random = QUANTUM_BACKOFF_RANDOM            ///< Random backoff amount
+        Random = QUANTUM_BACKOFF_RANDOM,           ///< Random backoff amount
+        Adaptive = QUANTUM_BACKOFF_ADAPTIVE        ///< Exponential backoff with per-lock limits learned
+                                                   ///< from recent acquisitions. See AdaptiveSpinLimits.
     };
     
     /// @brief Initial number of spins for the backoff
@@ -71,6 +74,46 @@ struct SpinLockTraits {
     static BackoffPolicy &backoffPolicy();
 };
 
+//==============================================================================
+//                              AdaptiveSpinLimits
+//==============================================================================
+/// @class AdaptiveSpinLimits
+/// @brief Per-lock spin and sleep limits used by the Adaptive backoff policy.
+/// @details Each contended acquisition reports how many spins it needed and how long it waited.
+///          The spin limit tracks a moving average of the spins which were needed to acquire
+///          the lock. Locks with short critical sections therefore spin briefly before yielding,
+///          and the limit grows towards SpinLockTraits::maxSpins() while the acquisitions keep
+///          exhausting it. It decays again once shorter spins suffice. When a thread eventually sleeps,
+///          the sleep duration is derived from the average wait time instead of the fixed
+///          SpinLockTraits::sleepDuration(), which is used as an upper bound.
+/// @note When any other backoff policy is selected, this object is ignored.
+class AdaptiveSpinLimits
+{
+public:
+    /// @brief Maximum number of spins before yielding.
+    /// @return A value between SpinLockTraits::minSpins() and SpinLockTraits::maxSpins().
+    size_t spinLimit() const;
+    
+    /// @brief Duration of a single sleep once the thread has exhausted its yields.
+    /// @return A value between 1us and SpinLockTraits::sleepDuration().
+    std::chrono::microseconds sleepDuration() const;
+    
+    /// @brief Updates the averages with a contended acquisition.
+    /// @param[in] spins Number of spins performed while acquiring.
+    /// @param[in] spinLimitReached True if spinning did not suffice and the thread had to yield or sleep.
+    /// @param[in] waitTime Total time spent acquiring.
+    void update(size_t spins,
+                bool spinLimitReached,
+                std::chrono::nanoseconds waitTime);
+    
+private:
+    static constexpr int fractionBits = 3;
+    static void average(std::atomic<int64_t>& scaledAverage, int64_t sample);
+    
+    std::atomic<int64_t>    _spins{0};      //moving average of the spins needed, scaled by 2^fractionBits
+    std::atomic<int64_t>    _waitTime{0};   //moving average of the wait time in ns, scaled by 2^fractionBits
+};
+
 //==============================================================================
 //                                  LockTraits
 //==============================================================================
@@ -34,6 +34,7 @@
 #include <thread>
 #include <pthread.h>
 #include <iostream>
+#include <string>
 
 namespace Bloomberg {
 namespace quantum {
@@ -53,7 +54,8 @@ public:
     TaskQueue();
 
     TaskQueue(const Configuration& configuration,
-              std::shared_ptr<TaskQueue> sharedQueue);
+              std::shared_ptr<TaskQueue> sharedQueue,
+              int queueId = (int)IQueue::QueueId::Any);
 
     TaskQueue(const TaskQueue& other);
 
@@ -128,6 +130,7 @@ private:
     void signalSharedQueueEmptyCondition(bool value);
     ProcessTaskResult processTask();
     WorkItem grabWorkItem();
+    static std::string lockName(const char* name, int queueId);
     void doEnqueue(ITask::Ptr task);
     ITask::Ptr doDequeue(std::atomic_bool& hint,
                          TaskListIter iter);
@@ -20,6 +20,7 @@
 #include <iterator>
 #include <type_traits>
 #include <vector>
+#include <unordered_map>
 #include <tuple>
 #include <memory>
 
@@ -54,6 +55,9 @@ struct Traits
     template <class IT>
     using IsInputIterator = std::enable_if_t<std::is_convertible<typename std::iterator_traits<IT>::iterator_category, std::input_iterator_tag>::value>;
     
+    template <class IT>
+    using IsRandomAccessIterator = std::enable_if_t<std::is_convertible<typename std::iterator_traits<IT>::iterator_category, std::random_access_iterator_tag>::value>;
+    
     //FUTURE BUFFER TRAIT
     template <class T>
     struct IsBuffer : std::false_type
@@ -89,10 +93,25 @@ struct Traits
     template <typename T>
     struct IsThreadPromise : std::false_type
     {};
+    
+    //Output container of a partitioned map-reduce. OUTPUT is either an associative container
+    //template such as std::map or std::unordered_map, or std::vector for a vector of pairs.
+    template <template <class...> class OUTPUT, class KEY, class VALUE>
+    struct MapReduceOutput
+    {
+        using Type = OUTPUT<KEY, VALUE>;
+        static void insert(Type& output, std::pair<KEY, VALUE>&& value) { output.emplace(std::move(value)); }
+    };
 };
 
 template <class T>
 struct Traits::InnerType<std::vector<T>> { using Type = T; };
+template <class KEY, class VALUE>
+struct Traits::MapReduceOutput<std::vector, KEY, VALUE>
+{
+    using Type = std::vector<std::pair<KEY, VALUE>>;
+    static void insert(Type& output, std::pair<KEY, VALUE>&& value) { output.emplace_back(std::move(value)); }
+};
 template <class T, class V>
 using BufferType = std::enable_if_t<Traits::IsBuffer<T>::value &&
                                     !std::is_same<std::decay_t<V>,T>::value &&
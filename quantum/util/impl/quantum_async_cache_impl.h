@@ -0,0 +1,288 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+
+#include <quantum/quantum_capture.h>
+#include <quantum/quantum_traits.h>
+#include <stdexcept>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                      class AsyncCache
+//==============================================================================================
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::AsyncCache(size_t maxSize,
+                                                    std::chrono::milliseconds timeToLive,
+                                                    size_t numShards)
+{
+    if (numShards == 0)
+    {
+        throw std::invalid_argument("AsyncCache requires at least one shard");
+    }
+    size_t capacity = (maxSize + numShards - 1) / numShards;
+    _shards.reserve(numShards);
+    for (size_t i = 0; i < numShards; ++i)
+    {
+        _shards.push_back(std::make_shared<Shard>(capacity, timeToLive));
+    }
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+template <class FUNC, class ... ARGS>
+VALUE
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::get(VoidContextPtr ctx,
+                                             const KEY& key,
+                                             FUNC&& loader,
+                                             ARGS&&... args)
+{
+    const ShardPtr& keyShard = shard(key);
+    PromisePtr<VALUE> promise;
+    if (keyShard->findOrInsert(key, promise))
+    {
+        auto capture = makeCapture<VALUE>(std::forward<FUNC>(loader), std::forward<ARGS>(args)...);
+        ctx->post(&AsyncCache::load<decltype(capture)>,
+                  ShardPtr(keyShard),
+                  KEY(key),
+                  PromisePtr<VALUE>(promise),
+                  std::move(capture));
+    }
+    //Every caller shares the promise so the value is copied out instead of being moved
+    return promise->getICoroFuture()->getRef(ctx);
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+template <class FUNC, class ... ARGS>
+VALUE
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::getAsyncIo(VoidContextPtr ctx,
+                                                    const KEY& key,
+                                                    FUNC&& loader,
+                                                    ARGS&&... args)
+{
+    const ShardPtr& keyShard = shard(key);
+    PromisePtr<VALUE> promise;
+    if (keyShard->findOrInsert(key, promise))
+    {
+        auto capture = makeCapture<VALUE>(std::forward<FUNC>(loader), std::forward<ARGS>(args)...);
+        ctx->postAsyncIo(&AsyncCache::loadAsyncIo<decltype(capture)>,
+                         ShardPtr(keyShard),
+                         KEY(key),
+                         PromisePtr<VALUE>(promise),
+                         std::move(capture));
+    }
+    //Every caller shares the promise so the value is copied out instead of being moved
+    return promise->getICoroFuture()->getRef(ctx);
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+bool
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::erase(const KEY& key)
+{
+    Shard& keyShard = *shard(key);
+    SpinLock::Guard lock(keyShard._spinlock);
+    auto it = keyShard._entries.find(key);
+    if (it == keyShard._entries.end())
+    {
+        return false;
+    }
+    keyShard.erase(it);
+    return true;
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+void
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::clear()
+{
+    for (auto&& keyShard : _shards)
+    {
+        SpinLock::Guard lock(keyShard->_spinlock);
+        keyShard->_entries.clear();
+        keyShard->_lru.clear();
+    }
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+size_t
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::size() const
+{
+    size_t num = 0;
+    for (auto&& keyShard : _shards)
+    {
+        SpinLock::Guard lock(keyShard->_spinlock);
+        num += keyShard->_entries.size();
+    }
+    return num;
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+const typename AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::ShardPtr&
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::shard(const KEY& key) const
+{
+    return _shards[_hash(key) % _shards.size()];
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+template <class LOADER>
+int
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::load(VoidContextPtr ctx,
+                                              ShardPtr shard,
+                                              KEY key,
+                                              PromisePtr<VALUE> promise,
+                                              LOADER loader)
+{
+    try
+    {
+        VALUE value = loader(ctx);
+        shard->loaded(key, promise, true);
+        return promise->set(ctx, std::move(value));
+    }
+    catch (const Traits::CoroutineStackUnwind&)
+    {
+        // quantum context switch
+        throw;
+    }
+    catch (...)
+    {
+        shard->loaded(key, promise, false);
+        return promise->setException(ctx, std::current_exception());
+    }
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+template <class LOADER>
+int
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::loadAsyncIo(ShardPtr shard,
+                                                     KEY key,
+                                                     PromisePtr<VALUE> promise,
+                                                     LOADER loader)
+{
+    try
+    {
+        VALUE value = loader();
+        shard->loaded(key, promise, true);
+        return promise->set(std::move(value));
+    }
+    catch (...)
+    {
+        shard->loaded(key, promise, false);
+        return promise->setException(std::current_exception());
+    }
+}
+
+//==============================================================================================
+//                                   class AsyncCache::Shard
+//==============================================================================================
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::Shard::Shard(size_t capacity,
+                                                      std::chrono::milliseconds timeToLive) :
+    _spinlock("AsyncCache::spinlock"),
+    _capacity(capacity),
+    _timeToLive(timeToLive)
+{
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+bool
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::Shard::findOrInsert(const KEY& key,
+                                                             PromisePtr<VALUE>& promise)
+{
+    SpinLock::Guard lock(_spinlock);
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        Entry& entry = it->second;
+        if (!entry._isLoaded ||
+            (_timeToLive == std::chrono::milliseconds::zero()) ||
+            (Clock::now() < entry._expiry))
+        {
+            //Cache hit or load in progress
+            _lru.splice(_lru.begin(), _lru, entry._lruPos);
+            promise = entry._promise;
+            return false;
+        }
+        erase(it); //expired
+    }
+    _lru.push_front(key);
+    Entry& entry = _entries[key];
+    entry._promise = PromisePtr<VALUE>(new Promise<VALUE>(), Promise<VALUE>::deleter);
+    entry._lruPos = _lru.begin();
+    promise = entry._promise;
+    evict();
+    return true;
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+void
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::Shard::loaded(const KEY& key,
+                                                       const PromisePtr<VALUE>& promise,
+                                                       bool succeeded)
+{
+    SpinLock::Guard lock(_spinlock);
+    auto it = _entries.find(key);
+    if ((it == _entries.end()) || (it->second._promise != promise))
+    {
+        return; //entry was erased or evicted while loading
+    }
+    if (succeeded)
+    {
+        it->second._isLoaded = true;
+        it->second._expiry = Clock::now() + _timeToLive;
+        evict(); //the shard may have grown past its capacity while loading
+    }
+    else
+    {
+        //do not cache failures
+        erase(it);
+    }
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+void
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::Shard::erase(typename Map::iterator it)
+{
+    _lru.erase(it->second._lruPos);
+    _entries.erase(it);
+}
+
+template <class KEY, class VALUE, class HASH, class KEY_EQUAL>
+void
+AsyncCache<KEY, VALUE, HASH, KEY_EQUAL>::Shard::evict()
+{
+    if (_capacity == 0)
+    {
+        return;
+    }
+    //Walk from the least recently used key, skipping the ones still loading since their
+    //callers rely on the entry to share a single load.
+    auto pos = _lru.end();
+    while ((_entries.size() > _capacity) && (pos != _lru.begin()))
+    {
+        --pos;
+        auto it = _entries.find(*pos);
+        if (it->second._isLoaded)
+        {
+            ++pos; //erasing only invalidates the current position
+            erase(it);
+        }
+    }
+}
+
+}}
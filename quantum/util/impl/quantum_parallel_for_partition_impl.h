@@ -0,0 +1,167 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+
+#include <quantum/quantum_spinlock.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                  class ParallelForPartition
+//==============================================================================================
+/// @class ParallelForPartition.
+/// @brief Splits the index range [0,num) of a parallelFor() into one sub-range per worker.
+///        Workers consume chunks from the front of their own sub-range and, once it is empty,
+///        steal the back half of the largest remaining sub-range.
+/// @note For internal use only.
+class ParallelForPartition
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] num Number of indexes to partition.
+    /// @param[in] numWorkers Number of workers. Each one initially owns an equal share of the indexes.
+    ParallelForPartition(size_t num, size_t numWorkers);
+
+    /// @brief Removes a chunk of indexes from the front of a worker's sub-range.
+    /// @param[in] worker The worker index.
+    /// @param[in] grainSize Maximum number of indexes to remove.
+    /// @param[out] begin First index of the chunk.
+    /// @param[out] end Last index of the chunk (exclusive).
+    /// @return True if a non-empty chunk was removed, false if the sub-range is empty or the
+    ///         partition was cancelled.
+    bool next(size_t worker, size_t grainSize, size_t& begin, size_t& end);
+
+    /// @brief Moves the back half of the largest other sub-range into the worker's own sub-range.
+    /// @param[in] worker The worker index. Its sub-range must be empty.
+    /// @return True if any indexes were stolen, false if all the sub-ranges are empty or the
+    ///         partition was cancelled.
+    bool steal(size_t worker);
+
+    /// @brief Stops handing out indexes to all workers.
+    void cancel();
+
+private:
+    struct Range
+    {
+        SpinLock                _spinlock;
+        // only modified under the spinlock but read without it when looking for a victim
+        std::atomic<size_t>     _begin{0};
+        std::atomic<size_t>     _end{0};
+    };
+
+    std::vector<Range>  _ranges;
+    std::atomic_bool    _isCancelled{false};
+};
+
+//==============================================================================================
+//                                  class ParallelForPartition
+//==============================================================================================
+inline
+ParallelForPartition::ParallelForPartition(size_t num, size_t numWorkers) :
+    _ranges(numWorkers)
+{
+    size_t numPerWorker = num/numWorkers;
+    size_t remainder = num%numWorkers;
+    size_t begin = 0;
+    for (size_t i = 0; i < numWorkers; ++i)
+    {
+        size_t end = begin + ((i < remainder) ? numPerWorker + 1 : numPerWorker);
+        _ranges[i]._begin = begin;
+        _ranges[i]._end = end;
+        begin = end;
+    }
+}
+
+inline
+bool ParallelForPartition::next(size_t worker, size_t grainSize, size_t& begin, size_t& end)
+{
+    if (_isCancelled.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    Range& range = _ranges[worker];
+    SpinLock::Guard lock(range._spinlock);
+    begin = range._begin.load(std::memory_order_relaxed);
+    end = range._end.load(std::memory_order_relaxed);
+    if (begin == end)
+    {
+        return false;
+    }
+    end = std::min(end, begin + grainSize);
+    range._begin.store(end, std::memory_order_relaxed);
+    return true;
+}
+
+inline
+bool ParallelForPartition::steal(size_t worker)
+{
+    while (!_isCancelled.load(std::memory_order_relaxed))
+    {
+        //pick the victim with the most remaining work
+        size_t victim = worker;
+        size_t victimSize = 0;
+        for (size_t i = 0; i < _ranges.size(); ++i)
+        {
+            size_t begin = _ranges[i]._begin.load(std::memory_order_relaxed);
+            size_t end = _ranges[i]._end.load(std::memory_order_relaxed);
+            if ((i != worker) && (end > begin) && (end - begin > victimSize))
+            {
+                victim = i;
+                victimSize = end - begin;
+            }
+        }
+        if (victimSize == 0)
+        {
+            return false;
+        }
+        size_t begin, end;
+        {
+            Range& range = _ranges[victim];
+            SpinLock::Guard lock(range._spinlock);
+            begin = range._begin.load(std::memory_order_relaxed);
+            end = range._end.load(std::memory_order_relaxed);
+            if (begin == end)
+            {
+                continue; //the victim finished in the meantime, look for another one
+            }
+            //round up so that a single remaining index can still be stolen from a busy worker
+            begin += (end - begin)/2;
+            range._end.store(begin, std::memory_order_relaxed);
+        }
+        Range& range = _ranges[worker];
+        SpinLock::Guard lock(range._spinlock);
+        range._begin.store(begin, std::memory_order_relaxed);
+        range._end.store(end, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+inline
+void ParallelForPartition::cancel()
+{
+    _isCancelled = true;
+}
+
+}}
@@ -22,33 +22,62 @@
 namespace Bloomberg {
 namespace quantum {
 
+inline
+SequenceKeyStatistics::Latencies::Latencies()
+{
+    for (size_t i = 0; i < numLatencyBuckets; ++i)
+    {
+        _waitTimes[i] = 0;
+        _runTimes[i] = 0;
+    }
+}
+
+inline
+SequenceKeyStatistics::Latencies::Latencies(const Latencies& that) :
+    _completedTaskCount(that._completedTaskCount.load()),
+    _totalWaitTime(that._totalWaitTime.load()),
+    _totalRunTime(that._totalRunTime.load()),
+    _maxWaitTime(that._maxWaitTime.load()),
+    _maxRunTime(that._maxRunTime.load())
+{
+    for (size_t i = 0; i < numLatencyBuckets; ++i)
+    {
+        _waitTimes[i] = that._waitTimes[i].load(std::memory_order_relaxed);
+        _runTimes[i] = that._runTimes[i].load(std::memory_order_relaxed);
+    }
+}
+
 inline
 SequenceKeyStatistics::SequenceKeyStatistics(const SequenceKeyStatistics& that) :
-    _postedTaskCount(that._postedTaskCount),
-    _pendingTaskCount(that._pendingTaskCount.load())
+    _postedTaskCount(that._postedTaskCount.load()),
+    _pendingTaskCount(that._pendingTaskCount.load()),
+    _latencies(that._latencies ? new Latencies(*that._latencies) : nullptr)
 {
 }
 
 inline
 SequenceKeyStatistics::SequenceKeyStatistics(SequenceKeyStatistics&& that) :
-    _postedTaskCount(std::move(that._postedTaskCount)),
-    _pendingTaskCount(that._pendingTaskCount.load())
+    _postedTaskCount(that._postedTaskCount.load()),
+    _pendingTaskCount(that._pendingTaskCount.load()),
+    _latencies(std::move(that._latencies))
 {
 }
 
 inline
 SequenceKeyStatistics& SequenceKeyStatistics::operator = (SequenceKeyStatistics&& that)
 {
-    _postedTaskCount = std::move(that._postedTaskCount);
+    _postedTaskCount = that._postedTaskCount.load();
     _pendingTaskCount = that._pendingTaskCount.load();
+    _latencies = std::move(that._latencies);
     return *this;
 }
 
 inline
 SequenceKeyStatistics& SequenceKeyStatistics::operator = (const SequenceKeyStatistics& that)
 {
-    _postedTaskCount = that._postedTaskCount;
-    _pendingTaskCount = _pendingTaskCount.load();
+    _postedTaskCount = that._postedTaskCount.load();
+    _pendingTaskCount = that._pendingTaskCount.load();
+    _latencies.reset(that._latencies ? new Latencies(*that._latencies) : nullptr);
     return *this;
 }
  
@@ -65,6 +94,72 @@ SequenceKeyStatistics::getPendingTaskCount() const
 {
     return _pendingTaskCount;
 }
+
+inline
+bool
+SequenceKeyStatistics::hasLatencyStatistics() const
+{
+    return _latencies != nullptr;
+}
+
+inline
+size_t
+SequenceKeyStatistics::getCompletedTaskCount() const
+{
+    return _latencies ? _latencies->_completedTaskCount.load() : 0;
+}
+
+inline
+SequenceKeyStatistics::LatencyHistogram
+SequenceKeyStatistics::getWaitTimeHistogram() const
+{
+    LatencyHistogram histogram{};
+    for (size_t i = 0; _latencies && (i < numLatencyBuckets); ++i)
+    {
+        histogram[i] = _latencies->_waitTimes[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+inline
+SequenceKeyStatistics::LatencyHistogram
+SequenceKeyStatistics::getRunTimeHistogram() const
+{
+    LatencyHistogram histogram{};
+    for (size_t i = 0; _latencies && (i < numLatencyBuckets); ++i)
+    {
+        histogram[i] = _latencies->_runTimes[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+inline
+std::chrono::nanoseconds
+SequenceKeyStatistics::getTotalWaitTime() const
+{
+    return std::chrono::nanoseconds(_latencies ? _latencies->_totalWaitTime.load() : 0);
+}
+
+inline
+std::chrono::nanoseconds
+SequenceKeyStatistics::getTotalRunTime() const
+{
+    return std::chrono::nanoseconds(_latencies ? _latencies->_totalRunTime.load() : 0);
+}
+
+inline
+std::chrono::nanoseconds
+SequenceKeyStatistics::getMaxWaitTime() const
+{
+    return std::chrono::nanoseconds(_latencies ? _latencies->_maxWaitTime.load() : 0);
+}
+
+inline
+std::chrono::nanoseconds
+SequenceKeyStatistics::getMaxRunTime() const
+{
+    return std::chrono::nanoseconds(_latencies ? _latencies->_maxRunTime.load() : 0);
+}
  
 inline
 void
@@ -86,5 +181,50 @@ SequenceKeyStatisticsWriter::decrementPendingTaskCount()
 {
     --_pendingTaskCount;
 }
+
+inline
+void
+SequenceKeyStatisticsWriter::enableLatencyStatistics()
+{
+    if (!_latencies)
+    {
+        _latencies.reset(new Latencies());
+    }
+}
+
+inline
+void
+SequenceKeyStatisticsWriter::recordTaskLatency(std::chrono::steady_clock::time_point enqueueTime,
+                                               std::chrono::steady_clock::time_point startTime,
+                                               std::chrono::steady_clock::time_point endTime)
+{
+    if (!_latencies)
+    {
+        return;
+    }
+    _latencies->_completedTaskCount.fetch_add(1, std::memory_order_relaxed);
+    record(startTime - enqueueTime, _latencies->_totalWaitTime, _latencies->_maxWaitTime, _latencies->_waitTimes);
+    record(endTime - startTime, _latencies->_totalRunTime, _latencies->_maxRunTime, _latencies->_runTimes);
+}
+
+inline
+void
+SequenceKeyStatisticsWriter::record(std::chrono::nanoseconds latency,
+                                    std::atomic<std::chrono::nanoseconds::rep>& total,
+                                    std::atomic<std::chrono::nanoseconds::rep>& max,
+                                    std::array<std::atomic_size_t, numLatencyBuckets>& histogram)
+{
+    std::chrono::nanoseconds::rep ns = latency.count();
+    total.fetch_add(ns, std::memory_order_relaxed);
+    std::chrono::nanoseconds::rep current = max.load(std::memory_order_relaxed);
+    while ((ns > current) && !max.compare_exchange_weak(current, ns, std::memory_order_relaxed));
+    //find the highest bit set
+    size_t bucket = 0;
+    for (; (ns > 1) && (bucket < numLatencyBuckets-1); ns >>= 1)
+    {
+        ++bucket;
+    }
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
  
 }}
@@ -0,0 +1,143 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: DO NOT INCLUDE DIRECTLY
+
+//##############################################################################################
+//#################################### IMPLEMENTATIONS #########################################
+//##############################################################################################
+
+#include <quantum/quantum_capture.h>
+#include <quantum/quantum_spinlock.h>
+#include <chrono>
+#include <deque>
+#include <memory>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                  class SequenceKeyTaskBatch
+//==============================================================================================
+/// @class SequenceKeyTaskBatch.
+/// @brief Queue of tasks with the same sequence key which run back-to-back inside a single coroutine.
+/// @note For internal use only. See SequencerConfiguration::setTaskBatchSize for more details.
+class SequenceKeyTaskBatch
+{
+public:
+    using TaskPtr = std::unique_ptr<Function<int(VoidContextPtr)>>;
+
+    /// @brief Constructor.
+    /// @param[in] queueId Queue id on which the batch runs.
+    /// @param[in] isHighPriority Priority with which the batch runs.
+    /// @param[in] maxSize Maximum number of tasks the batch accepts.
+    SequenceKeyTaskBatch(int queueId, bool isHighPriority, size_t maxSize);
+
+    /// @brief Adds a task to the batch.
+    /// @param[in] opaque Opaque data passed to the exception callback if the task throws.
+    /// @param[in] queueId Queue id requested for the task.
+    /// @param[in] isHighPriority Priority requested for the task.
+    /// @param[in] enqueueTime Time the task was enqueued to the sequencer.
+    /// @param[in,out] task The task. Only moved from if the batch accepts it.
+    /// @return True if the task was accepted, false if the batch is full, closed or runs with
+    ///         a different queue id or priority.
+    bool push(void* opaque,
+              int queueId,
+              bool isHighPriority,
+              std::chrono::steady_clock::time_point enqueueTime,
+              TaskPtr& task);
+
+    /// @brief Removes the next task from the batch.
+    /// @param[out] opaque Opaque data of the task.
+    /// @param[out] enqueueTime Time the task was enqueued to the sequencer.
+    /// @param[out] task The task.
+    /// @return True if a task was removed. If the batch is empty, it is closed and false is returned.
+    bool pop(void*& opaque, std::chrono::steady_clock::time_point& enqueueTime, TaskPtr& task);
+
+    /// @brief Stops accepting new tasks. Tasks already accepted remain in the batch.
+    void close();
+
+private:
+    struct Task
+    {
+        void*                                   _opaque;
+        std::chrono::steady_clock::time_point   _enqueueTime;
+        TaskPtr                                 _func;
+    };
+
+    SpinLock            _spinlock;
+    std::deque<Task>    _tasks;
+    int                 _queueId;
+    bool                _isHighPriority;
+    size_t              _maxSize;
+    size_t              _numAccepted{0};
+    bool                _isClosed{false};
+};
+
+//==============================================================================================
+//                                  class SequenceKeyTaskBatch
+//==============================================================================================
+inline
+SequenceKeyTaskBatch::SequenceKeyTaskBatch(int queueId, bool isHighPriority, size_t maxSize) :
+    _spinlock("Sequencer::taskBatchSpinlock"),
+    _queueId(queueId),
+    _isHighPriority(isHighPriority),
+    _maxSize(maxSize)
+{
+}
+
+inline
+bool SequenceKeyTaskBatch::push(void* opaque,
+                                int queueId,
+                                bool isHighPriority,
+                                std::chrono::steady_clock::time_point enqueueTime,
+                                TaskPtr& task)
+{
+    SpinLock::Guard lock(_spinlock);
+    if (_isClosed || (_numAccepted >= _maxSize) ||
+        (queueId != _queueId) || (isHighPriority != _isHighPriority))
+    {
+        return false;
+    }
+    _tasks.push_back(Task{opaque, enqueueTime, std::move(task)});
+    ++_numAccepted;
+    return true;
+}
+
+inline
+bool SequenceKeyTaskBatch::pop(void*& opaque, std::chrono::steady_clock::time_point& enqueueTime, TaskPtr& task)
+{
+    SpinLock::Guard lock(_spinlock);
+    if (_tasks.empty())
+    {
+        //subsequent tasks must be scheduled in a new batch
+        _isClosed = true;
+        return false;
+    }
+    opaque = _tasks.front()._opaque;
+    enqueueTime = _tasks.front()._enqueueTime;
+    task = std::move(_tasks.front()._func);
+    _tasks.pop_front();
+    return true;
+}
+
+inline
+void SequenceKeyTaskBatch::close()
+{
+    SpinLock::Guard lock(_spinlock);
+    _isClosed = true;
+}
+
+}}
@@ -43,6 +43,47 @@ SequencerConfigurationSchemaProvider::getJsonSchema()
             "bucketCount": {
                 "type": "number",
                 "default": 100
+            },
+            "stripeCount": {
+                "type": "number",
+                "default": 16
+            },
+            "idleKeyTimeoutMs": {
+                "type": "number",
+                "default": 0
+            },
+            "idleKeyEvictionStepSize": {
+                "type": "number",
+                "default": 8
+            },
+            "collectLatencyStatistics": {
+                "type": "boolean",
+                "default": false
+            },
+            "maxPendingTasksPerKey": {
+                "type": "number",
+                "default": 0
+            },
+            "pendingLimitPolicy": {
+                "type": "string",
+                "enum": [
+                    "reject",
+                    "block",
+                    "coalesce"
+                ],
+                "default": "reject"
+            },
+            "keyAffinity": {
+                "type": "boolean",
+                "default": false
+            },
+            "keyAffinityRebalanceThreshold": {
+                "type": "number",
+                "default": 0
+            },
+            "fairShareMaxRunningTasks": {
+                "type": "number",
+                "default": 0
             }
         },
         "additionalProperties": false,
@@ -74,6 +115,173 @@ SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getBucketCount()
     return _bucketCount;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setStripeCount(size_t stripeCount)
+{
+    _stripeCount = stripeCount;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getStripeCount() const
+{
+    return _stripeCount;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setIdleKeyTimeoutMs(std::chrono::milliseconds timeout)
+{
+    _idleKeyTimeoutMs = timeout;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::chrono::milliseconds
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getIdleKeyTimeoutMs() const
+{
+    return _idleKeyTimeoutMs;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setIdleKeyEvictionStepSize(size_t stepSize)
+{
+    _idleKeyEvictionStepSize = stepSize;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getIdleKeyEvictionStepSize() const
+{
+    return _idleKeyEvictionStepSize;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setCollectLatencyStatistics(bool value)
+{
+    _collectLatencyStatistics = value;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getCollectLatencyStatistics() const
+{
+    return _collectLatencyStatistics;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setMaxPendingTasksPerKey(size_t maxPendingTasks)
+{
+    _maxPendingTasksPerKey = maxPendingTasks;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getMaxPendingTasksPerKey() const
+{
+    return _maxPendingTasksPerKey;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setPendingLimitPolicy(SequencerPendingLimitPolicy policy)
+{
+    _pendingLimitPolicy = policy;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerPendingLimitPolicy
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getPendingLimitPolicy() const
+{
+    return _pendingLimitPolicy;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setKeyAffinity(bool value)
+{
+    _keyAffinity = value;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getKeyAffinity() const
+{
+    return _keyAffinity;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setKeyAffinityRebalanceThreshold(size_t threshold)
+{
+    _keyAffinityRebalanceThreshold = threshold;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getKeyAffinityRebalanceThreshold() const
+{
+    return _keyAffinityRebalanceThreshold;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setFairShareMaxRunningTasks(size_t maxRunningTasks)
+{
+    _fairShareMaxRunningTasks = maxRunningTasks;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getFairShareMaxRunningTasks() const
+{
+    return _fairShareMaxRunningTasks;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setFairShareGroupFunction(
+    const FairShareGroupFunction& groupFunction)
+{
+    _fairShareGroupFunction = groupFunction;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+const typename SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::FairShareGroupFunction&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getFairShareGroupFunction() const
+{
+    return _fairShareGroupFunction;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setFairShareWeightFunction(
+    const FairShareWeightFunction& weightFunction)
+{
+    _fairShareWeightFunction = weightFunction;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+const typename SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::FairShareWeightFunction&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getFairShareWeightFunction() const
+{
+    return _fairShareWeightFunction;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
 SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setHash(const Hash& hash)
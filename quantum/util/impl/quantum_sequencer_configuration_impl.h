@@ -21,18 +21,26 @@
 
 #include <quantum/util/quantum_sequence_key_statistics.h>
 #include <quantum/interface/quantum_icoro_context_base.h>
+#include <quantum/interface/quantum_iqueue.h>
 
 namespace Bloomberg {
 namespace quantum {
 
+class SequenceKeyTaskBatch;
+
 using StatsPtr = std::shared_ptr<SequenceKeyStatisticsWriter>;
+using TaskBatchPtr = std::shared_ptr<SequenceKeyTaskBatch>;
 struct SequenceKeyData
 {
     SequenceKeyData() :
-        _stats(std::make_shared<SequenceKeyStatisticsWriter>())
+        _stats(std::make_shared<SequenceKeyStatisticsWriter>()),
+        _queueId((int)IQueue::QueueId::Any)
     {}
     ICoroContextBasePtr _context;
     StatsPtr            _stats;
+    TaskBatchPtr        _batch;
+    std::chrono::steady_clock::time_point _lastUsed; // only maintained when idle keys are evicted
+    int                 _queueId; // the coroutine queue of the key (key affinity only)
 };
 
 inline const std::string&
@@ -49,9 +57,54 @@ SequencerConfigurationSchemaProvider::getJsonSchema()
                 "type": "number",
                 "default": 0
             },
+            "numControlQueues": {
+                "type": "number",
+                "default": 1
+            },
             "bucketCount": {
                 "type": "number",
                 "default": 100
+            },
+            "taskBatchSize": {
+                "type": "number",
+                "default": 1
+            },
+            "taskBatchTimeSliceMs": {
+                "type": "number",
+                "default": 0
+            },
+            "idleKeyTimeoutMs": {
+                "type": "number",
+                "default": 0
+            },
+            "idleKeyEvictionStepSize": {
+                "type": "number",
+                "default": 8
+            },
+            "collectLatencyStatistics": {
+                "type": "boolean",
+                "default": false
+            },
+            "maxPendingTasksPerKey": {
+                "type": "number",
+                "default": 0
+            },
+            "pendingLimitPolicy": {
+                "type": "string",
+                "enum": [
+                    "reject",
+                    "block",
+                    "coalesce"
+                ],
+                "default": "reject"
+            },
+            "keyAffinity": {
+                "type": "boolean",
+                "default": false
+            },
+            "keyAffinityRebalanceThreshold": {
+                "type": "number",
+                "default": 0
             }
         },
         "additionalProperties": false,
@@ -83,6 +136,156 @@ SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getControlQueueI
     return _controllerQueueId;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setNumControlQueues(size_t numControlQueues)
+{
+    _numControllerQueues = numControlQueues;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getNumControlQueues() const
+{
+    return _numControllerQueues;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setTaskBatchSize(size_t taskBatchSize)
+{
+    _taskBatchSize = taskBatchSize;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getTaskBatchSize() const
+{
+    return _taskBatchSize;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setTaskBatchTimeSliceMs(std::chrono::milliseconds timeSlice)
+{
+    _taskBatchTimeSliceMs = timeSlice;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::chrono::milliseconds
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getTaskBatchTimeSliceMs() const
+{
+    return _taskBatchTimeSliceMs;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setIdleKeyTimeoutMs(std::chrono::milliseconds timeout)
+{
+    _idleKeyTimeoutMs = timeout;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::chrono::milliseconds
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getIdleKeyTimeoutMs() const
+{
+    return _idleKeyTimeoutMs;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setIdleKeyEvictionStepSize(size_t stepSize)
+{
+    _idleKeyEvictionStepSize = stepSize;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getIdleKeyEvictionStepSize() const
+{
+    return _idleKeyEvictionStepSize;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setCollectLatencyStatistics(bool value)
+{
+    _collectLatencyStatistics = value;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getCollectLatencyStatistics() const
+{
+    return _collectLatencyStatistics;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setMaxPendingTasksPerKey(size_t maxPendingTasks)
+{
+    _maxPendingTasksPerKey = maxPendingTasks;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getMaxPendingTasksPerKey() const
+{
+    return _maxPendingTasksPerKey;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setPendingLimitPolicy(SequencerPendingLimitPolicy policy)
+{
+    _pendingLimitPolicy = policy;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerPendingLimitPolicy
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getPendingLimitPolicy() const
+{
+    return _pendingLimitPolicy;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setKeyAffinity(bool value)
+{
+    _keyAffinity = value;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getKeyAffinity() const
+{
+    return _keyAffinity;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setKeyAffinityRebalanceThreshold(size_t threshold)
+{
+    _keyAffinityRebalanceThreshold = threshold;
+    return *this;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::getKeyAffinityRebalanceThreshold() const
+{
+    return _keyAffinityRebalanceThreshold;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>&
 SequencerConfiguration<SequenceKey, Hash, KeyEqual, Allocator>::setBucketCount(size_t bucketCount)
@@ -25,7 +25,9 @@
 #include <quantum/quantum_traits.h>
 #include <quantum/impl/quantum_stl_impl.h>
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
 #include <stdexcept>
 #include <unordered_set>
 
@@ -38,13 +40,85 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Sequencer(Dispatcher& dispatc
     const typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Configuration& configuration) :
     _dispatcher(dispatcher),
     _drain(false),
-    _pendingTaskQueueMap(configuration.getBucketCount(),
-              configuration.getHash(),
-              configuration.getKeyEqual(),
-              configuration.getAllocator()),
+    _hash(configuration.getHash()),
+    _idleKeyTimeout(configuration.getIdleKeyTimeoutMs()),
+    _idleKeyEvictionStepSize(configuration.getIdleKeyEvictionStepSize()),
+    _collectLatencyStatistics(configuration.getCollectLatencyStatistics()),
+    _maxPendingTasksPerKey(configuration.getMaxPendingTasksPerKey()),
+    _pendingLimitPolicy(configuration.getPendingLimitPolicy()),
+    _keyAffinity(configuration.getKeyAffinity()),
+    _keyAffinityRebalanceThreshold(configuration.getKeyAffinityRebalanceThreshold()),
+    _fairShareMaxRunningTasks(configuration.getFairShareMaxRunningTasks()),
+    _fairShareGroupFunction(configuration.getFairShareGroupFunction()),
+    _fairShareWeightFunction(configuration.getFairShareWeightFunction()),
+    _fairShareSpinlock("experimental::Sequencer::fairShareSpinlock"),
+    _numRunningFairShareTasks(0),
     _exceptionCallback(configuration.getExceptionCallback()),
     _taskStats(std::make_shared<SequenceKeyStatisticsWriter>())
 {
+    if (_collectLatencyStatistics)
+    {
+        _universalTaskQueue._stats->enableLatencyStatistics();
+        _taskStats->enableLatencyStatistics();
+    }
+    size_t stripeCount = configuration.getStripeCount();
+    if (stripeCount == 0)
+    {
+        throw std::invalid_argument("Sequencer requires at least one stripe");
+    }
+    if (_idleKeyTimeout > std::chrono::milliseconds::zero() && _idleKeyEvictionStepSize == 0)
+    {
+        throw std::invalid_argument("Sequencer requires an idleKeyEvictionStepSize of at least 1 to evict idle keys");
+    }
+    size_t bucketCount = (configuration.getBucketCount() + stripeCount - 1) / stripeCount;
+    _stripes.reserve(stripeCount);
+    _allStripes.reserve(stripeCount);
+    for (size_t i = 0; i < stripeCount; ++i)
+    {
+        _stripes.emplace_back(new Stripe(configuration, bucketCount));
+        _allStripes.push_back(i);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Stripe::Stripe(const Configuration& configuration,
+                                                         size_t bucketCount) :
+    _mutex("experimental::Sequencer::stripeMutex"),
+    _pendingTaskQueueMap(bucketCount,
+                         configuration.getHash(),
+                         configuration.getKeyEqual(),
+                         configuration.getAllocator())
+{
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::StripeGuard::StripeGuard(VoidContextPtr ctx,
+                                                                   Sequencer& sequencer,
+                                                                   const std::vector<size_t>& stripes) :
+    _sequencer(sequencer),
+    _stripes(stripes)
+{
+    // always lock in the same order to avoid deadlocks between tasks sharing several stripes
+    for (size_t stripe : _stripes)
+    {
+        _sequencer._stripes[stripe]->_mutex.lock(ctx);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::StripeGuard::~StripeGuard()
+{
+    for (auto it = _stripes.rbegin(); it != _stripes.rend(); ++it)
+    {
+        _sequencer._stripes[*it]->_mutex.unlock();
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getStripeIndex(const SequenceKey& key) const
+{
+    return _stripes.size() == 1 ? 0 : _hash(key) % _stripes.size();
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -67,13 +141,21 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::addPendingTask(
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 bool
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::addPendingTask(
+    Stripe& stripe,
     const SequenceKey& key,
     const std::shared_ptr<SequencerTask<SequenceKey>>& task)
 {
-    typename PendingTaskQueueMap::iterator it = _pendingTaskQueueMap.find(key);
-    if (it == _pendingTaskQueueMap.end())
+    PendingTaskQueueMap& pendingTaskQueueMap = stripe._pendingTaskQueueMap;
+    typename PendingTaskQueueMap::iterator it = pendingTaskQueueMap.find(key);
+    if (it == pendingTaskQueueMap.end())
     {
-        it = _pendingTaskQueueMap.emplace(key, SequencerKeyData<SequenceKey>()).first;
+        // the universal queue can only change while all the stripes are locked
+        it = pendingTaskQueueMap.emplace(key, SequencerKeyData<SequenceKey>()).first;
+        it->second._key = &it->first;
+        if (_collectLatencyStatistics)
+        {
+            it->second._stats->enableLatencyStatistics();
+        }
         // add each universal task to this queue before the task
         bool first = true;
         for(auto& universalTask : _universalTaskQueue._tasks)
@@ -142,15 +224,29 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::removeCompletedAndScheduleNex
     VoidContextPtr ctx,
     const std::shared_ptr<SequencerTask<SequenceKey>>& task)
 {
-    Mutex::Guard lock(ctx, _mutex);
+    bool isEvictionEnabled = _idleKeyTimeout > std::chrono::milliseconds::zero();
+    std::chrono::steady_clock::time_point now;
+    if (isEvictionEnabled)
+    {
+        now = std::chrono::steady_clock::now();
+    }
     if (task->_universal)
     {
+        StripeGuard lock(ctx, *this, _allStripes);
         // remove the task from all key queues
-        for(auto& item : _pendingTaskQueueMap)
+        for(auto& stripe : _stripes)
         {
-            if (auto nextTask = removeCompleted(item.second, task))
+            for(auto& item : stripe->_pendingTaskQueueMap)
             {
-                scheduleTask(nextTask);
+                bool wasIdle = item.second._tasks.empty();
+                if (auto nextTask = removeCompleted(item.second, task))
+                {
+                    scheduleTask(nextTask);
+                }
+                else if (isEvictionEnabled and not wasIdle and item.second._tasks.empty())
+                {
+                    trackIdleKey(item.second, now);
+                }
             }
         }
 
@@ -159,9 +255,18 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::removeCompletedAndScheduleNex
         {
             scheduleTask(nextTask);
         }
+
+        if (isEvictionEnabled)
+        {
+            for(auto& stripe : _stripes)
+            {
+                evictIdleKeys(*stripe, now);
+            }
+        }
     }
     else
     {
+        StripeGuard lock(ctx, *this, task->_stripes);
         // remove the task from its key queues only
         for(SequencerKeyData<SequenceKey>* data : task->_keyData)
         {
@@ -169,10 +274,173 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::removeCompletedAndScheduleNex
             {
                 scheduleTask(nextTask);
             }
+            else if (isEvictionEnabled and data->_tasks.empty())
+            {
+                trackIdleKey(*data, now);
+            }
+        }
+
+        if (isEvictionEnabled)
+        {
+            for(size_t stripe : task->_stripes)
+            {
+                evictIdleKeys(*_stripes[stripe], now);
+            }
+        }
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::trackIdleKey(
+    SequencerKeyData<SequenceKey>& data,
+    std::chrono::steady_clock::time_point now)
+{
+    data._idleSince = now;
+    if (not data._isIdleTracked)
+    {
+        data._isIdleTracked = true;
+        _stripes[getStripeIndex(*data._key)]->_idleKeys.emplace_back(*data._key, now);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::evictIdleKeys(
+    Stripe& stripe,
+    std::chrono::steady_clock::time_point now)
+{
+    // Each key has at most one record, which is only refreshed when it reaches the front of the queue,
+    // so the amount of work is bounded by the step size regardless of how often the keys are used.
+    IdleKeyQueue& idleKeys = stripe._idleKeys;
+    for(size_t i = 0; (i < _idleKeyEvictionStepSize) and not idleKeys.empty(); ++i)
+    {
+        typename IdleKeyQueue::value_type& record = idleKeys.front();
+        if (now - record.second < _idleKeyTimeout)
+        {
+            // the records behind were mostly queued later
+            break;
+        }
+        typename PendingTaskQueueMap::iterator it = stripe._pendingTaskQueueMap.find(record.first);
+        if (it != stripe._pendingTaskQueueMap.end())
+        {
+            SequencerKeyData<SequenceKey>& data = it->second;
+            if (not data._tasks.empty())
+            {
+                // busy again: the key is queued anew once its task queue becomes empty
+                data._isIdleTracked = false;
+            }
+            else if (now - data._idleSince < _idleKeyTimeout)
+            {
+                // used since it was queued: check again once it may have been idle long enough
+                idleKeys.emplace_back(std::move(record.first), data._idleSince);
+            }
+            else
+            {
+                stripe._pendingTaskQueueMap.erase(it);
+            }
         }
+        idleKeys.pop_front();
     }
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getAffinityQueueId(
+    SequencerKeyData<SequenceKey>& data,
+    bool isIdle)
+{
+    const std::pair<int, int>& range = _dispatcher.getCoroQueueIdRangeForAny();
+    if (data._queueId == (int)IQueue::QueueId::Any)
+    {
+        data._queueId = range.first + (int)(_hash(*data._key) % (size_t)(range.second - range.first + 1));
+    }
+    // A key only moves while it has no other task pending or running, otherwise its task would be
+    // posted to a cold queue right after its predecessor ran on the old one.
+    if (isIdle and
+        _keyAffinityRebalanceThreshold > 0 and
+        _dispatcher.size(IQueue::QueueType::Coro, data._queueId) > _keyAffinityRebalanceThreshold)
+    {
+        size_t minSize = _dispatcher.size(IQueue::QueueType::Coro, range.first);
+        data._queueId = range.first;
+        for(int queueId = range.first + 1; queueId <= range.second and minSize > 0; ++queueId)
+        {
+            size_t size = _dispatcher.size(IQueue::QueueType::Coro, queueId);
+            if (size < minSize)
+            {
+                data._queueId = queueId;
+                minSize = size;
+            }
+        }
+    }
+    return data._queueId;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::chrono::steady_clock::time_point
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getCurrentTime() const
+{
+    // the clock is only read when the latencies are recorded
+    return _collectLatencyStatistics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::recordTaskLatency(
+    const SequencerTask<SequenceKey>& task,
+    std::chrono::steady_clock::time_point startTime,
+    std::chrono::steady_clock::time_point endTime)
+{
+    if (not _collectLatencyStatistics)
+    {
+        return;
+    }
+    // the key data cannot be evicted or trimmed while the task is still in its queues
+    if (task._universal)
+    {
+        _universalTaskQueue._stats->recordTaskLatency(task._enqueueTime, startTime, endTime);
+    }
+    else
+    {
+        for(SequencerKeyData<SequenceKey>* keyData : task._keyData)
+        {
+            keyData->_stats->recordTaskLatency(task._enqueueTime, startTime, endTime);
+        }
+    }
+    _taskStats->recordTaskLatency(task._enqueueTime, startTime, endTime);
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::KeyStatisticsList
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::findSlowestSequenceKeys(const Stripe& stripe,
+                                                                           size_t count)
+{
+    // rank the keys on a snapshot of their total run time and only copy the statistics of the slowest ones
+    using RankedKey = std::pair<std::chrono::nanoseconds, typename PendingTaskQueueMap::const_iterator>;
+    std::vector<RankedKey> rankedKeys;
+    rankedKeys.reserve(stripe._pendingTaskQueueMap.size());
+    for(auto it = stripe._pendingTaskQueueMap.begin(); it != stripe._pendingTaskQueueMap.end(); ++it)
+    {
+        if (it->second._stats->getCompletedTaskCount() > 0)
+        {
+            rankedKeys.emplace_back(it->second._stats->getTotalRunTime(), it);
+        }
+    }
+    count = std::min(count, rankedKeys.size());
+    std::partial_sort(rankedKeys.begin(), rankedKeys.begin() + count, rankedKeys.end(),
+                      [](const RankedKey& lhs, const RankedKey& rhs)->bool
+                      {
+                          return lhs.first > rhs.first;
+                      });
+    KeyStatisticsList slowestKeys;
+    slowestKeys.reserve(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        slowestKeys.emplace_back(rankedKeys[i].second->first, *rankedKeys[i].second->second._stats);
+    }
+    return slowestKeys;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 int
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::executePending(
@@ -185,6 +453,7 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::executePending(
     // dispatcher as a coroutine function, but dispatcher.post(...) doesn't support
     // results of std::bind(...)
     int rc = -1;
+    std::chrono::steady_clock::time_point startTime = sequencer->getCurrentTime();
     try
     {
         rc = task->_func(ctx);
@@ -202,11 +471,58 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::executePending(
         }
     }
 
+    sequencer->recordTaskLatency(*task, startTime, sequencer->getCurrentTime());
+    if (task->_fairShareWeight > 0)
+    {
+        // the slot goes to the next group in the round before the next task of this key becomes ready
+        sequencer->releaseFairShareSlot();
+    }
     // remove the task from the pending queues + schedule next tasks
     sequencer->removeCompletedAndScheduleNext(ctx, task);
+    // The drainers may destroy the sequencer as soon as they are released, hence the promises are only
+    // set after the task is removed and all the stripes are unlocked. The sequencer is not accessed after this.
+    for(const std::shared_ptr<Promise<int>>& drainPromise : task->_drainPromises)
+    {
+        drainPromise->set(ctx, 0);
+    }
     return rc;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerEnqueueStatus
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::applyPendingLimit(
+    Stripe& stripe,
+    const SequenceKey& key,
+    SequencerTask<SequenceKey>& task)
+{
+    if (_maxPendingTasksPerKey == 0)
+    {
+        return SequencerEnqueueStatus::Enqueued;
+    }
+    typename PendingTaskQueueMap::iterator it = stripe._pendingTaskQueueMap.find(key);
+    if (it == stripe._pendingTaskQueueMap.end() or
+        it->second._stats->getPendingTaskCount() < _maxPendingTasksPerKey)
+    {
+        return SequencerEnqueueStatus::Enqueued;
+    }
+    if (_pendingLimitPolicy != SequencerPendingLimitPolicy::Coalesce)
+    {
+        return SequencerEnqueueStatus::Rejected;
+    }
+    // A single-key task which is not at the head of its queue cannot be scheduled while the stripe is locked,
+    // so its function can be replaced safely. Tasks with other keys may be scheduled from other stripes.
+    const std::list<std::shared_ptr<SequencerTask<SequenceKey>>>& tasks = it->second._tasks;
+    if (tasks.size() > 1 and
+        not tasks.back()->_universal and
+        tasks.back()->_keyData.size() == 1)
+    {
+        tasks.back()->_func = std::move(task._func);
+        tasks.back()->_opaque = task._opaque;
+        return SequencerEnqueueStatus::Coalesced;
+    }
+    return SequencerEnqueueStatus::Enqueued;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 void
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::scheduleTask(
@@ -225,6 +541,21 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::scheduleTask(
     }
     _taskStats->decrementPendingTaskCount();
 
+    if (task->_fairShareWeight > 0)
+    {
+        addFairShareTask(task);
+    }
+    else
+    {
+        postTask(task);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::postTask(
+    const std::shared_ptr<SequencerTask<SequenceKey>>& task)
+{
     _dispatcher.post(
         task->_queueId,
         task->_isHighPriority,
@@ -234,17 +565,99 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::scheduleTask(
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
-template <class FUNC, class ... ARGS>
 void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::addFairShareTask(
+    const std::shared_ptr<SequencerTask<SequenceKey>>& task)
+{
+    {
+        SpinLock::Guard lock(_fairShareSpinlock);
+        typename FairShareFlowMap::iterator it = _fairShareFlows.find(task->_fairShareGroup);
+        if (it == _fairShareFlows.end())
+        {
+            // the group joins the round behind the groups which already have ready tasks
+            it = _fairShareFlows.emplace(task->_fairShareGroup, FairShareFlow()).first;
+            _activeFairShareGroups.push_back(task->_fairShareGroup);
+        }
+        it->second._readyTasks.push_back(task);
+    }
+    postFairShareTasks();
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::releaseFairShareSlot()
+{
+    {
+        SpinLock::Guard lock(_fairShareSpinlock);
+        --_numRunningFairShareTasks;
+    }
+    postFairShareTasks();
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::postFairShareTasks()
+{
+    while (true)
+    {
+        std::shared_ptr<SequencerTask<SequenceKey>> task;
+        {
+            SpinLock::Guard lock(_fairShareSpinlock);
+            task = popFairShareTask();
+        }
+        if (not task)
+        {
+            return;
+        }
+        postTask(task);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::shared_ptr<SequencerTask<SequenceKey>>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::popFairShareTask()
+{
+    if (_numRunningFairShareTasks >= _fairShareMaxRunningTasks or _activeFairShareGroups.empty())
+    {
+        return nullptr;
+    }
+    typename FairShareFlowMap::iterator it = _fairShareFlows.find(_activeFairShareGroups.front());
+    FairShareFlow& flow = it->second;
+    if (flow._deficit == 0)
+    {
+        // the group starts its turn: all the tasks cost the same, so the quantum is the weight
+        flow._deficit = flow._readyTasks.front()->_fairShareWeight;
+    }
+    std::shared_ptr<SequencerTask<SequenceKey>> task = std::move(flow._readyTasks.front());
+    flow._readyTasks.pop_front();
+    --flow._deficit;
+    ++_numRunningFairShareTasks;
+    if (flow._readyTasks.empty())
+    {
+        // a group leaves the round with its ready tasks, and its unused deficit is dropped
+        _fairShareFlows.erase(it);
+        _activeFairShareGroups.pop_front();
+    }
+    else if (flow._deficit == 0)
+    {
+        _activeFairShareGroups.push_back(_activeFairShareGroups.front());
+        _activeFairShareGroups.pop_front();
+    }
+    return task;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC, class ... ARGS>
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args)
 {
-    enqueueSingle(nullptr, (int)IQueue::QueueId::Any, false, sequenceKey, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    return enqueueSingle(nullptr, (int)IQueue::QueueId::Any, false, sequenceKey, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     void* opaque,
     int queueId,
@@ -253,12 +666,12 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     FUNC&& func,
     ARGS&&... args)
 {
-    enqueueSingle(opaque, queueId, isHighPriority, sequenceKey, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    return enqueueSingle(opaque, queueId, isHighPriority, sequenceKey, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueSingle(
     void* opaque,
     int queueId,
@@ -282,33 +695,63 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueSingle(
         false,
         opaque,
         queueId,
-        isHighPriority);
-
-    Mutex::Guard lock(local::context(), _mutex);
-
-    _taskStats->incrementPostedTaskCount();
-    _taskStats->incrementPendingTaskCount();
+        isHighPriority,
+        getCurrentTime());
+    task->_stripes.push_back(getStripeIndex(sequenceKey));
+    if (_fairShareMaxRunningTasks > 0)
+    {
+        task->_fairShareGroup = _fairShareGroupFunction ? _fairShareGroupFunction(sequenceKey) : _hash(sequenceKey);
+        task->_fairShareWeight = std::max<size_t>(1, _fairShareWeightFunction ? _fairShareWeightFunction(task->_fairShareGroup) : 1);
+    }
 
-    if (addPendingTask(sequenceKey, task))
+    Stripe& stripe = *_stripes[task->_stripes.front()];
+    VoidContextPtr ctx = local::context();
+    while (true)
     {
-        scheduleTask(task);
+        {
+            Mutex::Guard lock(ctx, stripe._mutex);
+            SequencerEnqueueStatus status = applyPendingLimit(stripe, sequenceKey, *task);
+            if (status == SequencerEnqueueStatus::Enqueued)
+            {
+                _taskStats->incrementPostedTaskCount();
+                _taskStats->incrementPendingTaskCount();
+                bool isReady = addPendingTask(stripe, sequenceKey, task);
+                if (_keyAffinity and task->_queueId == (int)IQueue::QueueId::Any)
+                {
+                    task->_queueId = getAffinityQueueId(*task->_keyData.front(), isReady);
+                }
+                if (isReady)
+                {
+                    scheduleTask(task);
+                }
+                return status;
+            }
+            if (status == SequencerEnqueueStatus::Coalesced or
+                _pendingLimitPolicy != SequencerPendingLimitPolicy::Block)
+            {
+                return status;
+            }
+        }
+        // let the pending tasks of the key get scheduled before checking the limit again
+        quantum::yield(ctx);
     }
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     const std::vector<SequenceKey>& sequenceKeys,
     FUNC&& func,
     ARGS&&... args)
 {
     enqueueMultiple(nullptr, (int)IQueue::QueueId::Any, false, sequenceKeys, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    return SequencerEnqueueStatus::Enqueued;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     void* opaque,
     int queueId,
@@ -318,6 +761,7 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     ARGS&&... args)
 {
     enqueueMultiple(opaque, queueId, isHighPriority, sequenceKeys, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    return SequencerEnqueueStatus::Enqueued;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -345,19 +789,27 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueMultiple(
         false,
         opaque,
         queueId,
-        isHighPriority);
+        isHighPriority,
+        getCurrentTime());
 
-    Mutex::Guard lock(local::context(), _mutex);
+    std::unordered_set<SequenceKey, Hash, KeyEqual> uniqueKeys{ sequenceKeys.begin(),
+                                                                sequenceKeys.end() };
+    for(const SequenceKey& sequenceKey : uniqueKeys)
+    {
+        task->_stripes.push_back(getStripeIndex(sequenceKey));
+    }
+    std::sort(task->_stripes.begin(), task->_stripes.end());
+    task->_stripes.erase(std::unique(task->_stripes.begin(), task->_stripes.end()), task->_stripes.end());
 
     _taskStats->incrementPostedTaskCount();
     _taskStats->incrementPendingTaskCount();
 
+    // all the stripes are locked together so that tasks sharing keys are queued in the same relative order
+    StripeGuard lock(local::context(), *this, task->_stripes);
     bool canSchedule = true;
-    std::unordered_set<SequenceKey, Hash, KeyEqual> uniqueKeys{ sequenceKeys.begin(),
-                                                                sequenceKeys.end() };
     for(const SequenceKey& sequenceKey : uniqueKeys)
     {
-        if (not addPendingTask(sequenceKey, task))
+        if (not addPendingTask(*_stripes[getStripeIndex(sequenceKey)], sequenceKey, task))
         {
             canSchedule = false;
         }
@@ -408,24 +860,33 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueAllImpl(
         throw std::out_of_range(std::string{"Invalid IO queue id: "} + std::to_string(queueId));
     }
 
-    auto task = std::make_shared<SequencerTask<SequenceKey>>(
+    enqueueUniversalTask(std::make_shared<SequencerTask<SequenceKey>>(
         makeCapture<int>(std::forward<FUNC>(func), std::forward<ARGS>(args)...),
         true,
         opaque,
         queueId,
-        isHighPriority);
-
-    Mutex::Guard lock(local::context(), _mutex);
+        isHighPriority,
+        getCurrentTime()));
+}
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueUniversalTask(
+    const std::shared_ptr<SequencerTask<SequenceKey>>& task)
+{
     _taskStats->incrementPostedTaskCount();
     _taskStats->incrementPendingTaskCount();
 
+    StripeGuard lock(local::context(), *this, _allStripes);
     bool canSchedule = addPendingTask(task);
-    for(const auto& pendingItem : _pendingTaskQueueMap)
+    for(auto& stripe : _stripes)
     {
-        if (not addPendingTask(pendingItem.first, task))
+        for(const auto& pendingItem : stripe->_pendingTaskQueueMap)
         {
-            canSchedule = false;
+            if (not addPendingTask(*stripe, pendingItem.first, task))
+            {
+                canSchedule = false;
+            }
         }
     }
     if (canSchedule)
@@ -438,24 +899,36 @@ template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 size_t
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::trimSequenceKeys()
 {
-    Mutex::Guard lock(local::context(), _mutex);
-    for(typename PendingTaskQueueMap::iterator it = _pendingTaskQueueMap.begin(); it != _pendingTaskQueueMap.end(); )
+    size_t keyCount = 0;
+    for(auto& stripe : _stripes)
     {
-        if (it->second._tasks.empty())
-            it = _pendingTaskQueueMap.erase(it);
-        else
-            ++it;
+        PendingTaskQueueMap& pendingTaskQueueMap = stripe->_pendingTaskQueueMap;
+        Mutex::Guard lock(local::context(), stripe->_mutex);
+        for(typename PendingTaskQueueMap::iterator it = pendingTaskQueueMap.begin(); it != pendingTaskQueueMap.end(); )
+        {
+            if (it->second._tasks.empty())
+                it = pendingTaskQueueMap.erase(it);
+            else
+            {
+                // the key is queued for idle eviction again once its task queue becomes empty
+                it->second._isIdleTracked = false;
+                ++it;
+            }
+        }
+        stripe->_idleKeys.clear();
+        keyCount += pendingTaskQueueMap.size();
     }
-    return _pendingTaskQueueMap.size();
+    return keyCount;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequenceKeyStatistics
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getStatistics(const SequenceKey& sequenceKey)
 {
-    Mutex::Guard lock(local::context(), _mutex);
-    typename PendingTaskQueueMap::const_iterator it = _pendingTaskQueueMap.find(sequenceKey);
-    if (it == _pendingTaskQueueMap.end())
+    Stripe& stripe = *_stripes[getStripeIndex(sequenceKey)];
+    Mutex::Guard lock(local::context(), stripe._mutex);
+    typename PendingTaskQueueMap::const_iterator it = stripe._pendingTaskQueueMap.find(sequenceKey);
+    if (it == stripe._pendingTaskQueueMap.end())
         return SequenceKeyStatistics();
     return *it->second._stats;
 }
@@ -464,7 +937,7 @@ template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequenceKeyStatistics
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getStatistics()
 {
-    Mutex::Guard lock(local::context(), _mutex);
+    // the statistics counters are atomic and the universal queue itself is not accessed
     return *_universalTaskQueue._stats;
 }
 
@@ -475,12 +948,49 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getTaskStatistics()
     return *_taskStats;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::vector<std::pair<SequenceKey, SequenceKeyStatistics>>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getSlowestSequenceKeys(size_t count)
+{
+    KeyStatisticsList slowestKeys;
+    if (not _collectLatencyStatistics or count == 0)
+    {
+        return slowestKeys;
+    }
+    for(auto& stripe : _stripes)
+    {
+        KeyStatisticsList stripeKeys;
+        {
+            Mutex::Guard lock(local::context(), stripe->_mutex);
+            stripeKeys = findSlowestSequenceKeys(*stripe, count);
+        }
+        std::move(stripeKeys.begin(), stripeKeys.end(), std::back_inserter(slowestKeys));
+    }
+    // merge the slowest keys of each stripe
+    std::sort(slowestKeys.begin(), slowestKeys.end(),
+              [](const typename KeyStatisticsList::value_type& lhs,
+                 const typename KeyStatisticsList::value_type& rhs)->bool
+              {
+                  return lhs.second.getTotalRunTime() > rhs.second.getTotalRunTime();
+              });
+    if (slowestKeys.size() > count)
+    {
+        slowestKeys.erase(slowestKeys.begin() + count, slowestKeys.end());
+    }
+    return slowestKeys;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 size_t
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getSequenceKeyCount()
 {
-    Mutex::Guard lock(local::context(), _mutex);
-    return _pendingTaskQueueMap.size();
+    size_t keyCount = 0;
+    for(auto& stripe : _stripes)
+    {
+        Mutex::Guard lock(local::context(), stripe->_mutex);
+        keyCount += stripe->_pendingTaskQueueMap.size();
+    }
+    return keyCount;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -488,16 +998,87 @@ bool
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(std::chrono::milliseconds timeout,
                                                          bool isFinal)
 {
+    if (_drain)
+    {
+        throw SequencerDrainingException{};
+    }
+
     std::shared_ptr<Promise<int>> promise = std::make_shared<Promise<int>>();
     ThreadFuturePtr<int> future = promise->getIThreadFuture();
 
-    //enqueue a universal task and wait
-    enqueueAll([promise](VoidContextPtr ctx)->int{
-        return promise->set(ctx, 0);
-    });
+    //enqueue a universal task and wait until it has completed and left the pending queues
+    auto task = std::make_shared<SequencerTask<SequenceKey>>(
+        makeCapture<int>([](VoidContextPtr)->int{ return 0; }),
+        true,
+        nullptr,
+        (int)IQueue::QueueId::Any,
+        false,
+        getCurrentTime());
+    task->_drainPromises.push_back(promise);
+    enqueueUniversalTask(task);
 
     DrainGuard guard(_drain, !isFinal);
     return future->waitFor(timeout) == std::future_status::ready;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(const SequenceKey& sequenceKey,
+                                                         std::chrono::milliseconds timeout)
+{
+    return drain(std::vector<SequenceKey>(1, sequenceKey), timeout);
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(const std::vector<SequenceKey>& sequenceKeys,
+                                                         std::chrono::milliseconds timeout)
+{
+    std::vector<size_t> stripes;
+    stripes.reserve(sequenceKeys.size());
+    for(const SequenceKey& sequenceKey : sequenceKeys)
+    {
+        stripes.push_back(getStripeIndex(sequenceKey));
+    }
+    std::sort(stripes.begin(), stripes.end());
+    stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+
+    // the last task queued for each key completes after all the others, including those with other keys
+    std::vector<ThreadFuturePtr<int>> futures;
+    {
+        StripeGuard lock(local::context(), *this, stripes);
+        std::unordered_set<SequencerTask<SequenceKey>*> lastTasks;
+        for(const SequenceKey& sequenceKey : sequenceKeys)
+        {
+            const PendingTaskQueueMap& pendingTaskQueueMap = _stripes[getStripeIndex(sequenceKey)]->_pendingTaskQueueMap;
+            typename PendingTaskQueueMap::const_iterator it = pendingTaskQueueMap.find(sequenceKey);
+            if (it == pendingTaskQueueMap.end() or
+                it->second._tasks.empty() or
+                not lastTasks.insert(it->second._tasks.back().get()).second)
+            {
+                continue;
+            }
+            std::shared_ptr<Promise<int>> promise = std::make_shared<Promise<int>>();
+            futures.push_back(promise->getIThreadFuture());
+            it->second._tasks.back()->_drainPromises.push_back(std::move(promise));
+        }
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    for(const ThreadFuturePtr<int>& future : futures)
+    {
+        std::chrono::milliseconds remaining = timeout;
+        if (timeout >= std::chrono::milliseconds::zero())
+        {
+            remaining = std::max(std::chrono::milliseconds::zero(),
+                                 std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()));
+        }
+        if (future->waitFor(remaining) != std::future_status::ready)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 }}}
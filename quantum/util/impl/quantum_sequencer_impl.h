@@ -20,38 +20,117 @@
 //##############################################################################################
 
 #include <quantum/util/quantum_drain_guard.h>
+#include <quantum/util/impl/quantum_sequence_key_task_batch_impl.h>
+#include <quantum/quantum_local.h>
 #include <quantum/quantum_promise.h>
 #include <quantum/quantum_traits.h>
 
+#include <algorithm>
+#include <iterator>
 #include <stdexcept>
 #include <unordered_set>
 
 namespace Bloomberg {
 namespace quantum {
 
+//==============================================================================================
+//                                      class Sequencer
+//==============================================================================================
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Sequencer(Dispatcher& dispatcher,
     const typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Configuration& configuration) :
     _dispatcher(dispatcher),
     _drain(false),
-    _controllerQueueId(configuration.getControlQueueId()),
-    _universalContext(),
-    _contexts(configuration.getBucketCount(),
-              configuration.getHash(),
-              configuration.getKeyEqual(),
-              configuration.getAllocator()),
+    _hash(configuration.getHash()),
+    _universalStats(std::make_shared<SequenceKeyStatisticsWriter>()),
+    _crossPartitionMutex("Sequencer::crossPartitionMutex"),
+    _taskBatchSize(configuration.getTaskBatchSize()),
+    _taskBatchTimeSlice(configuration.getTaskBatchTimeSliceMs()),
+    _taskBatchCount(0),
+    _idleKeyTimeout(configuration.getIdleKeyTimeoutMs()),
+    _idleKeyEvictionStepSize(configuration.getIdleKeyEvictionStepSize()),
+    _collectLatencyStatistics(configuration.getCollectLatencyStatistics()),
+    _maxPendingTasksPerKey(configuration.getMaxPendingTasksPerKey()),
+    _pendingLimitPolicy(configuration.getPendingLimitPolicy()),
+    _keyAffinity(configuration.getKeyAffinity()),
+    _keyAffinityRebalanceThreshold(configuration.getKeyAffinityRebalanceThreshold()),
     _exceptionCallback(configuration.getExceptionCallback()),
     _taskStats(std::make_shared<SequenceKeyStatisticsWriter>())
 {
-    if (_controllerQueueId <= (int)IQueue::QueueId::Any || _controllerQueueId >= _dispatcher.getNumCoroutineThreads())
+    if (_collectLatencyStatistics)
+    {
+        _universalStats->enableLatencyStatistics();
+        _taskStats->enableLatencyStatistics();
+    }
+    int controllerQueueId = configuration.getControlQueueId();
+    if (controllerQueueId <= (int)IQueue::QueueId::Any || controllerQueueId >= _dispatcher.getNumCoroutineThreads())
     {
         throw std::out_of_range("Allowed range is 0 <= controllerQueueId < _dispatcher.getNumCoroutineThreads()");
     }
+    size_t numControllerQueues = configuration.getNumControlQueues();
+    if (numControllerQueues == 0 ||
+        controllerQueueId + numControllerQueues > (size_t)_dispatcher.getNumCoroutineThreads())
+    {
+        throw std::out_of_range("Allowed range is 0 < numControlQueues <= _dispatcher.getNumCoroutineThreads() - controllerQueueId");
+    }
+    if (_idleKeyTimeout > std::chrono::milliseconds::zero() && _idleKeyEvictionStepSize == 0)
+    {
+        throw std::invalid_argument("Sequencer requires an idleKeyEvictionStepSize of at least 1 to evict idle keys");
+    }
+    _partitions.reserve(numControllerQueues);
+    for (size_t i = 0; i < numControllerQueues; ++i)
+    {
+        _partitions.emplace_back(new Partition(controllerQueueId + (int)i, configuration, _universalStats));
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Partition::Partition(int queueId,
+                                                             const Configuration& configuration,
+                                                             const StatsPtr& universalStats) :
+    _queueId(queueId),
+    _contexts(configuration.getBucketCount(),
+              configuration.getHash(),
+              configuration.getKeyEqual(),
+              configuration.getAllocator()),
+    _pendingLimitSpinlock("Sequencer::pendingLimitSpinlock"),
+    _pendingLimits(0, configuration.getHash(), configuration.getKeyEqual())
+{
+    // all the partitions account universal tasks in the same statistics
+    _universalContext._stats = universalStats;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::LimitedTask::LimitedTask(void* opaque,
+                                                               Function<int(VoidContextPtr)>&& func) :
+    _opaque(opaque),
+    _func(std::move(func))
+{
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::CrossPartitionTask::CrossPartitionTask(void* opaque,
+                                                                             int queueId,
+                                                                             bool isHighPriority,
+                                                                             bool isUniversal,
+                                                                             TimePoint enqueueTime,
+                                                                             size_t numPartitions,
+                                                                             FUNC&& func) :
+    _opaque(opaque),
+    _queueId(queueId),
+    _isHighPriority(isHighPriority),
+    _isUniversal(isUniversal),
+    _enqueueTime(enqueueTime),
+    _numPendingPartitions(numPartitions),
+    _spinlock("Sequencer::crossPartitionSpinlock"),
+    _func(std::forward<FUNC>(func))
+{
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     const SequenceKey& sequenceKey,
     FUNC&& func,
@@ -61,21 +140,17 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     {
         throw SequencerDrainingException{};
     }
-    _dispatcher.post(_controllerQueueId,
-                      false,
-                      singleSequenceKeyTaskScheduler<FUNC, ARGS...>,
-                      nullptr,
-                      (int)IQueue::QueueId::Any,
-                      false,
-                      *this,
-                      SequenceKey(sequenceKey),
-                      std::forward<FUNC>(func),
-                      std::forward<ARGS>(args)...);
+    return enqueueSingle(nullptr,
+                         (int)IQueue::QueueId::Any,
+                         false,
+                         sequenceKey,
+                         std::forward<FUNC>(func),
+                         std::forward<ARGS>(args)...);
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     void* opaque,
     int queueId,
@@ -92,21 +167,17 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     {
         throw std::out_of_range(std::string{"Invalid IO queue id: "} + std::to_string(queueId));
     }
-    _dispatcher.post(_controllerQueueId,
-                      false,
-                      singleSequenceKeyTaskScheduler<FUNC, ARGS...>,
-                      std::move(opaque),
-                      std::move(queueId),
-                      std::move(isHighPriority),
-                      *this,
-                      SequenceKey(sequenceKey),
-                      std::forward<FUNC>(func),
-                      std::forward<ARGS>(args)...);
+    return enqueueSingle(opaque,
+                         queueId,
+                         isHighPriority,
+                         sequenceKey,
+                         std::forward<FUNC>(func),
+                         std::forward<ARGS>(args)...);
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     const std::vector<SequenceKey>& sequenceKeys,
     FUNC&& func,
@@ -116,21 +187,18 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     {
         throw SequencerDrainingException{};
     }
-    _dispatcher.post(_controllerQueueId,
-                      false,
-                      multiSequenceKeyTaskScheduler<FUNC, ARGS...>,
-                      nullptr,
-                      (int)IQueue::QueueId::Any,
-                      false,
-                      *this,
-                      std::vector<SequenceKey>(sequenceKeys),
-                      std::forward<FUNC>(func),
-                      std::forward<ARGS>(args)...);
+    enqueueMulti(nullptr,
+                 (int)IQueue::QueueId::Any,
+                 false,
+                 sequenceKeys,
+                 std::forward<FUNC>(func),
+                 std::forward<ARGS>(args)...);
+    return SequencerEnqueueStatus::Enqueued;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
-void
+SequencerEnqueueStatus
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     void* opaque,
     int queueId,
@@ -147,16 +215,13 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueue(
     {
         throw std::out_of_range(std::string{"Invalid IO queue id: "} + std::to_string(queueId));
     }
-    _dispatcher.post(_controllerQueueId,
-                      false,
-                      multiSequenceKeyTaskScheduler<FUNC, ARGS...>,
-                      std::move(opaque),
-                      std::move(queueId),
-                      std::move(isHighPriority),
-                      *this,
-                      std::vector<SequenceKey>(sequenceKeys),
-                      std::forward<FUNC>(func),
-                      std::forward<ARGS>(args)...);
+    enqueueMulti(opaque,
+                 queueId,
+                 isHighPriority,
+                 sequenceKeys,
+                 std::forward<FUNC>(func),
+                 std::forward<ARGS>(args)...);
+    return SequencerEnqueueStatus::Enqueued;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -168,15 +233,11 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueAll(FUNC&& func, ARGS&
     {
         throw SequencerDrainingException{};
     }
-    _dispatcher.post(_controllerQueueId,
-                      false,
-                      universalTaskScheduler<FUNC, ARGS...>,
-                      nullptr,
-                      (int)IQueue::QueueId::Any,
-                      false,
-                      *this,
-                      std::forward<FUNC>(func),
-                      std::forward<ARGS>(args)...);
+    enqueueUniversal(nullptr,
+                     (int)IQueue::QueueId::Any,
+                     false,
+                     std::forward<FUNC>(func),
+                     std::forward<ARGS>(args)...);
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -197,57 +258,342 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueAll(
     {
         throw std::out_of_range(std::string{"Invalid IO queue id: "} + std::to_string(queueId));
     }
-    _dispatcher.post(_controllerQueueId,
+    enqueueUniversal(opaque,
+                     queueId,
+                     isHighPriority,
+                     std::forward<FUNC>(func),
+                     std::forward<ARGS>(args)...);
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC, class ... ARGS>
+SequencerEnqueueStatus
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueSingle(
+    void* opaque,
+    int queueId,
+    bool isHighPriority,
+    const SequenceKey& sequenceKey,
+    FUNC&& func,
+    ARGS&&... args)
+{
+    Partition& partition = getPartition(sequenceKey);
+    if (_maxPendingTasksPerKey == 0)
+    {
+        _dispatcher.post(partition._queueId,
+                          false,
+                          singleSequenceKeyTaskScheduler<FUNC, ARGS...>,
+                          std::move(opaque),
+                          std::move(queueId),
+                          std::move(isHighPriority),
+                          getCurrentTime(),
+                          *this,
+                          partition,
+                          SequenceKey(sequenceKey),
+                          std::forward<FUNC>(func),
+                          std::forward<ARGS>(args)...);
+        return SequencerEnqueueStatus::Enqueued;
+    }
+
+    // The task is admitted by the producer since the control queue only learns about it asynchronously
+    LimitedTaskPtr task = std::make_shared<LimitedTask>(opaque,
+        makeCapture<int>(std::forward<FUNC>(func), std::forward<ARGS>(args)...));
+    SequencerEnqueueStatus status = admitLimitedTask(partition, sequenceKey, task);
+    if (status != SequencerEnqueueStatus::Enqueued)
+    {
+        return status;
+    }
+    auto runner = [this, &partition, sequenceKey, task](VoidContextPtr ctx)->int
+    {
+        return runLimitedTask(ctx, *this, partition, sequenceKey, task);
+    };
+    // the exceptions are reported with the opaque data of the function which runs
+    _dispatcher.post(partition._queueId,
+                      false,
+                      singleSequenceKeyTaskScheduler<decltype(runner)>,
+                      nullptr,
+                      std::move(queueId),
+                      std::move(isHighPriority),
+                      getCurrentTime(),
+                      *this,
+                      partition,
+                      SequenceKey(sequenceKey),
+                      std::move(runner));
+    return status;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC, class ... ARGS>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueMulti(
+    void* opaque,
+    int queueId,
+    bool isHighPriority,
+    const std::vector<SequenceKey>& sequenceKeys,
+    FUNC&& func,
+    ARGS&&... args)
+{
+    size_t partitionIndex = 0;
+    PartitionKeys partitionKeys;
+    if (_partitions.size() > 1)
+    {
+        // split the keys by partition
+        size_t numPartitions = 0;
+        partitionKeys.resize(_partitions.size());
+        for (const SequenceKey& sequenceKey : sequenceKeys)
+        {
+            size_t index = _hash(sequenceKey) % _partitions.size();
+            if (partitionKeys[index].empty())
+            {
+                partitionIndex = index;
+                ++numPartitions;
+            }
+            partitionKeys[index].push_back(sequenceKey);
+        }
+        if (numPartitions > 1)
+        {
+            enqueueCrossPartition(opaque,
+                                  queueId,
+                                  isHighPriority,
+                                  false,
+                                  std::move(partitionKeys),
+                                  std::forward<FUNC>(func),
+                                  std::forward<ARGS>(args)...);
+            return;
+        }
+    }
+    Partition& partition = *_partitions[partitionIndex];
+    _dispatcher.post(partition._queueId,
+                      false,
+                      multiSequenceKeyTaskScheduler<FUNC, ARGS...>,
+                      std::move(opaque),
+                      std::move(queueId),
+                      std::move(isHighPriority),
+                      getCurrentTime(),
+                      *this,
+                      partition,
+                      std::vector<SequenceKey>(sequenceKeys),
+                      std::forward<FUNC>(func),
+                      std::forward<ARGS>(args)...);
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC, class ... ARGS>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueUniversal(
+    void* opaque,
+    int queueId,
+    bool isHighPriority,
+    FUNC&& func,
+    ARGS&&... args)
+{
+    if (_partitions.size() > 1)
+    {
+        enqueueCrossPartition(opaque,
+                              queueId,
+                              isHighPriority,
+                              true,
+                              PartitionKeys(_partitions.size()),
+                              std::forward<FUNC>(func),
+                              std::forward<ARGS>(args)...);
+        return;
+    }
+    Partition& partition = *_partitions.front();
+    _dispatcher.post(partition._queueId,
                       false,
                       universalTaskScheduler<FUNC, ARGS...>,
                       std::move(opaque),
                       std::move(queueId),
                       std::move(isHighPriority),
+                      getCurrentTime(),
                       *this,
+                      partition,
                       std::forward<FUNC>(func),
                       std::forward<ARGS>(args)...);
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+template <class FUNC, class ... ARGS>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::enqueueCrossPartition(
+    void* opaque,
+    int queueId,
+    bool isHighPriority,
+    bool isUniversal,
+    PartitionKeys&& partitionKeys,
+    FUNC&& func,
+    ARGS&&... args)
+{
+    size_t numPartitions = _partitions.size();
+    if (!isUniversal)
+    {
+        numPartitions = std::count_if(partitionKeys.begin(), partitionKeys.end(),
+                                      [](const std::vector<SequenceKey>& keys)->bool
+                                      {
+                                          return !keys.empty();
+                                      });
+    }
+    CrossPartitionTaskPtr task = std::make_shared<CrossPartitionTask>(
+            opaque,
+            queueId,
+            isHighPriority,
+            isUniversal,
+            getCurrentTime(),
+            numPartitions,
+            makeCapture<int>(std::forward<FUNC>(func), std::forward<ARGS>(args)...));
+
+    // Registrations of different cross-partition tasks must reach all the partitions in the same
+    // relative order, otherwise two tasks sharing several partitions could wait on each other's
+    // placeholders. Each control queue runs its scheduler tasks in posting order, so it suffices to
+    // serialize the posting below. The mutex is only held while posting, never while the schedulers
+    // run, and single-partition tasks do not take it at all. A per-partition counter would not be
+    // enough since two producers could still interleave their posts to different partitions.
+    Mutex::Guard lock(local::context(), _crossPartitionMutex);
+    for (size_t i = 0; i < _partitions.size(); ++i)
+    {
+        if (!isUniversal && partitionKeys[i].empty())
+        {
+            continue;
+        }
+        _dispatcher.post(_partitions[i]->_queueId,
+                          false,
+                          crossPartitionTaskScheduler,
+                          *this,
+                          *_partitions[i],
+                          std::move(partitionKeys[i]),
+                          CrossPartitionTaskPtr(task));
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::Partition&
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getPartition(const SequenceKey& sequenceKey)
+{
+    if (_partitions.size() == 1)
+    {
+        return *_partitions.front();
+    }
+    return *_partitions[_hash(sequenceKey) % _partitions.size()];
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequencerEnqueueStatus
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::admitLimitedTask(Partition& partition,
+                                                                    const SequenceKey& sequenceKey,
+                                                                    const LimitedTaskPtr& task)
+{
+    VoidContextPtr ctx = local::context();
+    while (true)
+    {
+        {
+            SpinLock::Guard lock(partition._pendingLimitSpinlock);
+            PendingLimit& limit = partition._pendingLimits[sequenceKey];
+            if (limit._numPendingTasks < _maxPendingTasksPerKey)
+            {
+                ++limit._numPendingTasks;
+                limit._lastTask = task;
+                return SequencerEnqueueStatus::Enqueued;
+            }
+            if (_pendingLimitPolicy == SequencerPendingLimitPolicy::Reject)
+            {
+                return SequencerEnqueueStatus::Rejected;
+            }
+            if (_pendingLimitPolicy == SequencerPendingLimitPolicy::Coalesce)
+            {
+                // The tasks of a key start in admission order, so the last admitted one has not started yet
+                // while the key has pending tasks. It only reads its function after leaving this table.
+                limit._lastTask->_func = std::move(task->_func);
+                limit._lastTask->_opaque = task->_opaque;
+                return SequencerEnqueueStatus::Coalesced;
+            }
+        }
+        // let the pending tasks of the key start before checking the limit again
+        yield(ctx);
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::runLimitedTask(VoidContextPtr ctx,
+                                                                  Sequencer& sequencer,
+                                                                  Partition& partition,
+                                                                  const SequenceKey& sequenceKey,
+                                                                  const LimitedTaskPtr& task)
+{
+    {
+        SpinLock::Guard lock(partition._pendingLimitSpinlock);
+        typename PendingLimitMap::iterator it = partition._pendingLimits.find(sequenceKey);
+        if (--it->second._numPendingTasks == 0)
+        {
+            partition._pendingLimits.erase(it);
+        }
+    }
+    return callPosted(ctx, task->_opaque, sequencer, task->_func);
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 size_t
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::trimSequenceKeys()
 {
-    auto trimFunc = [this](CoroContextPtr<size_t> ctx)->int
+    std::vector<ThreadContextPtr<size_t>> results;
+    results.reserve(_partitions.size());
+    bool isEvictionEnabled = _idleKeyTimeout > std::chrono::milliseconds::zero();
+    for (auto&& partition : _partitions)
     {
-        for (auto it = _contexts.begin(); it != _contexts.end();)
+        Partition& trimmed = *partition;
+        auto trimFunc = [&trimmed, isEvictionEnabled](CoroContextPtr<size_t> ctx)->int
         {
-            auto trimIt = it++;
-            if (canTrimContext(ctx, trimIt->second._context))
+            ContextMap& contexts = trimmed._contexts;
+            for (auto it = contexts.begin(); it != contexts.end();)
             {
-                _contexts.erase(trimIt);
+                auto trimIt = it++;
+                if (canTrimContext(ctx, trimIt->second._context))
+                {
+                    contexts.erase(trimIt);
+                }
             }
-        }
-        return ctx->set(_contexts.size());
-    };
-    return _dispatcher.post(_controllerQueueId, true, std::move(trimFunc))->get();
+            if (isEvictionEnabled)
+            {
+                // keep a single eviction record per remaining key
+                trimmed._idleKeys.clear();
+                for (const auto& context : contexts)
+                {
+                    trimmed._idleKeys.emplace_back(context.first, context.second._lastUsed);
+                }
+            }
+            return ctx->set(contexts.size());
+        };
+        results.push_back(_dispatcher.post(partition->_queueId, true, std::move(trimFunc)));
+    }
+    size_t numKeys = 0;
+    for (auto&& result : results)
+    {
+        numKeys += result->get();
+    }
+    return numKeys;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequenceKeyStatistics
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getStatistics(const SequenceKey& sequenceKey)
 {
-    auto statsFunc = [this, sequenceKey](CoroContextPtr<SequenceKeyStatistics> ctx)->int
+    Partition& partition = getPartition(sequenceKey);
+    auto statsFunc = [&partition, sequenceKey](CoroContextPtr<SequenceKeyStatistics> ctx)->int
     {
-        typename ContextMap::iterator ctxIt = _contexts.find(sequenceKey);
-        if (ctxIt == _contexts.end())
+        typename ContextMap::iterator ctxIt = partition._contexts.find(sequenceKey);
+        if (ctxIt == partition._contexts.end())
         {
             return ctx->set(SequenceKeyStatistics());
         }
         return ctx->set(SequenceKeyStatistics(*ctxIt->second._stats));
     };
-    return _dispatcher.post(_controllerQueueId, true, std::move(statsFunc))->get();
+    return _dispatcher.post(partition._queueId, true, std::move(statsFunc))->get();
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 SequenceKeyStatistics
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getStatistics()
 {
-    return *_universalContext._stats;
+    return *_universalStats;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -257,15 +603,73 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getTaskStatistics()
     return *_taskStats;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+size_t
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getTaskBatchCount() const
+{
+    return _taskBatchCount;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+std::vector<std::pair<SequenceKey, SequenceKeyStatistics>>
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getSlowestSequenceKeys(size_t count)
+{
+    KeyStatisticsList slowestKeys;
+    if (!_collectLatencyStatistics || (count == 0))
+    {
+        return slowestKeys;
+    }
+    std::vector<ThreadContextPtr<KeyStatisticsList>> results;
+    results.reserve(_partitions.size());
+    for (auto&& partition : _partitions)
+    {
+        const ContextMap& contexts = partition->_contexts;
+        auto statsFunc = [&contexts, count](CoroContextPtr<KeyStatisticsList> ctx)->int
+        {
+            return ctx->set(findSlowestSequenceKeys(contexts, count));
+        };
+        results.push_back(_dispatcher.post(partition->_queueId, true, std::move(statsFunc)));
+    }
+    for (auto&& result : results)
+    {
+        KeyStatisticsList partitionKeys = result->get();
+        std::move(partitionKeys.begin(), partitionKeys.end(), std::back_inserter(slowestKeys));
+    }
+    // merge the slowest keys of each partition
+    std::sort(slowestKeys.begin(), slowestKeys.end(),
+              [](const typename KeyStatisticsList::value_type& lhs,
+                 const typename KeyStatisticsList::value_type& rhs)->bool
+              {
+                  return lhs.second.getTotalRunTime() > rhs.second.getTotalRunTime();
+              });
+    if (slowestKeys.size() > count)
+    {
+        slowestKeys.erase(slowestKeys.begin() + count, slowestKeys.end());
+    }
+    return slowestKeys;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 size_t
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getSequenceKeyCount()
 {
-    auto statsFunc = [this](CoroContextPtr<size_t> ctx)->int
+    std::vector<ThreadContextPtr<size_t>> results;
+    results.reserve(_partitions.size());
+    for (auto&& partition : _partitions)
     {
-        return ctx->set(_contexts.size());
-    };
-    return _dispatcher.post(_controllerQueueId, true, std::move(statsFunc))->get();
+        ContextMap& contexts = partition->_contexts;
+        auto statsFunc = [&contexts](CoroContextPtr<size_t> ctx)->int
+        {
+            return ctx->set(contexts.size());
+        };
+        results.push_back(_dispatcher.post(partition->_queueId, true, std::move(statsFunc)));
+    }
+    size_t numKeys = 0;
+    for (auto&& result : results)
+    {
+        numKeys += result->get();
+    }
+    return numKeys;
 }
 
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
@@ -275,6 +679,7 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForTwoDependents(
         VoidContextPtr ctx,
         void* opaque,
         Sequencer& sequencer,
+        TimePoint enqueueTime,
         SequenceKeyData&& dependent,
         SequenceKeyData&& universalDependent,
         FUNC&& func,
@@ -289,10 +694,14 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForTwoDependents(
     {
         universalDependent._context->wait(ctx);
     }
+    TimePoint startTime = sequencer.getCurrentTime();
     int rc = callPosted(ctx, opaque, sequencer, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    TimePoint endTime = sequencer.getCurrentTime();
     // update task stats
     dependent._stats->decrementPendingTaskCount();
+    dependent._stats->recordTaskLatency(enqueueTime, startTime, endTime);
     sequencer._taskStats->decrementPendingTaskCount();
+    sequencer._taskStats->recordTaskLatency(enqueueTime, startTime, endTime);
     return rc;
 }
 
@@ -303,6 +712,7 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForDependents(
         VoidContextPtr ctx,
         void* opaque,
         Sequencer& sequencer,
+        TimePoint enqueueTime,
         std::vector<SequenceKeyData>&& dependents,
         SequenceKeyData&& universalDependent,
         FUNC&& func,
@@ -321,13 +731,17 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForDependents(
     {
         universalDependent._context->wait(ctx);
     }
+    TimePoint startTime = sequencer.getCurrentTime();
     int rc = callPosted(ctx, opaque, sequencer, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    TimePoint endTime = sequencer.getCurrentTime();
     // update task stats
     for (const auto& dependent : dependents)
     {
         dependent._stats->decrementPendingTaskCount();
+        dependent._stats->recordTaskLatency(enqueueTime, startTime, endTime);
     }
     sequencer._taskStats->decrementPendingTaskCount();
+    sequencer._taskStats->recordTaskLatency(enqueueTime, startTime, endTime);
     return rc;
 }
 
@@ -338,6 +752,7 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForUniversalDependent(
         VoidContextPtr ctx,
         void* opaque,
         Sequencer& sequencer,
+        TimePoint enqueueTime,
         std::vector<SequenceKeyData>&& dependents,
         SequenceKeyData&& universalDependent,
         FUNC&& func,
@@ -356,10 +771,14 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForUniversalDependent(
     {
         universalDependent._context->wait(ctx);
     }
+    TimePoint startTime = sequencer.getCurrentTime();
     int rc = callPosted(ctx, opaque, sequencer, std::forward<FUNC>(func), std::forward<ARGS>(args)...);
+    TimePoint endTime = sequencer.getCurrentTime();
     // update task stats
     universalDependent._stats->decrementPendingTaskCount();
+    universalDependent._stats->recordTaskLatency(enqueueTime, startTime, endTime);
     sequencer._taskStats->decrementPendingTaskCount();
+    sequencer._taskStats->recordTaskLatency(enqueueTime, startTime, endTime);
     return rc;
 }
 
@@ -371,29 +790,62 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::singleSequenceKeyTaskSchedule
         void* opaque,
         int queueId,
         bool isHighPriority,
+        TimePoint enqueueTime,
         Sequencer& sequencer,
+        Partition& partition,
         SequenceKey&& sequenceKey,
         FUNC&& func,
         ARGS&&... args)
 {
+    evictIdleSequenceKeys(ctx, sequencer, partition);
     // find the dependent or create a new element
-    typename ContextMap::iterator contextIt = sequencer._contexts.emplace(sequenceKey, SequenceKeyData()).first;
+    SequenceKeyData& keyData = getSequenceKeyData(sequencer, partition, sequenceKey);
     // update stats
-    contextIt->second._stats->incrementPostedTaskCount();
-    contextIt->second._stats->incrementPendingTaskCount();
+    keyData._stats->incrementPostedTaskCount();
+    keyData._stats->incrementPendingTaskCount();
     // update task stats
     sequencer._taskStats->incrementPostedTaskCount();
     sequencer._taskStats->incrementPendingTaskCount();
 
+    if (sequencer._keyAffinity && (queueId == (int)IQueue::QueueId::Any))
+    {
+        queueId = getAffinityQueueId(ctx, sequencer, keyData, sequenceKey);
+    }
+    if (sequencer._taskBatchSize > 1)
+    {
+        SequenceKeyTaskBatch::TaskPtr task(new Function<int(VoidContextPtr)>(
+            makeCapture<int>(std::forward<FUNC>(func), std::forward<ARGS>(args)...)));
+        // try to run the task in the coroutine of the current batch for this sequenceKey
+        if (keyData._batch && keyData._batch->push(opaque, queueId, isHighPriority, enqueueTime, task))
+        {
+            return 0;
+        }
+        TaskBatchPtr batch = std::make_shared<SequenceKeyTaskBatch>(queueId, isHighPriority, sequencer._taskBatchSize);
+        batch->push(opaque, queueId, isHighPriority, enqueueTime, task);
+        ++sequencer._taskBatchCount;
+        // save the batch context as the last for this sequenceKey
+        keyData._context = ctx->post(
+                std::move(queueId),
+                std::move(isHighPriority),
+                runTaskBatch,
+                sequencer,
+                SequenceKeyData(keyData),
+                SequenceKeyData(partition._universalContext),
+                TaskBatchPtr(batch));
+        keyData._batch = std::move(batch);
+        return 0;
+    }
+
     // save the context as the last for this sequenceKey
-    contextIt->second._context = ctx->post(
+    keyData._context = ctx->post(
             std::move(queueId),
             std::move(isHighPriority),
             waitForTwoDependents<FUNC, ARGS...>,
             std::move(opaque),
             sequencer,
-            SequenceKeyData(contextIt->second),
-            SequenceKeyData(sequencer._universalContext),
+            std::move(enqueueTime),
+            SequenceKeyData(keyData),
+            SequenceKeyData(partition._universalContext),
             std::forward<FUNC>(func),
             std::forward<ARGS>(args)...);
     return 0;
@@ -407,23 +859,26 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::multiSequenceKeyTaskScheduler
     void* opaque,
     int queueId,
     bool isHighPriority,
+    TimePoint enqueueTime,
     Sequencer& sequencer,
+    Partition& partition,
     std::vector<SequenceKey>&& sequenceKeys,
     FUNC&& func,
     ARGS&&... args)
 {
+    evictIdleSequenceKeys(ctx, sequencer, partition);
     // construct the dependent collection
     std::unordered_set<SequenceKey, Hash, KeyEqual> uniqueKeys{ sequenceKeys.begin(),
                                                                 sequenceKeys.end() };
     std::vector<SequenceKeyData> dependents;
     dependents.reserve(uniqueKeys.size() + 1);
-    dependents.push_back(sequencer._universalContext);
+    dependents.push_back(partition._universalContext);
     for (const SequenceKey& sequenceKey : uniqueKeys)
     {
-        typename ContextMap::iterator contextIt = sequencer._contexts.emplace(sequenceKey, SequenceKeyData()).first;
-        contextIt->second._stats->incrementPostedTaskCount();
-        contextIt->second._stats->incrementPendingTaskCount();
-        dependents.emplace_back(contextIt->second);
+        SequenceKeyData& keyData = getSequenceKeyData(sequencer, partition, sequenceKey);
+        keyData._stats->incrementPostedTaskCount();
+        keyData._stats->incrementPendingTaskCount();
+        dependents.emplace_back(keyData);
     }
     // update task stats
     sequencer._taskStats->incrementPostedTaskCount();
@@ -435,15 +890,18 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::multiSequenceKeyTaskScheduler
             waitForDependents<FUNC, ARGS...>,
             std::move(opaque),
             sequencer,
+            std::move(enqueueTime),
             std::move(dependents),
-            SequenceKeyData(sequencer._universalContext),
+            SequenceKeyData(partition._universalContext),
             std::forward<FUNC>(func),
             std::forward<ARGS>(args)...);
 
     // save the context as the last for each sequenceKey
     for (const SequenceKey& sequenceKey : uniqueKeys)
     {
-        sequencer._contexts[sequenceKey]._context = newCtx;
+        SequenceKeyData& keyData = partition._contexts[sequenceKey];
+        keyData._context = newCtx;
+        keyData._batch.reset();
     }
     return 0;
 }
@@ -456,14 +914,17 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::universalTaskScheduler(
     void* opaque,
     int queueId,
     bool isHighPriority,
+    TimePoint enqueueTime,
     Sequencer& sequencer,
+    Partition& partition,
     FUNC&& func,
     ARGS&&... args)
 {
+    evictIdleSequenceKeys(ctx, sequencer, partition);
     // construct the dependent collection
     std::vector<SequenceKeyData> dependents;
-    dependents.reserve(sequencer._contexts.size());
-    for (auto ctxIt = sequencer._contexts.begin(); ctxIt != sequencer._contexts.end(); ++ctxIt)
+    dependents.reserve(partition._contexts.size());
+    for (auto ctxIt = partition._contexts.begin(); ctxIt != partition._contexts.end(); ++ctxIt)
     {
         // check if the context still has a pending task
         if (isPendingContext(ctx, ctxIt->second._context))
@@ -471,28 +932,209 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::universalTaskScheduler(
             // we will need to wait on this context to finish its current running task
             dependents.emplace_back(ctxIt->second);
         }
+        // tasks enqueued from now on must not join the current batch
+        ctxIt->second._batch.reset();
     }
     // update the universal stats only
-    sequencer._universalContext._stats->incrementPostedTaskCount();
-    sequencer._universalContext._stats->incrementPendingTaskCount();
+    partition._universalContext._stats->incrementPostedTaskCount();
+    partition._universalContext._stats->incrementPendingTaskCount();
     // update task stats
     sequencer._taskStats->incrementPostedTaskCount();
     sequencer._taskStats->incrementPendingTaskCount();
 
     // post the task and save the context as the last for the universal sequenceKey
-    sequencer._universalContext._context = ctx->post(
+    partition._universalContext._context = ctx->post(
             std::move(queueId),
             std::move(isHighPriority),
             waitForUniversalDependent<FUNC, ARGS...>,
             std::move(opaque),
             sequencer,
+            std::move(enqueueTime),
             std::move(dependents),
-            SequenceKeyData(sequencer._universalContext),
+            SequenceKeyData(partition._universalContext),
             std::forward<FUNC>(func),
             std::forward<ARGS>(args)...);
     return 0;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::crossPartitionTaskScheduler(
+    VoidContextPtr ctx,
+    Sequencer& sequencer,
+    Partition& partition,
+    std::vector<SequenceKey>&& sequenceKeys,
+    CrossPartitionTaskPtr task)
+{
+    evictIdleSequenceKeys(ctx, sequencer, partition);
+    // construct the dependent collection for this partition
+    std::unordered_set<SequenceKey, Hash, KeyEqual> uniqueKeys{ sequenceKeys.begin(),
+                                                                sequenceKeys.end() };
+    std::vector<ICoroContextBasePtr> dependents;
+    std::vector<StatsPtr> stats;
+    if (task->_isUniversal)
+    {
+        dependents.reserve(partition._contexts.size() + 1);
+        for (auto ctxIt = partition._contexts.begin(); ctxIt != partition._contexts.end(); ++ctxIt)
+        {
+            if (isPendingContext(ctx, ctxIt->second._context))
+            {
+                dependents.push_back(ctxIt->second._context);
+            }
+            ctxIt->second._batch.reset();
+        }
+    }
+    else
+    {
+        dependents.reserve(uniqueKeys.size() + 1);
+        stats.reserve(uniqueKeys.size());
+        for (const SequenceKey& sequenceKey : uniqueKeys)
+        {
+            SequenceKeyData& keyData = getSequenceKeyData(sequencer, partition, sequenceKey);
+            keyData._stats->incrementPostedTaskCount();
+            keyData._stats->incrementPendingTaskCount();
+            dependents.push_back(keyData._context);
+            stats.push_back(keyData._stats);
+        }
+    }
+    dependents.push_back(partition._universalContext._context);
+
+    // Within this partition, the task is represented by a placeholder which completes along with it.
+    // Later tasks with the same keys in this partition must have a context to wait on as soon as this
+    // registration returns, but the task itself is only posted once the last partition registers it,
+    // possibly from another control queue. The placeholder only waits on the task's promise, so it
+    // costs a suspended coroutine per partition and no CPU while the task is pending.
+    ICoroContextBasePtr placeholder = ctx->post(waitForCrossPartitionTask, CrossPartitionTaskPtr(task));
+    if (task->_isUniversal)
+    {
+        partition._universalContext._context = placeholder;
+    }
+    else
+    {
+        for (const SequenceKey& sequenceKey : uniqueKeys)
+        {
+            SequenceKeyData& keyData = partition._contexts[sequenceKey];
+            keyData._context = placeholder;
+            keyData._batch.reset();
+        }
+    }
+
+    {
+        SpinLock::Guard lock(task->_spinlock);
+        task->_dependents.insert(task->_dependents.end(), dependents.begin(), dependents.end());
+        task->_stats.insert(task->_stats.end(), stats.begin(), stats.end());
+    }
+    if (--task->_numPendingPartitions > 0)
+    {
+        return 0;
+    }
+
+    // all the partitions are registered so the task can be posted
+    if (task->_isUniversal)
+    {
+        sequencer._universalStats->incrementPostedTaskCount();
+        sequencer._universalStats->incrementPendingTaskCount();
+        task->_stats.push_back(sequencer._universalStats);
+    }
+    sequencer._taskStats->incrementPostedTaskCount();
+    sequencer._taskStats->incrementPendingTaskCount();
+    int queueId = task->_queueId;
+    bool isHighPriority = task->_isHighPriority;
+    ctx->post(queueId,
+              isHighPriority,
+              waitForCrossPartitionDependents,
+              sequencer,
+              std::move(task));
+    return 0;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForCrossPartitionDependents(
+        VoidContextPtr ctx,
+        Sequencer& sequencer,
+        CrossPartitionTaskPtr task)
+{
+    // wait until all the dependents in all the partitions are done
+    for (const auto& dependent : task->_dependents)
+    {
+        if (dependent)
+        {
+            dependent->wait(ctx);
+        }
+    }
+    TimePoint startTime = sequencer.getCurrentTime();
+    int rc = callPosted(ctx, task->_opaque, sequencer, task->_func);
+    TimePoint endTime = sequencer.getCurrentTime();
+    // update task stats
+    for (const auto& stats : task->_stats)
+    {
+        stats->decrementPendingTaskCount();
+        stats->recordTaskLatency(task->_enqueueTime, startTime, endTime);
+    }
+    sequencer._taskStats->decrementPendingTaskCount();
+    sequencer._taskStats->recordTaskLatency(task->_enqueueTime, startTime, endTime);
+    // release the placeholders
+    task->_promise.set(ctx, 0);
+    return rc;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::waitForCrossPartitionTask(
+        VoidContextPtr ctx,
+        CrossPartitionTaskPtr task)
+{
+    task->_promise.getICoroFuture()->wait(ctx);
+    return 0;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::runTaskBatch(
+        VoidContextPtr ctx,
+        Sequencer& sequencer,
+        SequenceKeyData&& dependent,
+        SequenceKeyData&& universalDependent,
+        TaskBatchPtr batch)
+{
+    // wait until all the dependents are done
+    if (dependent._context)
+    {
+        dependent._context->wait(ctx);
+    }
+    if (universalDependent._context)
+    {
+        universalDependent._context->wait(ctx);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    void* opaque = nullptr;
+    TimePoint enqueueTime;
+    SequenceKeyTaskBatch::TaskPtr task;
+    while (batch->pop(opaque, enqueueTime, task))
+    {
+        if ((sequencer._taskBatchTimeSlice != std::chrono::milliseconds::zero()) &&
+            (std::chrono::steady_clock::now() - start >= sequencer._taskBatchTimeSlice))
+        {
+            // the time slice expired so stop accepting tasks and let the other coroutines
+            // on this queue run before the remaining ones
+            batch->close();
+            ctx->yield();
+            start = std::chrono::steady_clock::now();
+        }
+        TimePoint startTime = sequencer.getCurrentTime();
+        callPosted(ctx, opaque, sequencer, *task);
+        task.reset();
+        TimePoint endTime = sequencer.getCurrentTime();
+        // update task stats
+        dependent._stats->decrementPendingTaskCount();
+        dependent._stats->recordTaskLatency(enqueueTime, startTime, endTime);
+        sequencer._taskStats->decrementPendingTaskCount();
+        sequencer._taskStats->recordTaskLatency(enqueueTime, startTime, endTime);
+    }
+    return 0;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 template <class FUNC, class ... ARGS>
 int
@@ -530,6 +1172,155 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::callPosted(
     return -1; //error
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::TimePoint
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getCurrentTime() const
+{
+    // the clock is only read when the latencies are recorded
+    return _collectLatencyStatistics ? std::chrono::steady_clock::now() : TimePoint();
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+typename Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::KeyStatisticsList
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::findSlowestSequenceKeys(const ContextMap& contexts,
+                                                                           size_t count)
+{
+    // rank the keys on a snapshot of their total run time and only copy the statistics of the slowest ones
+    using RankedKey = std::pair<std::chrono::nanoseconds, typename ContextMap::const_iterator>;
+    std::vector<RankedKey> rankedKeys;
+    rankedKeys.reserve(contexts.size());
+    for (auto ctxIt = contexts.begin(); ctxIt != contexts.end(); ++ctxIt)
+    {
+        if (ctxIt->second._stats->getCompletedTaskCount() > 0)
+        {
+            rankedKeys.emplace_back(ctxIt->second._stats->getTotalRunTime(), ctxIt);
+        }
+    }
+    count = std::min(count, rankedKeys.size());
+    std::partial_sort(rankedKeys.begin(), rankedKeys.begin() + count, rankedKeys.end(),
+                      [](const RankedKey& lhs, const RankedKey& rhs)->bool
+                      {
+                          return lhs.first > rhs.first;
+                      });
+    KeyStatisticsList slowestKeys;
+    slowestKeys.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        slowestKeys.emplace_back(rankedKeys[i].second->first, *rankedKeys[i].second->second._stats);
+    }
+    return slowestKeys;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+SequenceKeyData&
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getSequenceKeyData(Sequencer& sequencer,
+                                                                      Partition& partition,
+                                                                      const SequenceKey& sequenceKey)
+{
+    std::pair<typename ContextMap::iterator, bool> result = partition._contexts.emplace(sequenceKey, SequenceKeyData());
+    SequenceKeyData& keyData = result.first->second;
+    if (result.second && sequencer._collectLatencyStatistics)
+    {
+        keyData._stats->enableLatencyStatistics();
+    }
+    if (sequencer._idleKeyTimeout > std::chrono::milliseconds::zero())
+    {
+        keyData._lastUsed = std::chrono::steady_clock::now();
+        if (result.second)
+        {
+            partition._idleKeys.emplace_back(sequenceKey, keyData._lastUsed);
+        }
+    }
+    return keyData;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+void
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::evictIdleSequenceKeys(VoidContextPtr ctx,
+                                                                         Sequencer& sequencer,
+                                                                         Partition& partition)
+{
+    if (sequencer._idleKeyTimeout <= std::chrono::milliseconds::zero())
+    {
+        return;
+    }
+    // Each key has a single record which is only refreshed when it reaches the front of the queue,
+    // so the amount of work is bounded by the step size regardless of how often the keys are used.
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    IdleKeyQueue& idleKeys = partition._idleKeys;
+    for (size_t i = 0; (i < sequencer._idleKeyEvictionStepSize) && !idleKeys.empty(); ++i)
+    {
+        typename IdleKeyQueue::value_type& record = idleKeys.front();
+        if (now - record.second < sequencer._idleKeyTimeout)
+        {
+            // the records behind were mostly queued later
+            break;
+        }
+        typename ContextMap::iterator contextIt = partition._contexts.find(record.first);
+        if (contextIt != partition._contexts.end())
+        {
+            SequenceKeyData& keyData = contextIt->second;
+            if (now - keyData._lastUsed < sequencer._idleKeyTimeout)
+            {
+                // used since it was queued: check again once it may have been idle long enough
+                idleKeys.emplace_back(std::move(record.first), keyData._lastUsed);
+            }
+            else if (canTrimContext(ctx, keyData._context))
+            {
+                partition._contexts.erase(contextIt);
+            }
+            else
+            {
+                // the last task of this key is still pending
+                idleKeys.emplace_back(std::move(record.first), now);
+            }
+        }
+        idleKeys.pop_front();
+    }
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getAffinityQueueId(VoidContextPtr ctx,
+                                                                      Sequencer& sequencer,
+                                                                      SequenceKeyData& keyData,
+                                                                      const SequenceKey& sequenceKey)
+{
+    if (keyData._queueId == (int)IQueue::QueueId::Any)
+    {
+        const std::pair<int, int>& range = sequencer._dispatcher.getCoroQueueIdRangeForAny();
+        keyData._queueId = range.first + (int)(sequencer._hash(sequenceKey) % (size_t)(range.second - range.first + 1));
+    }
+    // A key only moves while it has no task pending or running, otherwise its next task would be
+    // posted to a cold queue only to wait there for its predecessor.
+    if ((sequencer._keyAffinityRebalanceThreshold > 0) &&
+        (sequencer._dispatcher.size(IQueue::QueueType::Coro, keyData._queueId) > sequencer._keyAffinityRebalanceThreshold) &&
+        canTrimContext(ctx, keyData._context))
+    {
+        keyData._queueId = sequencer.getLeastLoadedQueueId();
+    }
+    return keyData._queueId;
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+int
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::getLeastLoadedQueueId() const
+{
+    const std::pair<int, int>& range = _dispatcher.getCoroQueueIdRangeForAny();
+    int leastLoadedQueueId = range.first;
+    size_t minSize = _dispatcher.size(IQueue::QueueType::Coro, range.first);
+    for (int queueId = range.first + 1; (queueId <= range.second) && (minSize > 0); ++queueId)
+    {
+        size_t size = _dispatcher.size(IQueue::QueueType::Coro, queueId);
+        if (size < minSize)
+        {
+            leastLoadedQueueId = queueId;
+            minSize = size;
+        }
+    }
+    return leastLoadedQueueId;
+}
+
 template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
 bool
 Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::canTrimContext(const ICoroContextBasePtr& ctx,
@@ -565,5 +1356,68 @@ Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(std::chrono::millisecon
     return future->waitFor(timeout) == std::future_status::ready;
 }
 
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(const SequenceKey& sequenceKey,
+                                                         std::chrono::milliseconds timeout)
+{
+    return drain(std::vector<SequenceKey>(1, sequenceKey), timeout);
+}
+
+template <class SequenceKey, class Hash, class KeyEqual, class Allocator>
+bool
+Sequencer<SequenceKey, Hash, KeyEqual, Allocator>::drain(const std::vector<SequenceKey>& sequenceKeys,
+                                                         std::chrono::milliseconds timeout)
+{
+    PartitionKeys partitionKeys(_partitions.size());
+    for (const SequenceKey& sequenceKey : sequenceKeys)
+    {
+        partitionKeys[_hash(sequenceKey) % _partitions.size()].push_back(sequenceKey);
+    }
+    auto drainFunc = [this, partitionKeys](VoidContextPtr ctx)->int
+    {
+        // The last contexts of the keys are read on the control queue of their partition, behind the
+        // scheduling of the tasks already enqueued, and then waited on here without blocking the control queue.
+        std::vector<CoroContextPtr<std::vector<ICoroContextBasePtr>>> results;
+        for (size_t i = 0; i < partitionKeys.size(); ++i)
+        {
+            if (partitionKeys[i].empty())
+            {
+                continue;
+            }
+            Partition& partition = *_partitions[i];
+            const std::vector<SequenceKey>& keys = partitionKeys[i];
+            auto contextsFunc = [&partition, &keys](CoroContextPtr<std::vector<ICoroContextBasePtr>> ctx)->int
+            {
+                std::vector<ICoroContextBasePtr> contexts;
+                contexts.reserve(keys.size() + 1);
+                for (const SequenceKey& sequenceKey : keys)
+                {
+                    typename ContextMap::const_iterator ctxIt = partition._contexts.find(sequenceKey);
+                    if ((ctxIt != partition._contexts.end()) && isPendingContext(ctx, ctxIt->second._context))
+                    {
+                        contexts.push_back(ctxIt->second._context);
+                    }
+                }
+                if (isPendingContext(ctx, partition._universalContext._context))
+                {
+                    contexts.push_back(partition._universalContext._context);
+                }
+                return ctx->set(std::move(contexts));
+            };
+            results.push_back(ctx->post(partition._queueId, false, std::move(contextsFunc)));
+        }
+        for (auto&& result : results)
+        {
+            for (const ICoroContextBasePtr& context : result->get(ctx))
+            {
+                context->wait(ctx);
+            }
+        }
+        return 0;
+    };
+    return _dispatcher.post(std::move(drainFunc))->waitFor(timeout) == std::future_status::ready;
+}
+
 
 }}
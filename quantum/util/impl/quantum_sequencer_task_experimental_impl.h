@@ -30,19 +30,26 @@ SequencerTask<SequenceKey>::SequencerTask(
     bool universal,
     void* opaque,
     int queueId,
-    bool isHighPriority) :
+    bool isHighPriority,
+    std::chrono::steady_clock::time_point enqueueTime) :
 _func(std::move(func)),
 _pendingKeyCount(0),
 _universal(universal),
 _opaque(opaque),
 _queueId(queueId),
-_isHighPriority(isHighPriority)
+_isHighPriority(isHighPriority),
+_enqueueTime(enqueueTime),
+_fairShareGroup(0),
+_fairShareWeight(0)
 {
 }
 
 template <class SequenceKey>
 SequencerKeyData<SequenceKey>::SequencerKeyData() :
-_stats(std::make_shared<SequenceKeyStatisticsWriter>())
+_stats(std::make_shared<SequenceKeyStatisticsWriter>()),
+_key(nullptr),
+_isIdleTracked(false),
+_queueId((int)IQueue::QueueId::Any)
 {
 }
 
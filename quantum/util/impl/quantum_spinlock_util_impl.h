@@ -57,12 +57,15 @@ void SpinLockUtil::pauseCPU()
 
 inline
 bool SpinLockUtil::lockWrite(std::atomic_uint32_t &flag,
-                             LockTraits::Attempt attempt)
+                             LockTraits::Attempt attempt,
+                             AdaptiveSpinLimits* limits,
+                             LockProfiler::Counters* counters)
 {
+    Contention contention(limits, counters);
     size_t numBackoffs = 0;
 spin:
     if (attempt == LockTraits::Attempt::Unlimited) {
-        spinWaitWriter(flag);
+        spinWaitWriter(flag, contention);
     }
     //Try acquiring the lock
     uint32_t oldValue = set(0, 0);
@@ -76,7 +79,7 @@ spin:
             {
                 return false;
             }
-            backoff(numBackoffs);
+            backoff(numBackoffs, contention);
             //spin wait again
             goto spin;
         }
@@ -84,35 +87,43 @@ spin:
         newValue = set(upgrades(oldValue), -1);
         pauseCPU();
     }
+    contention.acquired();
     return true;
 }
 
 inline
 bool SpinLockUtil::upgradeToWrite(std::atomic_uint32_t &flag,
-                                  LockTraits::Attempt attempt)
+                                  LockTraits::Attempt attempt,
+                                  AdaptiveSpinLimits* limits,
+                                  LockProfiler::Counters* counters)
 {
     bool pendingUpgrade = false;
-    return upgradeToWriteImpl(flag, pendingUpgrade, attempt);
+    Contention contention(limits, counters);
+    return upgradeToWriteImpl(flag, pendingUpgrade, attempt, contention);
 }
 
 inline
 bool SpinLockUtil::upgradeToWrite(std::atomic_uint32_t &flag,
                                   bool& pendingUpgrade,
-                                  LockTraits::Attempt attempt)
+                                  LockTraits::Attempt attempt,
+                                  AdaptiveSpinLimits* limits,
+                             LockProfiler::Counters* counters)
 {
-    return upgradeToWriteImpl(flag, pendingUpgrade, attempt);
+    Contention contention(limits, counters);
+    return upgradeToWriteImpl(flag, pendingUpgrade, attempt, contention);
 }
 
 inline
 bool SpinLockUtil::upgradeToWriteImpl(std::atomic_uint32_t &flag,
                                       bool& pendingUpgrade,
-                                      LockTraits::Attempt attempt)
+                                      LockTraits::Attempt attempt,
+                                      Contention& contention)
 {
     size_t numBackoffs = 0;
 spin:
     if (pendingUpgrade && (attempt == LockTraits::Attempt::Unlimited))
     {
-        spinWaitWriter(flag);
+        spinWaitWriter(flag, contention);
     }
     //Try acquiring the lock
     uint32_t oldValue = set(0, 1);
@@ -148,7 +159,7 @@ spin:
                 {
                     return false;
                 }
-                backoff(numBackoffs);
+                backoff(numBackoffs, contention);
                 //spin wait until we can upgrade again
                 goto spin;
             }
@@ -166,24 +177,28 @@ spin:
         {
             return false; //we will get called again
         }
-        backoff(numBackoffs);
+        backoff(numBackoffs, contention);
         //spin wait until we can upgrade again
         goto spin;
     }
     //We terminated the loop either from H|0->H-1|-1 OR H|1->H|-1 and obtained the lock
     assert((owners(oldValue) == 0) || (owners(oldValue) == 1));
+    contention.acquired();
     return true;
 }
 
 inline
 bool SpinLockUtil::lockRead(std::atomic_uint32_t &flag,
-                            LockTraits::Attempt attempt)
+                            LockTraits::Attempt attempt,
+                            AdaptiveSpinLimits* limits,
+                            LockProfiler::Counters* counters)
 {
+    Contention contention(limits, counters);
     size_t numBackoffs = 0;
 spin:
     if (attempt == LockTraits::Attempt::Unlimited)
     {
-        spinWaitReader(flag);
+        spinWaitReader(flag, contention);
     }
     //Try acquiring the lock
     uint32_t oldValue = set(0, 0);
@@ -197,7 +212,7 @@ spin:
             {
                 return false;
             }
-            backoff(numBackoffs);
+            backoff(numBackoffs, contention);
             //spin wait again
             goto spin;
         }
@@ -205,6 +220,7 @@ spin:
         pauseCPU();
     }
     //We obtained the lock so exit loop
+    contention.acquired();
     return true;
 }
 
@@ -259,17 +275,20 @@ void SpinLockUtil::unlockWrite(std::atomic_uint32_t &flag)
 }
 
 inline
-void SpinLockUtil::yieldOrSleep(size_t& num)
+void SpinLockUtil::yieldOrSleep(size_t& num, Contention& contention)
 {
     if (num < SpinLockTraits::numYieldsBeforeSleep())
     {
         ++num;
+        contention.yielded();
         std::this_thread::yield();
     }
     else
     {
-        assert(SpinLockTraits::sleepDuration() >= std::chrono::microseconds::zero());
-        std::this_thread::sleep_for(SpinLockTraits::sleepDuration());
+        std::chrono::microseconds sleepDuration = contention.sleepDuration();
+        assert(sleepDuration >= std::chrono::microseconds::zero());
+        contention.slept();
+        std::this_thread::sleep_for(sleepDuration);
     }
 }
 
@@ -298,19 +317,21 @@ size_t SpinLockUtil::generateBackoff()
 }
 
 inline
-void SpinLockUtil::backoff(size_t& num)
+void SpinLockUtil::backoff(size_t& num, Contention& contention)
 {
+    const size_t limit = contention.spinLimit();
     if (num == 0)
     {
         num = generateBackoff();
     }
-    else if (num < SpinLockTraits::maxSpins())
+    else if (num < limit)
     {
         if (SpinLockTraits::backoffPolicy() == SpinLockTraits::BackoffPolicy::Linear)
         {
             num += SpinLockTraits::minSpins();
         }
-        else if (SpinLockTraits::backoffPolicy() == SpinLockTraits::BackoffPolicy::Exponential)
+        else if ((SpinLockTraits::backoffPolicy() == SpinLockTraits::BackoffPolicy::Exponential) ||
+                 (SpinLockTraits::backoffPolicy() == SpinLockTraits::BackoffPolicy::Adaptive))
         {
             num *= 2;
         }
@@ -320,12 +341,13 @@ void SpinLockUtil::backoff(size_t& num)
             num = generateBackoff();
         }
         //Check that we don't exceed max spins
-        if (num > SpinLockTraits::maxSpins())
+        if (num > limit)
         {
             //Reset back to initial value
             num = generateBackoff();
         }
     }
+    contention.spin(num);
     //Spin
     for (size_t i = 0; i < num; ++i)
     {
@@ -334,28 +356,32 @@ void SpinLockUtil::backoff(size_t& num)
 }
 
 inline
-void SpinLockUtil::spinWaitWriter(std::atomic_uint32_t& flag)
+void SpinLockUtil::spinWaitWriter(std::atomic_uint32_t& flag, Contention& contention)
 {
+    const size_t limit = contention.spinLimit();
     size_t numIters = 0;
     size_t numYields = 0;
     while (owners(flag.load(std::memory_order_acquire)) != 0)
     {
-        if (numIters < SpinLockTraits::maxSpins())
+        if (numIters < limit)
         {
             ++numIters;
+            contention.spin(1);
             pauseCPU();
         }
         else
         {
             //Yield or sleep the thread instead of spinning
-            yieldOrSleep(numYields);
+            contention.spinLimitReached();
+            yieldOrSleep(numYields, contention);
         }
     }
 }
 
 inline
-void SpinLockUtil::spinWaitReader(std::atomic_uint32_t& flag)
+void SpinLockUtil::spinWaitReader(std::atomic_uint32_t& flag, Contention& contention)
 {
+    const size_t limit = contention.spinLimit();
     size_t numIters = 0;
     size_t numYields = 0;
     while (true)
@@ -363,15 +389,17 @@ void SpinLockUtil::spinWaitReader(std::atomic_uint32_t& flag)
         uint32_t v = flag.load(std::memory_order_acquire);
         if ((owners(v) == -1) || (upgrades(v) > 0))
         {
-            if (numIters < SpinLockTraits::maxSpins())
+            if (numIters < limit)
             {
                 ++numIters;
+                contention.spin(1);
                 pauseCPU();
             }
             else
             {
                 //Yield or sleep the thread instead of spinning
-                yieldOrSleep(numYields);
+                contention.spinLimitReached();
+                yieldOrSleep(numYields, contention);
             }
         }
         else
@@ -381,6 +409,99 @@ void SpinLockUtil::spinWaitReader(std::atomic_uint32_t& flag)
     }
 }
 
+template <class PREDICATE>
+void SpinLockUtil::spinWait(PREDICATE&& isBlocked,
+                            AdaptiveSpinLimits* limits)
+{
+    Contention contention(limits, nullptr);
+    const size_t limit = contention.spinLimit();
+    size_t numIters = 0;
+    size_t numYields = 0;
+    while (isBlocked())
+    {
+        if (numIters < limit)
+        {
+            ++numIters;
+            contention.spin(1);
+            pauseCPU();
+        }
+        else
+        {
+            //Yield or sleep the thread instead of spinning
+            contention.spinLimitReached();
+            yieldOrSleep(numYields, contention);
+        }
+    }
+    contention.acquired();
+}
+
+//==============================================================================
+//                            SpinLockUtil::Contention
+//==============================================================================
+inline
+SpinLockUtil::Contention::Contention(AdaptiveSpinLimits* limits,
+                                     LockProfiler::Counters* counters) :
+    _limits(SpinLockTraits::backoffPolicy() == SpinLockTraits::BackoffPolicy::Adaptive ? limits : nullptr),
+    _counters(counters)
+{
+}
+
+inline
+size_t SpinLockUtil::Contention::spinLimit() const
+{
+    return _limits ? _limits->spinLimit() : SpinLockTraits::maxSpins();
+}
+
+inline
+std::chrono::microseconds SpinLockUtil::Contention::sleepDuration() const
+{
+    return _limits ? _limits->sleepDuration() : SpinLockTraits::sleepDuration();
+}
+
+inline
+void SpinLockUtil::Contention::spin(size_t num)
+{
+    if (_limits && (_spins == 0))
+    {
+        //Only contended acquisitions pay for reading the clock
+        _start = std::chrono::steady_clock::now();
+    }
+    _spins += num;
+}
+
+inline
+void SpinLockUtil::Contention::yielded()
+{
+    ++_yields;
+}
+
+inline
+void SpinLockUtil::Contention::slept()
+{
+    ++_sleeps;
+}
+
+inline
+void SpinLockUtil::Contention::spinLimitReached()
+{
+    _spinLimitReached = true;
+}
+
+inline
+void SpinLockUtil::Contention::acquired()
+{
+    if (_limits && (_spins > 0))
+    {
+        _limits->update(_spins, _spinLimitReached, std::chrono::steady_clock::now() - _start);
+    }
+    if (_counters)
+    {
+        _counters->_spins = _spins;
+        _counters->_yields = _yields;
+        _counters->_sleeps = _sleeps;
+    }
+}
+
 inline
 bool SpinLockUtil::isLocked(const std::atomic_uint32_t& flag)
 {
@@ -19,7 +19,11 @@
 //#################################### IMPLEMENTATIONS #########################################
 //##############################################################################################
 #include <quantum/util/quantum_future_joiner.h>
+#include <quantum/util/impl/quantum_parallel_for_partition_impl.h>
 #include <quantum/quantum_traits.h>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
 
 namespace Bloomberg {
 namespace quantum {
@@ -164,6 +168,226 @@ int bindIo2(std::shared_ptr<Promise<RET>> promise,
     return (int)ITask::RetCode::Exception;
 }
 
+//==============================================================================================
+//                                      MapReduce Helpers
+//==============================================================================================
+template <class COMBINED, class KEY, class MAPPED_TYPE>
+void combineMapped(COMBINED& combined,
+                   std::pair<KEY, MAPPED_TYPE>&& mapperResult,
+                   const Functions::CombineFunc<MAPPED_TYPE>& combiner)
+{
+    auto it = combined.find(mapperResult.first);
+    if (it == combined.end())
+    {
+        combined.emplace(std::move(mapperResult));
+    }
+    else
+    {
+        combiner(it->second, std::move(mapperResult.second));
+    }
+}
+
+template <class COMBINED, class KEY, class MAPPED_TYPE>
+void extractCombined(COMBINED& combined,
+                     std::vector<std::pair<KEY, MAPPED_TYPE>>& mapperOutput)
+{
+    mapperOutput.reserve(mapperOutput.size() + combined.size());
+    while (!combined.empty())
+    {
+        auto node = combined.extract(combined.begin());
+        mapperOutput.emplace_back(std::move(node.key()), std::move(node.mapped()));
+    }
+}
+
+//==============================================================================================
+//                                      Reduce Helpers
+//==============================================================================================
+//Transform function of a plain reduce
+struct ReduceIdentity
+{
+    template <class V>
+    V&& operator()(V&& value) const { return std::forward<V>(value); }
+};
+
+//Splits [0,num) into one contiguous chunk per coroutine queue of the Any range. If 'maxChunkSize'
+//is set, more chunks are made as needed so that none of them is larger.
+inline
+std::vector<std::pair<size_t, size_t>> makeChunks(const VoidContextPtr& ctx, size_t num, size_t maxChunkSize = 0)
+{
+    const std::pair<int, int>& queueIdRange = ctx->getCoroQueueIdRangeForAny();
+    size_t numChunks = (size_t)(queueIdRange.second - queueIdRange.first + 1);
+    if (maxChunkSize)
+    {
+        numChunks = std::max(numChunks, (num + maxChunkSize - 1)/maxChunkSize);
+    }
+    numChunks = std::min(num, numChunks);
+    std::vector<std::pair<size_t, size_t>> chunks;
+    chunks.reserve(numChunks);
+    size_t begin = 0;
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        size_t end = begin + num/numChunks + ((i < num%numChunks) ? 1 : 0);
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+    return chunks;
+}
+
+//==============================================================================================
+//                                      Sort Helpers
+//==============================================================================================
+//Maximum number of elements handled by a single sort, merge or partition task. Small enough for
+//a task to take around a millisecond with a cheap comparison, so that the coroutines sharing its
+//queue are not starved.
+const size_t sortBlockSize = 1 << 14;
+
+//Runs task(i) for every i in [0,numTasks) with one worker per coroutine queue of the Any range.
+//Each worker runs every numWorkers-th task and yields in between.
+template <class TASK>
+void runOnAnyQueues(const VoidContextPtr& ctx, size_t numTasks, const TASK& task)
+{
+    const std::pair<int, int>& queueIdRange = ctx->getCoroQueueIdRangeForAny();
+    size_t numWorkers = std::min(numTasks, (size_t)(queueIdRange.second - queueIdRange.first + 1));
+    std::vector<CoroContextPtr<int>> asyncResults;
+    asyncResults.reserve(numWorkers);
+    for (size_t worker = 0; worker < numWorkers; ++worker)
+    {
+        asyncResults.emplace_back(ctx->template post2(queueIdRange.first + (int)worker, false,
+            [worker, numWorkers, numTasks, &task](VoidContextPtr ctx)->int
+        {
+            for (size_t i = worker; i < numTasks; i += numWorkers)
+            {
+                task(i);
+                ctx->yield();
+            }
+            return 0;
+        }));
+    }
+    //The task must outlive all the workers, so wait for all of them before propagating the first exception
+    for (auto&& asyncResult : asyncResults)
+    {
+        asyncResult->wait(ctx);
+    }
+    for (auto&& asyncResult : asyncResults)
+    {
+        asyncResult->get(ctx);
+    }
+}
+
+//Returns how many elements of the sorted range 'left' are among the first 'num' elements of the
+//stable merge of 'left' and 'right', as produced by std::merge().
+template <class IT, class COMPARE>
+size_t mergePathSplit(IT left, size_t leftSize, IT right, size_t rightSize, size_t num, COMPARE& compare)
+{
+    size_t low = (num > rightSize) ? num - rightSize : 0;
+    size_t high = std::min(num, leftSize);
+    while (low < high)
+    {
+        size_t mid = low + (high - low)/2;
+        if (compare(*(right + (num - mid - 1)), *(left + mid)))
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+//A slice of the merge of two adjacent sorted runs. The elements of both sub-ranges are merged
+//into the output starting at '_output'.
+struct MergeSlice
+{
+    size_t  _leftBegin;
+    size_t  _leftEnd;
+    size_t  _rightBegin;
+    size_t  _rightEnd;
+    size_t  _output;
+};
+
+//Merges adjacent pairs of sorted runs from 'input' into 'output' in parallel and returns the merged runs.
+//An odd run out is moved as is. Both ranges are indexed the same way.
+template <class INPUT_IT, class OUTPUT_IT, class COMPARE>
+std::vector<std::pair<size_t, size_t>> mergeSortedRuns(const VoidContextPtr& ctx,
+                                                       INPUT_IT input,
+                                                       OUTPUT_IT output,
+                                                       const std::vector<std::pair<size_t, size_t>>& runs,
+                                                       COMPARE& compare)
+{
+    std::vector<std::pair<size_t, size_t>> mergedRuns;
+    mergedRuns.reserve((runs.size() + 1)/2);
+    std::vector<MergeSlice> slices;
+    for (size_t r = 0; r < runs.size(); r += 2)
+    {
+        size_t leftBegin = runs[r].first;
+        size_t rightBegin = runs[r].second;
+        size_t rightEnd = (r + 1 < runs.size()) ? runs[r + 1].second : rightBegin;
+        size_t leftSize = rightBegin - leftBegin;
+        size_t rightSize = rightEnd - rightBegin;
+        mergedRuns.emplace_back(leftBegin, rightEnd);
+        //cut the merge along its merge path so that every slice outputs at most sortBlockSize elements
+        size_t sliceBegin = 0;
+        size_t splitBegin = 0;
+        while (sliceBegin < leftSize + rightSize)
+        {
+            size_t sliceEnd = std::min(sliceBegin + sortBlockSize, leftSize + rightSize);
+            size_t splitEnd = mergePathSplit(input + leftBegin, leftSize, input + rightBegin, rightSize, sliceEnd, compare);
+            slices.push_back({leftBegin + splitBegin,
+                              leftBegin + splitEnd,
+                              rightBegin + (sliceBegin - splitBegin),
+                              rightBegin + (sliceEnd - splitEnd),
+                              leftBegin + sliceBegin});
+            sliceBegin = sliceEnd;
+            splitBegin = splitEnd;
+        }
+    }
+    runOnAnyQueues(ctx, slices.size(), [input, output, &slices, &compare](size_t i)
+    {
+        const MergeSlice& slice = slices[i];
+        std::merge(std::make_move_iterator(input + slice._leftBegin),
+                   std::make_move_iterator(input + slice._leftEnd),
+                   std::make_move_iterator(input + slice._rightBegin),
+                   std::make_move_iterator(input + slice._rightEnd),
+                   output + slice._output,
+                   compare);
+    });
+    return mergedRuns;
+}
+
+//Iterates over the indexes of an ordered list of disjoint, non-empty index ranges, starting at 'offset'
+//indexes from the beginning of the first range
+class IndexRangeCursor
+{
+public:
+    IndexRangeCursor(const std::vector<std::pair<size_t, size_t>>& ranges, size_t offset) :
+        _ranges(ranges)
+    {
+        while (offset >= _ranges[_range].second - _ranges[_range].first)
+        {
+            offset -= _ranges[_range].second - _ranges[_range].first;
+            ++_range;
+        }
+        _index = _ranges[_range].first + offset;
+    }
+    
+    size_t next()
+    {
+        size_t index = _index++;
+        if ((_index == _ranges[_range].second) && (_range + 1 < _ranges.size()))
+        {
+            _index = _ranges[++_range].first;
+        }
+        return index;
+    }
+    
+private:
+    const std::vector<std::pair<size_t, size_t>>&   _ranges;
+    size_t                                          _range{0};
+    size_t                                          _index{0};
+};
+
 //==============================================================================================
 //                                      Bind Utils
 //==============================================================================================
@@ -255,6 +479,93 @@ Util::forEachBatchCoro(VoidContextPtr ctx,
     return FutureJoiner<std::vector<RET>>()(*ctx, std::move(asyncResults))->get(ctx);
 }
 
+template <class INPUT_IT, class FUNC>
+int Util::parallelForCoro(VoidContextPtr ctx,
+                          INPUT_IT first,
+                          size_t num,
+                          FUNC&& func,
+                          size_t grainSize)
+{
+    //chunk duration targeted by the automatic grain size. Long enough to amortize the partition
+    //locking and the yield between chunks, short enough to keep the tail of the loop balanced.
+    const std::chrono::microseconds targetChunkDuration(100);
+    
+    const std::pair<int, int>& queueIdRange = ctx->getCoroQueueIdRangeForAny();
+    size_t numWorkers = std::min(num, (size_t)(queueIdRange.second - queueIdRange.first + 1));
+    if (numWorkers == 0)
+    {
+        return 0; //nothing to do
+    }
+    ParallelForPartition partition(num, numWorkers);
+    std::vector<CoroContextPtr<int>> asyncResults;
+    asyncResults.reserve(numWorkers);
+    
+    // Post one worker on each coroutine queue
+    for (size_t worker = 0; worker < numWorkers; ++worker)
+    {
+        asyncResults.emplace_back(ctx->template post2(queueIdRange.first + (int)worker, false,
+            [first, worker, grainSize, targetChunkDuration, &partition, &func](VoidContextPtr ctx) mutable ->int
+        {
+            size_t chunkSize = grainSize ? grainSize : 1;
+            size_t begin, end;
+            try
+            {
+                while (true)
+                {
+                    if (!partition.next(worker, chunkSize, begin, end))
+                    {
+                        if (partition.steal(worker))
+                        {
+                            continue;
+                        }
+                        break; //all the sub-ranges are empty
+                    }
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    INPUT_IT it = first + begin;
+                    for (size_t i = begin; i < end; ++i, ++it)
+                    {
+                        func(ctx, *it);
+                    }
+                    if (!grainSize)
+                    {
+                        //converge towards the target duration as the cost of the elements varies
+                        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+                        if (elapsed < targetChunkDuration/2)
+                        {
+                            chunkSize *= 2;
+                        }
+                        else if ((elapsed > targetChunkDuration*2) && (chunkSize > 1))
+                        {
+                            chunkSize /= 2;
+                        }
+                    }
+                    //let other coroutines on this queue run between chunks
+                    ctx->yield();
+                }
+            }
+            catch (...)
+            {
+                //stop the other workers early
+                partition.cancel();
+                throw;
+            }
+            return 0;
+        }));
+    }
+    
+    //The partition and the function must outlive all the workers, so wait for all of them
+    //before propagating the first exception.
+    for (auto&& asyncResult : asyncResults)
+    {
+        asyncResult->wait(ctx);
+    }
+    for (auto&& asyncResult : asyncResults)
+    {
+        asyncResult->get(ctx);
+    }
+    return 0;
+}
+
 template <class KEY,
           class MAPPED_TYPE,
           class REDUCED_TYPE,
@@ -309,7 +620,8 @@ Util::mapReduceBatchCoro(VoidContextPtr ctx,
                          INPUT_IT inputIt,
                          size_t num,
                          const Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>& mapper,
-                         const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer)
+                         const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer,
+                         const Functions::CombineFunc<MAPPED_TYPE>& combiner)
 {
     // Typedefs
     using MappedResult = std::pair<KEY, MAPPED_TYPE>;
@@ -321,7 +633,51 @@ Util::mapReduceBatchCoro(VoidContextPtr ctx,
     using ReducerOutput = std::map<KEY, REDUCED_TYPE>;
     
     // Map stage
-    IndexerInput indexerInput = ctx->forEachBatch(inputIt, num, mapper)->get(ctx);
+    IndexerInput indexerInput;
+    if (!combiner)
+    {
+        indexerInput = ctx->forEachBatch(inputIt, num, mapper)->get(ctx);
+    }
+    else
+    {
+        //Same batches as forEachBatch() but each batch combines the values of a key before
+        //emitting them, so it outputs at most one value per key.
+        size_t numBatches = std::min(num, (size_t)ctx->getNumCoroutineThreads());
+        size_t numPerBatch = numBatches ? num/numBatches : 0;
+        size_t remainder = numBatches ? num%numBatches : 0;
+        std::vector<CoroContextPtr<std::vector<MapperOutput>>> asyncResults;
+        asyncResults.reserve(numBatches);
+        for (size_t i = 0; i < numBatches; ++i)
+        {
+            size_t batchSize = (i < remainder) ? numPerBatch + 1 : numPerBatch;
+            asyncResults.emplace_back(ctx->template post2([inputIt, batchSize, &mapper, &combiner](VoidContextPtr ctx) mutable
+                                                          ->std::vector<MapperOutput>
+            {
+                std::map<KEY, MAPPED_TYPE> combined;
+                for (size_t j = 0; j < batchSize; ++j, ++inputIt)
+                {
+                    for (auto&& mapperResult : mapper(ctx, *inputIt))
+                    {
+                        combineMapped(combined, std::move(mapperResult), combiner);
+                    }
+                }
+                std::vector<MapperOutput> result(1);
+                extractCombined(combined, result.front());
+                return result;
+            }));
+            std::advance(inputIt, batchSize);
+        }
+        //the mapper and the combiner must outlive all the batches, so wait for all of them
+        //before propagating an exception
+        for (auto&& asyncResult : asyncResults)
+        {
+            asyncResult->wait(ctx);
+        }
+        for (auto&& asyncResult : asyncResults)
+        {
+            indexerInput.emplace_back(asyncResult->get(ctx));
+        }
+    }
     
     // Index stage
     IndexerOutput indexerOutput;
@@ -351,6 +707,501 @@ Util::mapReduceBatchCoro(VoidContextPtr ctx,
     return reducerOutput;
 }
 
+template <class KEY,
+          class MAPPED_TYPE,
+          class REDUCED_TYPE,
+          template <class...> class OUTPUT,
+          class INPUT_IT>
+typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type
+Util::mapReducePartitionedCoro(VoidContextPtr ctx,
+                               INPUT_IT inputIt,
+                               size_t num,
+                               const Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>& mapper,
+                               const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer,
+                               const Functions::CombineFunc<MAPPED_TYPE>& combiner)
+{
+    // Typedefs
+    using MappedResult = std::pair<KEY, MAPPED_TYPE>;
+    using Bucket = std::vector<MappedResult>;
+    using MapperOutput = std::vector<Bucket>; //one bucket per partition
+    using IndexerOutput = std::unordered_map<KEY, std::vector<MAPPED_TYPE>>;
+    using ReducedResults = std::vector<std::pair<KEY, REDUCED_TYPE>>;
+    using ReducerOutput = typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>;
+    
+    // Each coroutine queue maps one batch of the input and indexes and reduces one partition of the keys
+    const std::pair<int, int>& queueIdRange = ctx->getCoroQueueIdRangeForAny();
+    size_t numPartitions = queueIdRange.second - queueIdRange.first + 1;
+    size_t numBatches = std::min(num, numPartitions);
+    size_t numPerBatch = numBatches ? num/numBatches : 0;
+    size_t remainder = numBatches ? num%numBatches : 0;
+    
+    // Map stage
+    std::vector<CoroContextPtr<MapperOutput>> mapResults;
+    mapResults.reserve(numBatches);
+    for (size_t i = 0; i < numBatches; ++i)
+    {
+        size_t batchSize = (i < remainder) ? numPerBatch + 1 : numPerBatch;
+        mapResults.emplace_back(ctx->template post2(queueIdRange.first + (int)i, false,
+            [inputIt, batchSize, numPartitions, &mapper, &combiner](VoidContextPtr ctx) mutable ->MapperOutput
+        {
+            std::hash<KEY> hash;
+            MapperOutput buckets(numPartitions);
+            if (!combiner)
+            {
+                for (size_t j = 0; j < batchSize; ++j, ++inputIt)
+                {
+                    for (auto&& mapperResult : mapper(ctx, *inputIt))
+                    {
+                        buckets[hash(mapperResult.first) % numPartitions].emplace_back(std::move(mapperResult));
+                    }
+                }
+                return buckets;
+            }
+            //emit at most one value per key and partition
+            std::vector<std::unordered_map<KEY, MAPPED_TYPE>> combined(numPartitions);
+            for (size_t j = 0; j < batchSize; ++j, ++inputIt)
+            {
+                for (auto&& mapperResult : mapper(ctx, *inputIt))
+                {
+                    size_t partition = hash(mapperResult.first) % numPartitions;
+                    combineMapped(combined[partition], std::move(mapperResult), combiner);
+                }
+            }
+            for (size_t partition = 0; partition < numPartitions; ++partition)
+            {
+                extractCombined(combined[partition], buckets[partition]);
+            }
+            return buckets;
+        }));
+        std::advance(inputIt, batchSize);
+    }
+    //the mapper and the combiner must outlive all the batches, so wait for all of them before
+    //propagating an exception
+    for (auto&& mapResult : mapResults)
+    {
+        mapResult->wait(ctx);
+    }
+    std::vector<MapperOutput> mapperOutputs;
+    mapperOutputs.reserve(numBatches);
+    for (auto&& mapResult : mapResults)
+    {
+        mapperOutputs.emplace_back(mapResult->get(ctx));
+    }
+    
+    // Index and reduce stages
+    std::vector<CoroContextPtr<ReducedResults>> reduceResults;
+    reduceResults.reserve(numPartitions);
+    for (size_t partition = 0; partition < numPartitions; ++partition)
+    {
+        reduceResults.emplace_back(ctx->template post2(queueIdRange.first + (int)partition, false,
+            [partition, &mapperOutputs, &reducer](VoidContextPtr ctx)->ReducedResults
+        {
+            IndexerOutput indexerOutput;
+            for (auto&& mapperOutput : mapperOutputs)
+            {
+                for (auto&& mapperResult : mapperOutput[partition])
+                {
+                    indexerOutput[std::move(mapperResult.first)].emplace_back(std::move(mapperResult.second));
+                }
+            }
+            ReducedResults reducedResults;
+            reducedResults.reserve(indexerOutput.size());
+            while (!indexerOutput.empty())
+            {
+                auto node = indexerOutput.extract(indexerOutput.begin());
+                reducedResults.emplace_back(reducer(ctx, {std::move(node.key()), std::move(node.mapped())}));
+            }
+            return reducedResults;
+        }));
+    }
+    for (auto&& reduceResult : reduceResults)
+    {
+        reduceResult->wait(ctx);
+    }
+    
+    typename ReducerOutput::Type reducerOutput;
+    for (auto&& reduceResult : reduceResults)
+    {
+        for (auto&& reducedResult : reduceResult->get(ctx))
+        {
+            ReducerOutput::insert(reducerOutput, std::move(reducedResult));
+        }
+    }
+    return reducerOutput;
+}
+
+template <class T, class INPUT_IT, class FUNC>
+T Util::reduceCoro(VoidContextPtr ctx,
+                   INPUT_IT first,
+                   size_t num,
+                   T init,
+                   FUNC&& func)
+{
+    return transformReduceCoro<T, INPUT_IT>(ctx, first, num, std::move(init), func, ReduceIdentity());
+}
+
+template <class T, class INPUT_IT, class REDUCE_FUNC, class TRANSFORM_FUNC>
+T Util::transformReduceCoro(VoidContextPtr ctx,
+                            INPUT_IT first,
+                            size_t num,
+                            T init,
+                            REDUCE_FUNC&& reduceFunc,
+                            TRANSFORM_FUNC&& transformFunc)
+{
+    std::vector<std::pair<size_t, size_t>> chunks = makeChunks(ctx, num);
+    if (chunks.empty())
+    {
+        return init;
+    }
+    int firstQueueId = ctx->getCoroQueueIdRangeForAny().first;
+    
+    // Each chunk is reduced on its own queue without materializing the transformed elements
+    std::vector<CoroContextPtr<T>> nodes;
+    nodes.reserve(2 * chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        size_t begin = chunks[i].first;
+        size_t end = chunks[i].second;
+        nodes.emplace_back(ctx->template post2(firstQueueId + (int)i, false,
+            [first, begin, end, &reduceFunc, &transformFunc](VoidContextPtr)->T
+        {
+            INPUT_IT it = first + begin;
+            T result = transformFunc(*it);
+            for (size_t j = begin + 1; j < end; ++j)
+            {
+                result = reduceFunc(std::move(result), transformFunc(*++it));
+            }
+            return result;
+        }));
+    }
+    
+    // Combine adjacent partial results pairwise, level by level. Each combination runs on the queue
+    // of its left-most chunk and the order of the elements is preserved.
+    size_t levelBegin = 0;
+    size_t levelEnd = nodes.size();
+    for (size_t stride = 1; levelEnd - levelBegin > 1; stride *= 2)
+    {
+        for (size_t i = levelBegin; i < levelEnd; i += 2)
+        {
+            if (i + 1 == levelEnd)
+            {
+                nodes.emplace_back(nodes[i]); //odd node out is promoted to the next level
+                break;
+            }
+            CoroContextPtr<T> left = nodes[i];
+            CoroContextPtr<T> right = nodes[i + 1];
+            int queueId = firstQueueId + (int)((i - levelBegin) * stride);
+            nodes.emplace_back(ctx->template post2(queueId, false,
+                [left, right, &reduceFunc](VoidContextPtr ctx)->T
+            {
+                return reduceFunc(left->get(ctx), right->get(ctx));
+            }));
+        }
+        levelBegin = levelEnd;
+        levelEnd = nodes.size();
+    }
+    
+    //The functions must outlive all the coroutines, so wait for all of them before propagating an exception
+    for (auto&& node : nodes)
+    {
+        node->wait(ctx);
+    }
+    return reduceFunc(std::move(init), nodes.back()->get(ctx));
+}
+
+template <class INPUT_IT, class OUTPUT_IT, class FUNC>
+OUTPUT_IT Util::inclusiveScanCoro(VoidContextPtr ctx,
+                                  INPUT_IT first,
+                                  size_t num,
+                                  OUTPUT_IT outputIt,
+                                  FUNC&& func)
+{
+    using T = typename std::iterator_traits<INPUT_IT>::value_type;
+    return scanCoro<T>(ctx, first, num, outputIt, nullptr, func);
+}
+
+template <class T, class INPUT_IT, class OUTPUT_IT, class FUNC>
+OUTPUT_IT Util::exclusiveScanCoro(VoidContextPtr ctx,
+                                  INPUT_IT first,
+                                  size_t num,
+                                  OUTPUT_IT outputIt,
+                                  T init,
+                                  FUNC&& func)
+{
+    return scanCoro<T>(ctx, first, num, outputIt, &init, func);
+}
+
+template <class T, class INPUT_IT, class OUTPUT_IT, class FUNC>
+OUTPUT_IT Util::scanCoro(VoidContextPtr ctx,
+                         INPUT_IT first,
+                         size_t num,
+                         OUTPUT_IT outputIt,
+                         const T* init,
+                         FUNC& func)
+{
+    //Scans a chunk starting from 'prefix', which is the reduction of all the preceding elements, and returns
+    //the reduction up to the end of the chunk. A null prefix is only passed for the first chunk of an inclusive scan.
+    auto scanChunk = [first, outputIt, init, &func](size_t begin, size_t end, const T* prefix)->T
+    {
+        INPUT_IT it = first + begin;
+        OUTPUT_IT out = outputIt + begin;
+        if (init)
+        {
+            T sum = *prefix;
+            for (size_t i = begin; i < end; ++i, ++it, ++out)
+            {
+                T next = func(sum, *it); //read the input before writing it in case the scan is in-place
+                *out = std::move(sum);
+                sum = std::move(next);
+            }
+            return sum;
+        }
+        T sum = prefix ? func(*prefix, *it) : T(*it);
+        *out = sum;
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            sum = func(std::move(sum), *++it);
+            *++out = sum;
+        }
+        return sum;
+    };
+    
+    std::vector<std::pair<size_t, size_t>> chunks = makeChunks(ctx, num);
+    if (chunks.empty())
+    {
+        return outputIt;
+    }
+    if (chunks.size() == 1)
+    {
+        scanChunk(chunks[0].first, chunks[0].second, init);
+        return outputIt + num;
+    }
+    int firstQueueId = ctx->getCoroQueueIdRangeForAny().first;
+    
+    // Pass 1: the first chunk is scanned right away while the following ones are only reduced.
+    // The last chunk does not contribute to any prefix.
+    std::vector<CoroContextPtr<T>> sums;
+    sums.reserve(chunks.size() - 1);
+    for (size_t i = 0; i + 1 < chunks.size(); ++i)
+    {
+        size_t begin = chunks[i].first;
+        size_t end = chunks[i].second;
+        sums.emplace_back(ctx->template post2(firstQueueId + (int)i, false,
+            [first, begin, end, init, &func, &scanChunk](VoidContextPtr)->T
+        {
+            if (begin == 0)
+            {
+                return scanChunk(begin, end, init);
+            }
+            INPUT_IT it = first + begin;
+            T sum = *it;
+            for (size_t j = begin + 1; j < end; ++j)
+            {
+                sum = func(std::move(sum), *++it);
+            }
+            return sum;
+        }));
+    }
+    for (auto&& sum : sums)
+    {
+        sum->wait(ctx);
+    }
+    
+    // The prefix of each chunk is the reduction of all the chunks before it
+    std::vector<T> prefixes;
+    prefixes.reserve(sums.size());
+    for (auto&& sum : sums)
+    {
+        if (prefixes.empty())
+        {
+            prefixes.emplace_back(sum->get(ctx));
+        }
+        else
+        {
+            prefixes.emplace_back(func(prefixes.back(), sum->get(ctx)));
+        }
+    }
+    
+    // Pass 2: scan the remaining chunks from their prefix
+    std::vector<CoroContextPtr<int>> scans;
+    scans.reserve(chunks.size() - 1);
+    for (size_t i = 1; i < chunks.size(); ++i)
+    {
+        size_t begin = chunks[i].first;
+        size_t end = chunks[i].second;
+        const T* prefix = &prefixes[i - 1];
+        scans.emplace_back(ctx->template post2(firstQueueId + (int)i, false,
+            [begin, end, prefix, &scanChunk](VoidContextPtr)->int
+        {
+            scanChunk(begin, end, prefix);
+            return 0;
+        }));
+    }
+    for (auto&& scan : scans)
+    {
+        scan->wait(ctx);
+    }
+    for (auto&& scan : scans)
+    {
+        scan->get(ctx);
+    }
+    return outputIt + num;
+}
+
+template <class RANDOM_IT, class COMPARE>
+int Util::sortCoro(VoidContextPtr ctx,
+                   RANDOM_IT first,
+                   size_t num,
+                   COMPARE&& compare)
+{
+    using T = typename std::iterator_traits<RANDOM_IT>::value_type;
+    std::vector<std::pair<size_t, size_t>> runs = makeChunks(ctx, num, sortBlockSize);
+    if (runs.size() <= 1)
+    {
+        std::sort(first, first + num, compare);
+        return 0;
+    }
+    
+    // Sort each block
+    runOnAnyQueues(ctx, runs.size(), [first, &runs, &compare](size_t i)
+    {
+        std::sort(first + runs[i].first, first + runs[i].second, compare);
+    });
+    
+    // Merge the sorted blocks pairwise, going back and forth between the range and a buffer
+    std::vector<T> buffer(num);
+    bool isInBuffer = false;
+    while (runs.size() > 1)
+    {
+        runs = isInBuffer ? mergeSortedRuns(ctx, buffer.begin(), first, runs, compare) :
+                            mergeSortedRuns(ctx, first, buffer.begin(), runs, compare);
+        isInBuffer = !isInBuffer;
+    }
+    if (isInBuffer)
+    {
+        std::vector<std::pair<size_t, size_t>> blocks = makeChunks(ctx, num, sortBlockSize);
+        runOnAnyQueues(ctx, blocks.size(), [first, &blocks, &buffer](size_t i)
+        {
+            std::move(buffer.begin() + blocks[i].first, buffer.begin() + blocks[i].second, first + blocks[i].first);
+        });
+    }
+    return 0;
+}
+
+template <class RANDOM_IT, class PREDICATE>
+RANDOM_IT Util::partitionCoro(VoidContextPtr ctx,
+                              RANDOM_IT first,
+                              size_t num,
+                              PREDICATE&& predicate)
+{
+    std::vector<std::pair<size_t, size_t>> blocks = makeChunks(ctx, num, sortBlockSize);
+    if (blocks.size() <= 1)
+    {
+        return std::partition(first, first + num, predicate);
+    }
+    
+    // Partition each block
+    std::vector<size_t> blockPartitionPoints(blocks.size());
+    runOnAnyQueues(ctx, blocks.size(), [first, &blocks, &blockPartitionPoints, &predicate](size_t i)
+    {
+        blockPartitionPoints[i] = std::partition(first + blocks[i].first, first + blocks[i].second, predicate) - first;
+    });
+    size_t partitionPoint = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        partitionPoint += blockPartitionPoints[i] - blocks[i].first;
+    }
+    
+    // The elements failing the predicate before the partition point are as many as the ones satisfying it
+    // after the partition point. Swap the n-th of the former with the n-th of the latter.
+    std::vector<std::pair<size_t, size_t>> misplacedBefore;
+    std::vector<std::pair<size_t, size_t>> misplacedAfter;
+    size_t numMisplaced = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        size_t begin = blockPartitionPoints[i];
+        size_t end = std::min(blocks[i].second, partitionPoint);
+        if (begin < end)
+        {
+            misplacedBefore.emplace_back(begin, end);
+            numMisplaced += end - begin;
+        }
+        begin = std::max(blocks[i].first, partitionPoint);
+        end = blockPartitionPoints[i];
+        if (begin < end)
+        {
+            misplacedAfter.emplace_back(begin, end);
+        }
+    }
+    size_t numSlices = (numMisplaced + sortBlockSize - 1)/sortBlockSize;
+    runOnAnyQueues(ctx, numSlices, [first, numMisplaced, &misplacedBefore, &misplacedAfter](size_t i)
+    {
+        size_t begin = i * sortBlockSize;
+        size_t end = std::min(begin + sortBlockSize, numMisplaced);
+        IndexRangeCursor before(misplacedBefore, begin);
+        IndexRangeCursor after(misplacedAfter, begin);
+        for (size_t j = begin; j < end; ++j)
+        {
+            std::iter_swap(first + before.next(), first + after.next());
+        }
+    });
+    return first + partitionPoint;
+}
+
+template <class RANDOM_IT, class COMPARE>
+int Util::nthElementCoro(VoidContextPtr ctx,
+                         RANDOM_IT first,
+                         size_t nth,
+                         size_t num,
+                         COMPARE&& compare)
+{
+    using T = typename std::iterator_traits<RANDOM_IT>::value_type;
+    const size_t numSamples = 31;
+    if (nth >= num)
+    {
+        return 0;
+    }
+    
+    // Narrow down the range containing the n-th element with parallel partitions around the median of
+    // a sample, until it is small enough to be handled by std::nth_element()
+    size_t begin = 0;
+    size_t end = num;
+    while (end - begin > sortBlockSize)
+    {
+        std::vector<T> samples;
+        samples.reserve(numSamples);
+        size_t step = (end - begin)/numSamples;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            samples.push_back(*(first + (begin + i*step + step/2)));
+        }
+        std::nth_element(samples.begin(), samples.begin() + numSamples/2, samples.end(), compare);
+        const T& pivot = samples[numSamples/2];
+        
+        size_t lessEnd = partitionCoro(ctx, first + begin, end - begin, [&pivot, &compare](const T& value)->bool
+        {
+            return compare(value, pivot);
+        }) - first;
+        if (nth < lessEnd)
+        {
+            end = lessEnd;
+            continue;
+        }
+        //the pivot is taken from the range so this partition is never empty, which guarantees progress
+        size_t equalEnd = partitionCoro(ctx, first + lessEnd, end - lessEnd, [&pivot, &compare](const T& value)->bool
+        {
+            return !compare(pivot, value);
+        }) - first;
+        if (nth < equalEnd)
+        {
+            return 0;
+        }
+        begin = equalEnd;
+    }
+    std::nth_element(first + begin, first + nth, first + end, compare);
+    return 0;
+}
+
 template <typename RET>
 VoidContextPtr Util::makeVoidContext(CoroContextPtr<RET> ctx)
 {
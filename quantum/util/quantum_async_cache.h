@@ -0,0 +1,154 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+#ifndef BLOOMBERG_QUANTUM_ASYNC_CACHE_H
+#define BLOOMBERG_QUANTUM_ASYNC_CACHE_H
+
+#include <quantum/quantum_dispatcher.h>
+#include <quantum/quantum_promise.h>
+#include <quantum/quantum_spinlock.h>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Bloomberg {
+namespace quantum {
+
+//==============================================================================================
+//                                      class AsyncCache
+//==============================================================================================
+/// @class AsyncCache.
+/// @brief Memoization cache with single-flight loading for coroutines.
+/// @details The first coroutine requesting a missing key starts the loader (either as a coroutine or
+///          as an IO task) and all the concurrent requests for the same key share its result. A value
+///          older than the configured time-to-live is reloaded on its next request and, when the cache
+///          is full, values are evicted in least-recently-used order. Keys are distributed over
+///          independently locked shards so that lookups for different keys rarely contend.
+/// @tparam KEY Type of the cache key.
+/// @tparam VALUE Type of the cached value.
+/// @tparam HASH Hash-function used for distributing and storing keys.
+/// @tparam KEY_EQUAL The equal-function used for storing keys.
+/// @note A loader which throws does not populate the cache. The exception is delivered to all the
+///       callers waiting for that load and the next request will call the loader again.
+template <class KEY,
+          class VALUE,
+          class HASH = std::hash<KEY>,
+          class KEY_EQUAL = std::equal_to<KEY>>
+class AsyncCache
+{
+public:
+    /// @brief Constructor.
+    /// @param[in] maxSize Maximum number of cached values. 0 means unbounded.
+    /// @param[in] timeToLive Amount of time a loaded value remains valid. 0 means values never expire.
+    /// @param[in] numShards Number of independently locked shards.
+    /// @note When bounded, each shard holds at most maxSize/numShards values (rounded up), so the
+    ///       LRU order is maintained per shard. Keys which are still loading are never evicted, so a
+    ///       shard may temporarily exceed its capacity until those loads complete.
+    explicit AsyncCache(size_t maxSize = 0,
+                        std::chrono::milliseconds timeToLive = std::chrono::milliseconds::zero(),
+                        size_t numShards = 16);
+
+    /// @brief Get the value associated with a key, loading it in a coroutine if needed.
+    /// @tparam FUNC Callable object type with signature 'VALUE(VoidContextPtr, Args...)'.
+    /// @tparam ARGS Argument types passed to FUNC.
+    /// @param[in] ctx Current coroutine context.
+    /// @param[in] key The key.
+    /// @param[in] loader Callable which produces the value. Only invoked if the key is not cached
+    ///                   and no other load for this key is in progress.
+    /// @param[in] args Variable list of arguments passed to the loader.
+    /// @return A copy of the value. The calling coroutine yields until the value is loaded.
+    /// @note If the loader throws, the exception is rethrown to every caller waiting for that load.
+    template <class FUNC, class ... ARGS>
+    VALUE get(VoidContextPtr ctx, const KEY& key, FUNC&& loader, ARGS&&... args);
+
+    /// @brief Same as get() except that the loader runs as an IO task.
+    /// @tparam FUNC Callable object type with signature 'VALUE(Args...)'.
+    /// @note Use this version for blocking loaders (e.g. database or network calls).
+    template <class FUNC, class ... ARGS>
+    VALUE getAsyncIo(VoidContextPtr ctx, const KEY& key, FUNC&& loader, ARGS&&... args);
+
+    /// @brief Removes a key from the cache.
+    /// @param[in] key The key.
+    /// @return True if the key was found.
+    /// @note If a load is in progress, its current callers still receive the result but the value is not cached.
+    bool erase(const KEY& key);
+
+    /// @brief Removes all the keys from the cache.
+    void clear();
+
+    /// @brief Number of keys currently tracked, including those being loaded and those expired
+    ///        but not yet evicted.
+    /// @return The number of keys.
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using LruList = std::list<KEY>;
+
+    struct Entry
+    {
+        PromisePtr<VALUE>               _promise;
+        bool                            _isLoaded{false};
+        Clock::time_point               _expiry;
+        typename LruList::iterator      _lruPos;
+    };
+
+    struct Shard
+    {
+        using Map = std::unordered_map<KEY, Entry, HASH, KEY_EQUAL>;
+
+        Shard(size_t capacity, std::chrono::milliseconds timeToLive);
+
+        // Finds a valid entry or inserts an empty one. Returns true if the caller must load the value.
+        bool findOrInsert(const KEY& key, PromisePtr<VALUE>& promise);
+        void loaded(const KEY& key, const PromisePtr<VALUE>& promise, bool succeeded);
+        void erase(typename Map::iterator it);
+        void evict();
+
+        mutable SpinLock                    _spinlock;
+        const size_t                        _capacity;
+        const std::chrono::milliseconds     _timeToLive;
+        Map                                 _entries;
+        LruList                             _lru; //most recent first
+    };
+    using ShardPtr = std::shared_ptr<Shard>;
+
+    const ShardPtr& shard(const KEY& key) const;
+
+    template <class LOADER>
+    static int load(VoidContextPtr ctx,
+                    ShardPtr shard,
+                    KEY key,
+                    PromisePtr<VALUE> promise,
+                    LOADER loader);
+
+    template <class LOADER>
+    static int loadAsyncIo(ShardPtr shard,
+                           KEY key,
+                           PromisePtr<VALUE> promise,
+                           LOADER loader);
+
+    // Members
+    HASH                    _hash;
+    std::vector<ShardPtr>   _shards;
+};
+
+}}
+
+#include <quantum/util/impl/quantum_async_cache_impl.h>
+
+#endif //BLOOMBERG_QUANTUM_ASYNC_CACHE_H
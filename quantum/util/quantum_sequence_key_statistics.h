@@ -18,7 +18,9 @@
 
 #include <vector>
 #include <tuple>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <memory>
 
 namespace Bloomberg {
@@ -32,6 +34,11 @@ namespace quantum {
 class SequenceKeyStatistics
 {
 public:
+    /// @brief Number of latency histogram buckets. Bucket 'i' counts the latencies
+    ///        in the range [2^i, 2^(i+1)) nanoseconds. The last bucket is unbounded.
+    static constexpr size_t numLatencyBuckets = 40;
+    using LatencyHistogram = std::array<size_t, numLatencyBuckets>;
+
     /// @brief Constructor.
     SequenceKeyStatistics() = default;
 
@@ -57,11 +64,62 @@ public:
     /// @return the number of tasks
     size_t getPendingTaskCount() const;
 
+    /// @brief Indicates if the task latencies are collected for the key
+    /// @remark @see SequencerConfiguration::setCollectLatencyStatistics. All the latency getters below
+    ///         return zeros when the latencies are not collected.
+    bool hasLatencyStatistics() const;
+
+    /// @brief Gets the number of completed tasks whose latencies were recorded
+    /// @return the number of tasks
+    size_t getCompletedTaskCount() const;
+
+    /// @brief Gets the histogram of the times the tasks waited between their enqueue and their start
+    /// @return the histogram. See numLatencyBuckets for the bucket ranges.
+    LatencyHistogram getWaitTimeHistogram() const;
+
+    /// @brief Gets the histogram of the times the tasks ran for
+    /// @return the histogram. See numLatencyBuckets for the bucket ranges.
+    LatencyHistogram getRunTimeHistogram() const;
+
+    /// @brief Gets the sum of the wait times of the completed tasks
+    /// @return the total wait time
+    std::chrono::nanoseconds getTotalWaitTime() const;
+
+    /// @brief Gets the sum of the run times of the completed tasks
+    /// @return the total run time
+    std::chrono::nanoseconds getTotalRunTime() const;
+
+    /// @brief Gets the longest wait time of the completed tasks
+    /// @return the maximum wait time
+    std::chrono::nanoseconds getMaxWaitTime() const;
+
+    /// @brief Gets the longest run time of the completed tasks
+    /// @return the maximum run time
+    std::chrono::nanoseconds getMaxRunTime() const;
+
 protected:
+    /// @brief Latency counters, only allocated when they are collected
+    struct Latencies
+    {
+        Latencies();
+        Latencies(const Latencies& that);
+
+        std::atomic_size_t                                  _completedTaskCount{0};
+        std::atomic<std::chrono::nanoseconds::rep>          _totalWaitTime{0};
+        std::atomic<std::chrono::nanoseconds::rep>          _totalRunTime{0};
+        std::atomic<std::chrono::nanoseconds::rep>          _maxWaitTime{0};
+        std::atomic<std::chrono::nanoseconds::rep>          _maxRunTime{0};
+        std::array<std::atomic_size_t, numLatencyBuckets>   _waitTimes;
+        std::array<std::atomic_size_t, numLatencyBuckets>   _runTimes;
+    };
+
+
     /// @brief Number of posted tasks associated with the sequence key
-    size_t _postedTaskCount{0};
+    std::atomic<size_t> _postedTaskCount{0};
     /// @brief Number of pending tasks associated with the sequence key
     std::atomic<size_t> _pendingTaskCount{0};
+    /// @brief Task latencies associated with the sequence key
+    std::unique_ptr<Latencies> _latencies;
 };
 
 //==============================================================================================
@@ -81,6 +139,24 @@ public:
 
     /// @brief Increments the total number of pending tasks associated with the key
     void decrementPendingTaskCount();
+
+    /// @brief Starts collecting the task latencies
+    /// @note Must be called before the statistics are shared with other threads
+    void enableLatencyStatistics();
+
+    /// @brief Records the latencies of a completed task. Does nothing unless the latencies are collected.
+    /// @param enqueueTime the time the task was enqueued
+    /// @param startTime the time the task started
+    /// @param endTime the time the task completed
+    void recordTaskLatency(std::chrono::steady_clock::time_point enqueueTime,
+                           std::chrono::steady_clock::time_point startTime,
+                           std::chrono::steady_clock::time_point endTime);
+
+private:
+    static void record(std::chrono::nanoseconds latency,
+                       std::atomic<std::chrono::nanoseconds::rep>& total,
+                       std::atomic<std::chrono::nanoseconds::rep>& max,
+                       std::array<std::atomic_size_t, numLatencyBuckets>& histogram);
 };
 
 }}
@@ -18,8 +18,13 @@
 
 #include <quantum/quantum_dispatcher.h>
 #include <quantum/interface/quantum_ithread_context_base.h>
+#include <quantum/quantum_capture.h>
+#include <quantum/quantum_mutex.h>
+#include <quantum/quantum_promise.h>
+#include <quantum/quantum_spinlock.h>
 #include <quantum/util/quantum_sequencer_configuration.h>
 #include <quantum/util/quantum_sequence_key_statistics.h>
+#include <deque>
 #include <vector>
 #include <unordered_map>
 
@@ -49,6 +54,14 @@ namespace quantum {
 /// mechanism instead. A user can specify an exception callback (see SequencerConfiguration<...>::getExceptionCallback)
 /// that will be called whenever a task posted to Sequencer::enqueue/enqueueAll throws an exception. The opaque
 /// parameter can be used to distinguish one task from another.
+/// @note The sequence keys can be partitioned over several control queues (@see SequencerConfiguration::setNumControlQueues).
+/// Tasks associated with keys belonging to a single partition are scheduled by that partition's control queue only,
+/// while tasks spanning several partitions (including universal tasks) are registered with each partition involved
+/// and start once all of them have recorded their dependents.
+/// @note When task batching is enabled (@see SequencerConfiguration::setTaskBatchSize), consecutive single-key tasks
+/// for the same key share one coroutine instead of each waiting on its predecessor in a coroutine of its own.
+/// @note When key affinity is enabled (@see SequencerConfiguration::setKeyAffinity), the tasks of a key run on
+/// a coroutine queue chosen by the control queue of the key.
 
 template <class SequenceKey,
           class Hash = std::hash<SequenceKey>,
@@ -74,14 +87,17 @@ public:
     /// @param[in] sequenceKey SequenceKey object that the posted task is associated with
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
-    /// @note This function is non-blocking and returns immediately.
+    /// @return Enqueued, or the outcome of the per-key pending task limit if one is set
+    ///         (@see SequencerConfiguration::setMaxPendingTasksPerKey).
+    /// @note This function is non-blocking and returns immediately, unless the pending task limit of the key
+    ///       is reached and the Block policy is set (@see SequencerConfiguration::setPendingLimitPolicy).
     /// @note For lowering the latencies of processing tasks posted here, it is suggested that the configured
     ///       Any-coroutine-queue-range (@see Configuration::setCoroQueueIdRangeForAny) does not contain
     ///       the control queue id (@see SequencerConfiguration::setControlQueueId).
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously on a specific queue (thread).
@@ -101,7 +117,10 @@ public:
     /// @param[in] sequenceKey SequenceKey object that the posted task is associated with
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
-    /// @note This function is non-blocking and returns immediately.
+    /// @return Enqueued, or the outcome of the per-key pending task limit if one is set
+    ///         (@see SequencerConfiguration::setMaxPendingTasksPerKey).
+    /// @note This function is non-blocking and returns immediately, unless the pending task limit of the key
+    ///       is reached and the Block policy is set (@see SequencerConfiguration::setPendingLimitPolicy).
     /// @note For lowering the latencies of processing tasks posted here, queueId is suggested to be
     ///       different from the control queue id (@see SequencerConfiguration::setControlQueueId). Hence, if
     ///       IQueue::QueueId::Any is intended to be used as queueId here, then it is suggested that the configured
@@ -110,7 +129,7 @@ public:
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(void* opaque, int queueId, bool isHighPriority, const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously.
@@ -123,6 +142,7 @@ public:
     ///            sequenceKeys will be de-duped internally to prevent double-dependency errors.
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
+    /// @return Always Enqueued. Tasks with several sequence keys are not subject to the pending task limit.
     /// @note This function is non-blocking and returns immediately.
     /// @note For lowering the latencies of processing tasks posted here, it is suggested that the configured
     ///       Any-coroutine-queue-range (@see Configuration::setCoroQueueIdRangeForAny) does not contain
@@ -130,7 +150,7 @@ public:
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(const std::vector<SequenceKey>& sequenceKeys, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously on a specific queue (thread).
@@ -151,6 +171,7 @@ public:
     ///            sequenceKeys will be de-duped internally to prevent double-dependency errors.
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
+    /// @return Always Enqueued. Tasks with several sequence keys are not subject to the pending task limit.
     /// @note This function is non-blocking and returns immediately.
     /// @note For lowering the latencies of processing tasks posted here, queueId is suggested to be
     ///       different from the control queue id (@see SequencerConfiguration::setControlQueueId). Hence, if
@@ -160,7 +181,7 @@ public:
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(void* opaque,
             int queueId,
             bool isHighPriority,
@@ -215,7 +236,8 @@ public:
     enqueueAll(void* opaque, int queueId, bool isHighPriority, FUNC&& func, ARGS&&... args);
 
     /// @brief Trims the sequence keys not used by the sequencer anymore.
-    /// @details It's recommended to call this function periodically to clean up state sequence keys.
+    /// @details It's recommended to call this function periodically to clean up state sequence keys,
+    ///          unless idle keys are evicted automatically (@see SequencerConfiguration::setIdleKeyTimeoutMs).
     /// @remark This call clears all the statistics for trimmed keys.
     /// @return The number of sequenceKeys after the trimming.
     /// @note This function blocks until the trimming job posted to the dispatcher is finished
@@ -243,6 +265,20 @@ public:
     ///       not on per-key basis.
     SequenceKeyStatistics getTaskStatistics();
 
+    /// @brief Gets the sequence keys whose tasks ran for the longest time in total.
+    /// @param count the maximum number of keys to return
+    /// @return the keys with their statistics, in decreasing order of total run time
+    ///         (@see SequenceKeyStatistics::getTotalRunTime). Keys without any completed task are skipped.
+    /// @note Always empty unless latency statistics are collected (@see SequencerConfiguration::setCollectLatencyStatistics).
+    /// @note This function blocks until the statistics computation jobs posted to the dispatcher are finished.
+    ///       The sequencer keeps scheduling tasks in the meantime.
+    std::vector<std::pair<SequenceKey, SequenceKeyStatistics>> getSlowestSequenceKeys(size_t count);
+
+    /// @brief Gets the number of task batches started so far.
+    /// @return the number of batches, each of which runs its tasks inside a single coroutine
+    /// @note Always 0 when task batching is disabled (@see SequencerConfiguration::setTaskBatchSize).
+    size_t getTaskBatchCount() const;
+
     /// @brief Drains all sequenced tasks.
     /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely until all sequences drain.
     /// @param[in] isFinal If set to true, the sequencer will not allow any more processing after the drain completes.
@@ -254,14 +290,95 @@ public:
     bool drain(std::chrono::milliseconds timeout = std::chrono::milliseconds(-1),
                bool isFinal = false);
 
+    /// @brief Waits until the tasks enqueued so far with a sequence key have completed.
+    /// @param[in] sequenceKey the key
+    /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely.
+    /// @return True if the tasks complete before timeout, false otherwise.
+    /// @note Unlike drain(timeout, isFinal), no task is enqueued and posting of new tasks is never disabled, so the
+    ///       other keys keep running undisturbed. The tasks with several keys including this one and the universal
+    ///       tasks enqueued before the call are waited on as well. With task batching
+    ///       (@see SequencerConfiguration::setTaskBatchSize), tasks enqueued later may join the batch being waited on.
+    bool drain(const SequenceKey& sequenceKey,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+    /// @brief Waits until the tasks enqueued so far with any of the sequence keys have completed.
+    /// @param[in] sequenceKeys the keys
+    /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely.
+    /// @return True if the tasks complete before timeout, false otherwise.
+    /// @note @see drain(const SequenceKey&, std::chrono::milliseconds)
+    bool drain(const std::vector<SequenceKey>& sequenceKeys,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
 private:
     using ContextMap = std::unordered_map<SequenceKey, SequenceKeyData, Hash, KeyEqual, Allocator>;
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using IdleKeyQueue = std::deque<std::pair<SequenceKey, TimePoint>>;
+    using KeyStatisticsList = std::vector<std::pair<SequenceKey, SequenceKeyStatistics>>;
     using ExceptionCallback = typename Configuration::ExceptionCallback;
 
+    // A single-key task admitted under the pending task limit
+    struct LimitedTask
+    {
+        LimitedTask(void* opaque, Function<int(VoidContextPtr)>&& func);
+
+        void*                           _opaque;
+        Function<int(VoidContextPtr)>   _func; // replaced when a later task is coalesced into this one
+    };
+    using LimitedTaskPtr = std::shared_ptr<LimitedTask>;
+
+    // The admitted tasks of a sequence key which have not started yet
+    struct PendingLimit
+    {
+        size_t              _numPendingTasks{0};
+        LimitedTaskPtr      _lastTask; // the last admitted task, which is the last one to start
+    };
+    using PendingLimitMap = std::unordered_map<SequenceKey, PendingLimit, Hash, KeyEqual>;
+
+    // A subset of the sequence keys owned by a single control queue
+    struct Partition
+    {
+        Partition(int queueId, const Configuration& configuration, const StatsPtr& universalStats);
+
+        int                 _queueId;
+        SequenceKeyData     _universalContext;
+        ContextMap          _contexts;
+        IdleKeyQueue        _idleKeys; // every key of _contexts with the time it was last known to be used
+        SpinLock            _pendingLimitSpinlock;
+        PendingLimitMap     _pendingLimits; // only the keys with pending tasks, accessed by the producers
+    };
+    using PartitionKeys = std::vector<std::vector<SequenceKey>>;
+
+    // State shared by all the partitions which a multi-partition or universal task is registered with
+    struct CrossPartitionTask
+    {
+        template <class FUNC>
+        CrossPartitionTask(void* opaque,
+                           int queueId,
+                           bool isHighPriority,
+                           bool isUniversal,
+                           TimePoint enqueueTime,
+                           size_t numPartitions,
+                           FUNC&& func);
+
+        void*                               _opaque;
+        int                                 _queueId;
+        bool                                _isHighPriority;
+        bool                                _isUniversal;
+        TimePoint                           _enqueueTime;
+        std::atomic_size_t                  _numPendingPartitions;
+        SpinLock                            _spinlock;
+        std::vector<ICoroContextBasePtr>    _dependents;
+        std::vector<StatsPtr>               _stats;
+        Function<int(VoidContextPtr)>       _func;
+        Promise<int>                        _promise;
+    };
+    using CrossPartitionTaskPtr = std::shared_ptr<CrossPartitionTask>;
+
     template <class FUNC, class ... ARGS>
     static int waitForTwoDependents(VoidContextPtr ctx,
                                     void* opaque,
                                     Sequencer& sequencer,
+                                    TimePoint enqueueTime,
                                     SequenceKeyData&& dependent,
                                     SequenceKeyData&& universalDependent,
                                     FUNC&& func,
@@ -270,6 +387,7 @@ private:
     static int waitForDependents(VoidContextPtr ctx,
                                  void* opaque,
                                  Sequencer& sequencer,
+                                 TimePoint enqueueTime,
                                  std::vector<SequenceKeyData>&& dependents,
                                  SequenceKeyData&& universalDependent,
                                  FUNC&& func,
@@ -278,17 +396,30 @@ private:
     static int waitForUniversalDependent(VoidContextPtr ctx,
                                          void* opaque,
                                          Sequencer& sequencer,
+                                         TimePoint enqueueTime,
                                          std::vector<SequenceKeyData>&& dependents,
                                          SequenceKeyData&& universalDependent,
                                          FUNC&& func,
                                          ARGS&&... args);
+    static int waitForCrossPartitionDependents(VoidContextPtr ctx,
+                                               Sequencer& sequencer,
+                                               CrossPartitionTaskPtr task);
+    static int waitForCrossPartitionTask(VoidContextPtr ctx,
+                                         CrossPartitionTaskPtr task);
+    static int runTaskBatch(VoidContextPtr ctx,
+                            Sequencer& sequencer,
+                            SequenceKeyData&& dependent,
+                            SequenceKeyData&& universalDependent,
+                            TaskBatchPtr batch);
     template <class FUNC, class ... ARGS>
     static int singleSequenceKeyTaskScheduler(
                                     VoidContextPtr ctx,
                                     void* opaque,
                                     int queueId,
                                     bool isHighPriority,
+                                    TimePoint enqueueTime,
                                     Sequencer& sequencer,
+                                    Partition& partition,
                                     SequenceKey&& sequenceKey,
                                     FUNC&& func,
                                     ARGS&&... args);
@@ -298,7 +429,9 @@ private:
                                     void* opaque,
                                     int queueId,
                                     bool isHighPriority,
+                                    TimePoint enqueueTime,
                                     Sequencer& sequencer,
+                                    Partition& partition,
                                     std::vector<SequenceKey>&& sequenceKeys,
                                     FUNC&& func,
                                     ARGS&&... args);
@@ -308,9 +441,22 @@ private:
                                     void* opaque,
                                     int queueId,
                                     bool isHighPriority,
+                                    TimePoint enqueueTime,
                                     Sequencer& sequencer,
+                                    Partition& partition,
                                     FUNC&& func,
                                     ARGS&&... args);
+    static int crossPartitionTaskScheduler(
+                                    VoidContextPtr ctx,
+                                    Sequencer& sequencer,
+                                    Partition& partition,
+                                    std::vector<SequenceKey>&& sequenceKeys,
+                                    CrossPartitionTaskPtr task);
+    static int runLimitedTask(VoidContextPtr ctx,
+                              Sequencer& sequencer,
+                              Partition& partition,
+                              const SequenceKey& sequenceKey,
+                              const LimitedTaskPtr& task);
     template <class FUNC, class ... ARGS>
     static int callPosted(VoidContextPtr ctx,
                            void* opaque,
@@ -318,6 +464,52 @@ private:
                            FUNC&& func,
                            ARGS&&... args);
 
+    template <class FUNC, class ... ARGS>
+    SequencerEnqueueStatus enqueueSingle(void* opaque,
+                                         int queueId,
+                                         bool isHighPriority,
+                                         const SequenceKey& sequenceKey,
+                                         FUNC&& func,
+                                         ARGS&&... args);
+    template <class FUNC, class ... ARGS>
+    void enqueueMulti(void* opaque,
+                      int queueId,
+                      bool isHighPriority,
+                      const std::vector<SequenceKey>& sequenceKeys,
+                      FUNC&& func,
+                      ARGS&&... args);
+    template <class FUNC, class ... ARGS>
+    void enqueueUniversal(void* opaque,
+                          int queueId,
+                          bool isHighPriority,
+                          FUNC&& func,
+                          ARGS&&... args);
+    template <class FUNC, class ... ARGS>
+    void enqueueCrossPartition(void* opaque,
+                               int queueId,
+                               bool isHighPriority,
+                               bool isUniversal,
+                               PartitionKeys&& partitionKeys,
+                               FUNC&& func,
+                               ARGS&&... args);
+    Partition& getPartition(const SequenceKey& sequenceKey);
+    SequencerEnqueueStatus admitLimitedTask(Partition& partition,
+                                            const SequenceKey& sequenceKey,
+                                            const LimitedTaskPtr& task);
+    TimePoint getCurrentTime() const;
+    static KeyStatisticsList findSlowestSequenceKeys(const ContextMap& contexts, size_t count);
+    static SequenceKeyData& getSequenceKeyData(Sequencer& sequencer,
+                                               Partition& partition,
+                                               const SequenceKey& sequenceKey);
+    static void evictIdleSequenceKeys(VoidContextPtr ctx,
+                                      Sequencer& sequencer,
+                                      Partition& partition);
+    static int getAffinityQueueId(VoidContextPtr ctx,
+                                  Sequencer& sequencer,
+                                  SequenceKeyData& keyData,
+                                  const SequenceKey& sequenceKey);
+    int getLeastLoadedQueueId() const;
+
     static bool canTrimContext(const ICoroContextBasePtr& ctx,
                                const ICoroContextBasePtr& ctxToValidate);
     static bool isPendingContext(const ICoroContextBasePtr& ctx,
@@ -325,9 +517,20 @@ private:
 
     Dispatcher&              _dispatcher;
     std::atomic_bool         _drain;
-    int                      _controllerQueueId;
-    SequenceKeyData          _universalContext;
-    ContextMap               _contexts;
+    Hash                     _hash;
+    StatsPtr                 _universalStats;
+    std::vector<std::unique_ptr<Partition>> _partitions;
+    Mutex                    _crossPartitionMutex;
+    size_t                   _taskBatchSize;
+    std::chrono::milliseconds _taskBatchTimeSlice;
+    std::atomic_size_t       _taskBatchCount;
+    std::chrono::milliseconds _idleKeyTimeout;
+    size_t                   _idleKeyEvictionStepSize;
+    bool                     _collectLatencyStatistics;
+    size_t                   _maxPendingTasksPerKey;
+    SequencerPendingLimitPolicy _pendingLimitPolicy;
+    bool                     _keyAffinity;
+    size_t                   _keyAffinityRebalanceThreshold;
     ExceptionCallback        _exceptionCallback;
     std::shared_ptr<SequenceKeyStatisticsWriter> _taskStats;
 };
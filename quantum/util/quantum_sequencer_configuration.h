@@ -17,6 +17,7 @@
 #define BLOOMBERG_QUANTUM_SEQUENCER_CONFIGURATION_H
 
 #include <functional>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 
@@ -25,6 +26,31 @@ namespace quantum {
 
 struct SequenceKeyData;
 
+//==============================================================================================
+//                                  enum SequencerPendingLimitPolicy
+//==============================================================================================
+/// @enum SequencerPendingLimitPolicy
+/// @brief Defines what happens to a task enqueued with a sequence key which already has the maximum
+///        number of pending tasks (@see SequencerConfiguration::setMaxPendingTasksPerKey).
+enum class SequencerPendingLimitPolicy : int
+{
+    Reject,     ///< The task is dropped.
+    Block,      ///< The caller waits until one of the pending tasks of the key starts.
+    Coalesce    ///< The task replaces the most recently enqueued pending task of the key.
+};
+
+//==============================================================================================
+//                                  enum SequencerEnqueueStatus
+//==============================================================================================
+/// @enum SequencerEnqueueStatus
+/// @brief Defines the result of enqueuing a task to a Sequencer.
+enum class SequencerEnqueueStatus : int
+{
+    Enqueued,   ///< The task was added to the pending tasks of its sequence key(s).
+    Coalesced,  ///< The task replaced the function of a pending task of its sequence key.
+    Rejected    ///< The task was dropped because its sequence key had too many pending tasks.
+};
+
 //==============================================================================================
 //                                    class SequencerConfigurationSchemaProvider
 //==============================================================================================
@@ -73,6 +99,138 @@ public:
     /// @return the queue id
     int getControlQueueId() const;
 
+    /// @brief Sets the number of control queues
+    /// @param numControlQueues the number of queues. Must be at least 1.
+    /// @remark When greater than 1, the sequence keys are hashed onto the control queues
+    ///         [controlQueueId, controlQueueId + numControlQueues), each of which tracks its own partition
+    ///         of the keys. This allows task scheduling to scale with the number of control queues.
+    ///         Tasks with sequence keys spanning several partitions, as well as universal tasks, are
+    ///         coordinated across the partitions involved and are therefore more expensive to schedule.
+    /// @return A reference to itself
+    SequencerConfiguration& setNumControlQueues(size_t numControlQueues);
+
+    /// @brief Gets the number of control queues
+    /// @return the number of queues
+    size_t getNumControlQueues() const;
+
+    /// @brief Sets the maximum number of tasks with the same sequence key which can run inside a single coroutine
+    /// @param taskBatchSize the number of tasks. A value of 0 or 1 disables batching.
+    /// @remark When batching is enabled, single-key tasks enqueued while a previous task for the same key
+    ///         is still pending are queued in that key's current batch instead of being posted as new
+    ///         coroutines. A batch runs its tasks back-to-back and stops accepting new tasks once it is
+    ///         full, once its time slice expires or once it runs out of tasks. This reduces the coroutine
+    ///         and stack churn for hot keys, at the expense of sequencing all the tasks of a batch on the
+    ///         queue selected by its first task.
+    /// @return A reference to itself
+    SequencerConfiguration& setTaskBatchSize(size_t taskBatchSize);
+
+    /// @brief Gets the maximum number of tasks with the same sequence key which can run inside a single coroutine
+    /// @return the number of tasks
+    size_t getTaskBatchSize() const;
+
+    /// @brief Sets the amount of time after which a task batch stops accepting new tasks
+    /// @param timeSlice the time slice. 0 means that batches are only limited by their size.
+    /// @note The tasks already accepted by the batch still run inside the same coroutine. Once the time slice
+    ///       expires, the batch yields before running its next task so that the other coroutines on its queue
+    ///       can run, and a new time slice starts when it resumes.
+    /// @return A reference to itself
+    SequencerConfiguration& setTaskBatchTimeSliceMs(std::chrono::milliseconds timeSlice);
+
+    /// @brief Gets the amount of time after which a task batch stops accepting new tasks
+    /// @return the time slice
+    std::chrono::milliseconds getTaskBatchTimeSliceMs() const;
+
+    /// @brief Sets the amount of time after which a sequence key with no pending task is evicted
+    /// @param timeout the idle timeout, measured from the last time a task was enqueued with the key.
+    ///                0 disables the automatic eviction.
+    /// @remark Each control queue keeps its sequence keys in a FIFO and examines a bounded number of them
+    ///         every time it schedules a task, evicting those which have no pending task and have been idle
+    ///         for longer than the timeout.
+    ///         Unlike trimSequenceKeys(), this never walks the whole key map. Eviction only progresses while
+    ///         tasks are being enqueued, and it clears all the statistics of the evicted keys.
+    /// @return A reference to itself
+    SequencerConfiguration& setIdleKeyTimeoutMs(std::chrono::milliseconds timeout);
+
+    /// @brief Gets the amount of time after which a sequence key with no pending task is evicted
+    /// @return the idle timeout
+    std::chrono::milliseconds getIdleKeyTimeoutMs() const;
+
+    /// @brief Sets the maximum number of sequence keys examined for eviction each time a task is scheduled
+    /// @param stepSize the number of keys. Must be at least 1 when the idle key timeout is set.
+    /// @remark Values greater than 1 let the eviction catch up after bursts of new keys.
+    /// @return A reference to itself
+    SequencerConfiguration& setIdleKeyEvictionStepSize(size_t stepSize);
+
+    /// @brief Gets the maximum number of sequence keys examined for eviction each time a task is scheduled
+    /// @return the number of keys
+    size_t getIdleKeyEvictionStepSize() const;
+
+    /// @brief Enables the collection of task latency statistics
+    /// @param value true to record the wait and run time of every task
+    /// @remark When enabled, each task reads the clock when it is enqueued, started and completed, and its
+    ///         latencies are recorded in the statistics of its sequence keys and in the task statistics
+    ///         (@see SequenceKeyStatistics::getWaitTimeHistogram). Each sequence key also holds two
+    ///         histograms. @see Sequencer::getSlowestSequenceKeys to find the keys with the longest run times.
+    /// @return A reference to itself
+    SequencerConfiguration& setCollectLatencyStatistics(bool value);
+
+    /// @brief Indicates if task latency statistics are collected
+    /// @return true if enabled
+    bool getCollectLatencyStatistics() const;
+
+    /// @brief Sets the maximum number of pending tasks for a single sequence key
+    /// @param maxPendingTasks the number of tasks. 0 means that the number of pending tasks is not limited.
+    /// @remark A pending task is a single-key task which has been enqueued but has not started yet. Tasks
+    ///         enqueued with several sequence keys and universal tasks are neither counted nor limited.
+    ///         @see setPendingLimitPolicy for what happens to the tasks enqueued beyond the limit.
+    /// @note Enabling the limit makes each single-key enqueue lock a per-control-queue admission table.
+    /// @return A reference to itself
+    SequencerConfiguration& setMaxPendingTasksPerKey(size_t maxPendingTasks);
+
+    /// @brief Gets the maximum number of pending tasks for a single sequence key
+    /// @return the number of tasks
+    size_t getMaxPendingTasksPerKey() const;
+
+    /// @brief Sets what happens to a task enqueued with a sequence key which already has the maximum number
+    ///        of pending tasks
+    /// @param policy the policy. Reject drops the task, Block makes enqueue() wait (by yielding when called from
+    ///               a coroutine) until a pending task of the key starts, and Coalesce replaces the function and
+    ///               the opaque data of the most recently enqueued pending task of the key, which then runs
+    ///               in its original place in the sequence.
+    /// @remark Sequencer::enqueue returns the outcome (@see SequencerEnqueueStatus).
+    /// @return A reference to itself
+    SequencerConfiguration& setPendingLimitPolicy(SequencerPendingLimitPolicy policy);
+
+    /// @brief Gets what happens to a task enqueued with a sequence key which already has the maximum number
+    ///        of pending tasks
+    /// @return the policy
+    SequencerPendingLimitPolicy getPendingLimitPolicy() const;
+
+    /// @brief Enables key-affinity scheduling
+    /// @param value true to run the single-key tasks enqueued with IQueue::QueueId::Any on a coroutine queue
+    ///              selected by the hash of their sequence key
+    /// @remark The queue is picked in the Any-coroutine-queue-range (@see Configuration::setCoroQueueIdRangeForAny),
+    ///         so consecutive tasks of a key run on the same thread and find the key's data in a warm cache.
+    ///         Tasks with several sequence keys and universal tasks are still posted to IQueue::QueueId::Any.
+    /// @return A reference to itself
+    SequencerConfiguration& setKeyAffinity(bool value);
+
+    /// @brief Indicates if key-affinity scheduling is enabled
+    /// @return true if enabled
+    bool getKeyAffinity() const;
+
+    /// @brief Sets the coroutine queue size above which a sequence key is moved to another queue
+    /// @param threshold the number of tasks on the queue of the key (@see Dispatcher::size). 0 disables the rebalancing.
+    /// @remark Only applies to key-affinity scheduling. A key is only moved while it has no task pending or running,
+    ///         to the least loaded queue of the range, so hot keys hashed onto the same queue spread out over time
+    ///         while the tasks of each key keep running on a single queue.
+    /// @return A reference to itself
+    SequencerConfiguration& setKeyAffinityRebalanceThreshold(size_t threshold);
+
+    /// @brief Gets the coroutine queue size above which a sequence key is moved to another queue
+    /// @return the number of tasks
+    size_t getKeyAffinityRebalanceThreshold() const;
+
     /// @brief Sets the minimal number of buckets to be used for the context hash map
     /// @param bucketCount the bucket number
     /// @return A reference to itself
@@ -115,12 +273,22 @@ public:
     const ExceptionCallback& getExceptionCallback() const;
 
 private:
-    size_t              _bucketCount{100};
-    Hash                _hash;
-    KeyEqual            _keyEqual;
-    Allocator           _allocator;
-    ExceptionCallback   _exceptionCallback;
-    int                 _controllerQueueId{0};
+    size_t                      _bucketCount{100};
+    Hash                        _hash;
+    KeyEqual                    _keyEqual;
+    Allocator                   _allocator;
+    ExceptionCallback           _exceptionCallback;
+    int                         _controllerQueueId{0};
+    size_t                      _numControllerQueues{1};
+    size_t                      _taskBatchSize{1};
+    std::chrono::milliseconds   _taskBatchTimeSliceMs{0};
+    std::chrono::milliseconds   _idleKeyTimeoutMs{0};
+    size_t                      _idleKeyEvictionStepSize{8};
+    bool                        _collectLatencyStatistics{false};
+    size_t                      _maxPendingTasksPerKey{0};
+    SequencerPendingLimitPolicy _pendingLimitPolicy{SequencerPendingLimitPolicy::Reject};
+    bool                        _keyAffinity{false};
+    size_t                      _keyAffinityRebalanceThreshold{0};
 };
 
 }}
@@ -16,6 +16,9 @@
 #ifndef BLOOMBERG_QUANTUM_SEQUENCER_CONFIGURATION_EXPERIMENTAL_H
 #define BLOOMBERG_QUANTUM_SEQUENCER_CONFIGURATION_EXPERIMENTAL_H
 
+#include <quantum/util/quantum_sequencer_configuration.h>
+#include <chrono>
+
 namespace Bloomberg {
 namespace quantum {
 namespace experimental {
@@ -60,6 +63,16 @@ public:
     /// @param opaque opaque data passed when posting a task
     using ExceptionCallback = std::function<void(std::exception_ptr exception, void* opaque)>;
 
+    /// @brief Maps a sequence key to the group it shares the fair-share scheduling with
+    /// @param key the sequence key
+    /// @return the group id
+    using FairShareGroupFunction = std::function<size_t(const SequenceKey& key)>;
+
+    /// @brief Gets the fair-share weight of a group of sequence keys
+    /// @param group the group id (@see FairShareGroupFunction)
+    /// @return the weight. Values below 1 are treated as 1.
+    using FairShareWeightFunction = std::function<size_t(size_t group)>;
+
     /// @brief Sets the minimal number of buckets to be used for the context hash map
     /// @param bucketCount the bucket number
     /// @return A reference to itself
@@ -69,6 +82,148 @@ public:
     /// @return the bucket number
     size_t getBucketCount() const;
 
+    /// @brief Sets the number of stripes the context hash map is split into
+    /// @param stripeCount the number of stripes. Must be at least 1.
+    /// @remark Each stripe holds a subset of the sequence keys and is protected by its own mutex, so that
+    ///         tasks associated with keys in different stripes can be enqueued and completed concurrently.
+    ///         Universal tasks lock all the stripes. The bucket count is divided among the stripes.
+    /// @return A reference to itself
+    SequencerConfiguration& setStripeCount(size_t stripeCount);
+
+    /// @brief Gets the number of stripes the context hash map is split into
+    /// @return the number of stripes
+    size_t getStripeCount() const;
+
+    /// @brief Sets the amount of time after which a sequence key with no pending task is evicted
+    /// @param timeout the idle timeout, measured from the completion of the last task with the key.
+    ///                0 disables the automatic eviction.
+    /// @remark Each stripe keeps a FIFO of the keys whose task queue became empty. Every time a task completes,
+    ///         a bounded number of them are examined in the stripes of the task, and those which have been idle
+    ///         for longer than the timeout are evicted. Unlike trimSequenceKeys(), this never walks the whole key
+    ///         map. Eviction only progresses while tasks complete, and it clears all the statistics of the
+    ///         evicted keys.
+    /// @return A reference to itself
+    SequencerConfiguration& setIdleKeyTimeoutMs(std::chrono::milliseconds timeout);
+
+    /// @brief Gets the amount of time after which a sequence key with no pending task is evicted
+    /// @return the idle timeout
+    std::chrono::milliseconds getIdleKeyTimeoutMs() const;
+
+    /// @brief Sets the maximum number of idle sequence keys examined per stripe each time a task completes
+    /// @param stepSize the number of keys. Must be at least 1 when the idle key timeout is set.
+    /// @remark Values greater than 1 let the eviction catch up after bursts of new keys.
+    /// @return A reference to itself
+    SequencerConfiguration& setIdleKeyEvictionStepSize(size_t stepSize);
+
+    /// @brief Gets the maximum number of idle sequence keys examined per stripe each time a task completes
+    /// @return the number of keys
+    size_t getIdleKeyEvictionStepSize() const;
+
+    /// @brief Enables the collection of task latency statistics
+    /// @param value true to record the wait and run time of every task
+    /// @remark When enabled, each task reads the clock when it is enqueued, started and completed, and its
+    ///         latencies are recorded in the statistics of its sequence keys and in the task statistics
+    ///         (@see SequenceKeyStatistics::getWaitTimeHistogram). Each sequence key also holds two
+    ///         histograms. @see Sequencer::getSlowestSequenceKeys to find the keys with the longest run times.
+    /// @return A reference to itself
+    SequencerConfiguration& setCollectLatencyStatistics(bool value);
+
+    /// @brief Indicates if task latency statistics are collected
+    /// @return true if enabled
+    bool getCollectLatencyStatistics() const;
+
+    /// @brief Sets the maximum number of pending tasks for a single sequence key
+    /// @param maxPendingTasks the number of tasks. 0 means that the number of pending tasks is not limited.
+    /// @remark The pending tasks of a key are those which are queued behind other tasks and have not been
+    ///         scheduled yet (@see SequenceKeyStatistics::getPendingTaskCount), including the tasks enqueued
+    ///         with several keys. The limit is checked when single-key tasks are enqueued only.
+    ///         @see setPendingLimitPolicy for what happens to the tasks enqueued beyond the limit.
+    /// @return A reference to itself
+    SequencerConfiguration& setMaxPendingTasksPerKey(size_t maxPendingTasks);
+
+    /// @brief Gets the maximum number of pending tasks for a single sequence key
+    /// @return the number of tasks
+    size_t getMaxPendingTasksPerKey() const;
+
+    /// @brief Sets what happens to a task enqueued with a sequence key which already has the maximum number
+    ///        of pending tasks
+    /// @param policy the policy. Reject drops the task, Block makes enqueue() wait (by yielding when called from
+    ///               a coroutine) until a pending task of the key is scheduled, and Coalesce replaces the function
+    ///               and the opaque data of the last task queued for the key, which then runs in its original place
+    ///               in the sequence. A task which cannot be coalesced because the last queued task is associated
+    ///               with other keys too is enqueued regardless of the limit.
+    /// @remark Sequencer::enqueue returns the outcome (@see SequencerEnqueueStatus).
+    /// @return A reference to itself
+    SequencerConfiguration& setPendingLimitPolicy(SequencerPendingLimitPolicy policy);
+
+    /// @brief Gets what happens to a task enqueued with a sequence key which already has the maximum number
+    ///        of pending tasks
+    /// @return the policy
+    SequencerPendingLimitPolicy getPendingLimitPolicy() const;
+
+    /// @brief Enables key-affinity scheduling
+    /// @param value true to run the single-key tasks enqueued with IQueue::QueueId::Any on a coroutine queue
+    ///              selected by the hash of their sequence key
+    /// @remark The queue is picked in the Any-coroutine-queue-range (@see Configuration::setCoroQueueIdRangeForAny),
+    ///         so consecutive tasks of a key run on the same thread and find the key's data in a warm cache.
+    ///         Tasks with several sequence keys and universal tasks are still posted to IQueue::QueueId::Any.
+    /// @return A reference to itself
+    SequencerConfiguration& setKeyAffinity(bool value);
+
+    /// @brief Indicates if key-affinity scheduling is enabled
+    /// @return true if enabled
+    bool getKeyAffinity() const;
+
+    /// @brief Sets the coroutine queue size above which a sequence key is moved to another queue
+    /// @param threshold the number of tasks on the queue of the key (@see Dispatcher::size). 0 disables the rebalancing.
+    /// @remark Only applies to key-affinity scheduling. A key is only moved while it has no task pending or running,
+    ///         to the least loaded queue of the range, so hot keys hashed onto the same queue spread out over time
+    ///         while the tasks of each key keep running on a single queue.
+    /// @return A reference to itself
+    SequencerConfiguration& setKeyAffinityRebalanceThreshold(size_t threshold);
+
+    /// @brief Gets the coroutine queue size above which a sequence key is moved to another queue
+    /// @return the number of tasks
+    size_t getKeyAffinityRebalanceThreshold() const;
+
+    /// @brief Enables fair-share scheduling and sets the maximum number of its tasks running at the same time
+    /// @param maxRunningTasks the number of tasks. 0 disables fair-share scheduling.
+    /// @remark Without fair-share scheduling, a task is posted to the dispatcher as soon as it is ready, so a burst
+    ///         of tasks on some keys fills the coroutine queues ahead of the tasks of the other keys. With it, the ready
+    ///         single-key tasks are held in one queue per group of keys (@see setFairShareGroupFunction), and at
+    ///         most 'maxRunningTasks' of them are posted at a time. A free slot goes to the groups in deficit round robin
+    ///         order, where each group posts as many tasks per round as its weight (@see setFairShareWeightFunction).
+    ///         Every task costs the same, whatever its run time. Tasks with several sequence keys and universal tasks
+    ///         are posted as soon as they are ready and do not take a slot.
+    /// @note A value close to the number of coroutine threads keeps the threads busy while bounding the time
+    ///       a task of a quiet group waits behind the tasks of the other groups.
+    /// @return A reference to itself
+    SequencerConfiguration& setFairShareMaxRunningTasks(size_t maxRunningTasks);
+
+    /// @brief Gets the maximum number of fair-share scheduled tasks running at the same time
+    /// @return the number of tasks
+    size_t getFairShareMaxRunningTasks() const;
+
+    /// @brief Sets the function mapping the sequence keys to fair-share groups
+    /// @param groupFunction the function. If not set, each key is its own group, identified by its hash,
+    ///                      so keys with the same hash share a group.
+    /// @return A reference to itself
+    SequencerConfiguration& setFairShareGroupFunction(const FairShareGroupFunction& groupFunction);
+
+    /// @brief Gets the function mapping the sequence keys to fair-share groups
+    /// @return the function
+    const FairShareGroupFunction& getFairShareGroupFunction() const;
+
+    /// @brief Sets the function returning the fair-share weight of each group
+    /// @param weightFunction the function. If not set, all the groups have a weight of 1.
+    /// @remark The weight is read when a task is enqueued, and a group uses the weight of its oldest ready task.
+    /// @return A reference to itself
+    SequencerConfiguration& setFairShareWeightFunction(const FairShareWeightFunction& weightFunction);
+
+    /// @brief Gets the function returning the fair-share weight of each group
+    /// @return the function
+    const FairShareWeightFunction& getFairShareWeightFunction() const;
+
     /// @brief Sets the hash function to be used for the context hash map
     /// @param hash the hash function
     SequencerConfiguration& setHash(const Hash& hash);
@@ -102,11 +257,22 @@ public:
     const ExceptionCallback& getExceptionCallback() const;
 
 private:
-    size_t              _bucketCount{100};
-    Hash                _hash;
-    KeyEqual            _keyEqual;
-    Allocator           _allocator;
-    ExceptionCallback   _exceptionCallback;
+    size_t                      _bucketCount{100};
+    size_t                      _stripeCount{16};
+    std::chrono::milliseconds   _idleKeyTimeoutMs{0};
+    size_t                      _idleKeyEvictionStepSize{8};
+    bool                        _collectLatencyStatistics{false};
+    size_t                      _maxPendingTasksPerKey{0};
+    SequencerPendingLimitPolicy _pendingLimitPolicy{SequencerPendingLimitPolicy::Reject};
+    bool                        _keyAffinity{false};
+    size_t                      _keyAffinityRebalanceThreshold{0};
+    size_t                      _fairShareMaxRunningTasks{0};
+    FairShareGroupFunction      _fairShareGroupFunction;
+    FairShareWeightFunction     _fairShareWeightFunction;
+    Hash                        _hash;
+    KeyEqual                    _keyEqual;
+    Allocator                   _allocator;
+    ExceptionCallback           _exceptionCallback;
 };
 
 }}}
@@ -26,9 +26,12 @@
 #include <quantum/interface/quantum_iqueue.h>
 #include <quantum/interface/quantum_ithread_context_base.h>
 #include <quantum/quantum_mutex.h>
+#include <quantum/quantum_spinlock.h>
 #include <quantum/util/quantum_sequencer_configuration_experimental.h>
 #include <quantum/util/quantum_sequencer_task_experimental.h>
 #include <quantum/util/quantum_sequence_key_statistics.h>
+#include <chrono>
+#include <deque>
 #include <vector>
 #include <unordered_map>
 #include <mutex>
@@ -53,6 +56,14 @@ namespace experimental {
 /// only when it's ready to be executed (i.e. when it has no pending dependents). This typically results
 /// in executing scheduled tasks faster (w.r.t. quantum::Dispatcher) and wasting fewer CPU cycles in
 /// quantum::Dispatcher.
+/// @note The pending task queues are split into stripes (@see SequencerConfiguration::setStripeCount), each protected
+/// by its own mutex. Enqueuing and completing tasks only locks the stripes of the keys involved, so operations on keys
+/// in different stripes do not contend. Universal tasks lock all the stripes.
+/// @note When key affinity is enabled (@see SequencerConfiguration::setKeyAffinity), the tasks of a key run on
+/// a coroutine queue chosen when they are enqueued.
+/// @note When fair-share scheduling is enabled (@see SequencerConfiguration::setFairShareMaxRunningTasks), the ready
+/// single-key tasks are held by the sequencer and posted to quantum::Dispatcher in deficit round robin order across
+/// groups of keys, so a burst on some keys only delays the tasks of the other keys by a bounded number of tasks.
 /// @note Due to the fact that tasks enqueued to Sequencer do not get sent to quantum::Dispatcher right away,
 /// no enqueue/enqueueAll method of Sequencer returns an instance of ThreadContextPtr. An important goal
 /// of ThreadContextPtr returned by quantum::Dispather::post(...) calls is exception marshalling i.e.
@@ -85,11 +96,14 @@ public:
     /// @param[in] sequenceKey SequenceKey object that the posted task is associated with
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
-    /// @note This function is non-blocking and returns immediately.
+    /// @return Enqueued, or the outcome of the per-key pending task limit if one is set
+    ///         (@see SequencerConfiguration::setMaxPendingTasksPerKey).
+    /// @note This function is non-blocking and returns immediately, unless the pending task limit of the key
+    ///       is reached and the Block policy is set (@see SequencerConfiguration::setPendingLimitPolicy).
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously on a specific queue (thread).
@@ -109,11 +123,14 @@ public:
     /// @param[in] sequenceKey SequenceKey object that the posted task is associated with
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
-    /// @note This function is non-blocking and returns immediately.
+    /// @return Enqueued, or the outcome of the per-key pending task limit if one is set
+    ///         (@see SequencerConfiguration::setMaxPendingTasksPerKey).
+    /// @note This function is non-blocking and returns immediately, unless the pending task limit of the key
+    ///       is reached and the Block policy is set (@see SequencerConfiguration::setPendingLimitPolicy).
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(void* opaque, int queueId, bool isHighPriority, const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously.
@@ -126,11 +143,12 @@ public:
     ///            sequenceKeys will be de-duped internally to prevent double-dependency errors.
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
+    /// @return Always Enqueued. Tasks with several sequence keys are not subject to the pending task limit.
     /// @note This function is non-blocking and returns immediately.
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(const std::vector<SequenceKey>& sequenceKeys, FUNC&& func, ARGS&&... args);
 
     /// @brief Enqueue a coroutine to run asynchronously on a specific queue (thread).
@@ -151,11 +169,12 @@ public:
     ///            sequenceKeys will be de-duped internally to prevent double-dependency errors.
     /// @param[in] func Callable object.
     /// @param[in] args Variable list of arguments passed to the callable object.
+    /// @return Always Enqueued. Tasks with several sequence keys are not subject to the pending task limit.
     /// @note This function is non-blocking and returns immediately.
     /// @warning The VoidContextPtr can be used to yield() or to post additional coroutines or IO tasks.
     ///          However it should *not* be set and this will result in undefined behavior.
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueue(void* opaque,
             int queueId,
             bool isHighPriority,
@@ -202,7 +221,8 @@ public:
     enqueueAll(void* opaque, int queueId, bool isHighPriority, FUNC&& func, ARGS&&... args);
 
     /// @brief Trims the sequence keys not used by the sequencer anymore.
-    /// @details It's recommended to call this function periodically to clean up state sequence keys.
+    /// @details It's recommended to call this function periodically to clean up state sequence keys,
+    ///          unless idle keys are evicted automatically (@see SequencerConfiguration::setIdleKeyTimeoutMs).
     /// @remark This call clears all the statistics for trimmed keys.
     /// @return The number of sequenceKeys after the trimming.
     size_t trimSequenceKeys();
@@ -219,7 +239,9 @@ public:
 
     /// @brief Gets the sequencer statistics for the 'universal key', a.k.a. posted via postAll() method.
     /// @return the statistics objects
-    /// @note This function blocks until the statistics computation job posted to the dispatcher is finished.
+    /// @note This function does not lock the stripes. Each counter is read atomically but the posted and pending
+    ///       counts are read separately, so they may not be consistent with each other while tasks are being
+    ///       enqueued or scheduled.
     SequenceKeyStatistics getStatistics();
 
     /// @brief Gets the sequencer statistics for all jobs.
@@ -228,6 +250,14 @@ public:
     ///       not on per-key basis.
     SequenceKeyStatistics getTaskStatistics();
 
+    /// @brief Gets the sequence keys whose tasks ran for the longest time in total.
+    /// @param count the maximum number of keys to return
+    /// @return the keys with their statistics, in decreasing order of total run time
+    ///         (@see SequenceKeyStatistics::getTotalRunTime). Keys without any completed task are skipped.
+    /// @note Always empty unless latency statistics are collected (@see SequencerConfiguration::setCollectLatencyStatistics).
+    /// @note The stripes are locked one at a time, so the ranking is not an atomic snapshot of all the keys.
+    std::vector<std::pair<SequenceKey, SequenceKeyStatistics>> getSlowestSequenceKeys(size_t count);
+
     /// @brief Drains all sequenced tasks.
     /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely until all sequences drain.
     /// @param[in] isFinal If set to true, the sequencer will not allow any more processing after the drain completes.
@@ -239,15 +269,73 @@ public:
     bool drain(std::chrono::milliseconds timeout = std::chrono::milliseconds(-1),
                bool isFinal = false);
 
+    /// @brief Waits until the tasks enqueued so far with a sequence key have completed.
+    /// @param[in] sequenceKey the key
+    /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely.
+    /// @return True if the tasks complete before timeout, false otherwise.
+    /// @note Unlike drain(timeout, isFinal), no task is enqueued and posting of new tasks is never disabled, so the
+    ///       other keys keep running undisturbed. The tasks with several keys including this one and the universal
+    ///       tasks enqueued before the call are waited on as well.
+    bool drain(const SequenceKey& sequenceKey,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+    /// @brief Waits until the tasks enqueued so far with any of the sequence keys have completed.
+    /// @param[in] sequenceKeys the keys
+    /// @param[in] timeout Maximum time for this function to wait. Set to -1 to wait indefinitely.
+    /// @return True if the tasks complete before timeout, false otherwise.
+    /// @note @see drain(const SequenceKey&, std::chrono::milliseconds)
+    bool drain(const std::vector<SequenceKey>& sequenceKeys,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
 private:
     using PendingTaskQueueMap = std::unordered_map<SequenceKey, SequencerKeyData<SequenceKey>, Hash, KeyEqual, Allocator>;
+    using IdleKeyQueue = std::deque<std::pair<SequenceKey, std::chrono::steady_clock::time_point>>;
+    using KeyStatisticsList = std::vector<std::pair<SequenceKey, SequenceKeyStatistics>>;
     using ExceptionCallback = typename Configuration::ExceptionCallback;
+    using FairShareGroupFunction = typename Configuration::FairShareGroupFunction;
+    using FairShareWeightFunction = typename Configuration::FairShareWeightFunction;
+
+    /// @brief The ready tasks of a fair-share group
+    struct FairShareFlow
+    {
+        std::deque<std::shared_ptr<SequencerTask<SequenceKey>>> _readyTasks;
+        size_t _deficit{0}; // tasks the group may still post in the current round
+    };
+    using FairShareFlowMap = std::unordered_map<size_t, FairShareFlow>;
+
+    /// @brief A subset of the pending task queues protected by its own mutex
+    struct Stripe
+    {
+        Stripe(const Configuration& configuration, size_t bucketCount);
+
+        quantum::Mutex          _mutex;
+        PendingTaskQueueMap     _pendingTaskQueueMap;
+        IdleKeyQueue            _idleKeys; // keys with an empty task queue, oldest first
+    };
+
+    /// @brief Locks a set of stripes in increasing index order for the lifetime of the object
+    class StripeGuard
+    {
+    public:
+        StripeGuard(VoidContextPtr ctx, Sequencer& sequencer, const std::vector<size_t>& stripes);
+        ~StripeGuard();
+    private:
+        Sequencer&                  _sequencer;
+        const std::vector<size_t>&  _stripes;
+    };
+
+    /// @brief Gets the index of the stripe holding a key
+    /// @param key the key
+    /// @return the stripe index
+    size_t getStripeIndex(const SequenceKey& key) const;
 
     /// @brief Adds the task to the pending queue
+    /// @param stripe the stripe holding the key. Must be locked by the caller.
     /// @param key the key associated with the queue to add to
     /// @param task the task to add
     /// @return true if the added task is the only enqueued task
-    bool addPendingTask(const SequenceKey& key,
+    bool addPendingTask(Stripe& stripe,
+                        const SequenceKey& key,
                         const std::shared_ptr<SequencerTask<SequenceKey>>& task);
 
     /// @brief Adds the task to the universal pending queue
@@ -260,6 +348,25 @@ private:
     void scheduleTask(
         const std::shared_ptr<SequencerTask<SequenceKey>>& task);
 
+    /// @brief Posts a ready task to the dispatcher
+    /// @param task the task to post
+    void postTask(const std::shared_ptr<SequencerTask<SequenceKey>>& task);
+
+    /// @brief Adds a ready task to the queue of its fair-share group and posts the tasks which can run
+    /// @param task the task to add
+    void addFairShareTask(const std::shared_ptr<SequencerTask<SequenceKey>>& task);
+
+    /// @brief Releases the slot of a completed fair-share task and posts the tasks which can run
+    void releaseFairShareSlot();
+
+    /// @brief Posts ready fair-share tasks while fewer than the maximum number of them are running
+    void postFairShareTasks();
+
+    /// @brief Takes the next fair-share task to run in deficit round robin order
+    /// @return the task, or null if no task is ready or the maximum number of tasks are running.
+    ///         The fair-share lock must be held by the caller.
+    std::shared_ptr<SequencerTask<SequenceKey>> popFairShareTask();
+
     /// @brief Removes a completed task from the pending queues and schedule next tasks
     /// @param ctx context
     /// @param task the task to remove
@@ -275,6 +382,43 @@ private:
         SequencerKeyData<SequenceKey>& entry,
         const std::shared_ptr<SequencerTask<SequenceKey>>& task);
 
+    /// @brief Queues a key whose task queue just became empty for idle eviction
+    /// @param data the key data. Its stripe must be locked by the caller.
+    /// @param now the current time
+    void trackIdleKey(SequencerKeyData<SequenceKey>& data,
+                      std::chrono::steady_clock::time_point now);
+
+    /// @brief Evicts a bounded number of keys which have been idle for longer than the timeout
+    /// @param stripe the stripe holding the keys. Must be locked by the caller.
+    /// @param now the current time
+    void evictIdleKeys(Stripe& stripe,
+                       std::chrono::steady_clock::time_point now);
+
+    /// @brief Gets the coroutine queue of a key for key-affinity scheduling
+    /// @param data the key data. Its stripe must be locked by the caller.
+    /// @param isIdle true if the key has no other task pending or running, in which case it may be moved
+    ///        to the least loaded queue
+    /// @return the queue id
+    int getAffinityQueueId(SequencerKeyData<SequenceKey>& data, bool isIdle);
+
+    /// @brief Gets the time used to measure the task latencies
+    /// @return the current time if latency statistics are collected, the epoch of the clock otherwise
+    std::chrono::steady_clock::time_point getCurrentTime() const;
+
+    /// @brief Records the latencies of a completed task in the statistics of its keys and in the task statistics
+    /// @param task the completed task. It must still be in its pending queues.
+    /// @param startTime the time the task started
+    /// @param endTime the time the task completed
+    void recordTaskLatency(const SequencerTask<SequenceKey>& task,
+                           std::chrono::steady_clock::time_point startTime,
+                           std::chrono::steady_clock::time_point endTime);
+
+    /// @brief Finds the keys of a stripe with the longest total run time
+    /// @param stripe the stripe. Must be locked by the caller.
+    /// @param count the maximum number of keys to return
+    /// @return the keys with a copy of their statistics, in decreasing order of total run time
+    static KeyStatisticsList findSlowestSequenceKeys(const Stripe& stripe, size_t count);
+
     /// @brief Execute a pending task
     /// @param ctx context
     /// @param sequencer the sequencer
@@ -285,8 +429,18 @@ private:
         Sequencer* sequencer,
         std::shared_ptr<SequencerTask<SequenceKey>> task);
 
+    /// @brief Applies the per-key pending task limit to a single-key task about to be enqueued
+    /// @param stripe the stripe holding the key. Must be locked by the caller.
+    /// @param key the key of the task
+    /// @param task the task. Its function is moved out if it replaces the last pending task of the key.
+    /// @return Enqueued if the task must be added to the pending queue, Coalesced if it replaced the last
+    ///         pending task of the key, or Rejected if the key has too many pending tasks
+    SequencerEnqueueStatus applyPendingLimit(Stripe& stripe,
+                                             const SequenceKey& key,
+                                             SequencerTask<SequenceKey>& task);
+
     template <class FUNC, class ... ARGS>
-    void
+    SequencerEnqueueStatus
     enqueueSingle(void* opaque, int queueId, bool isHighPriority, const SequenceKey& sequenceKey, FUNC&& func, ARGS&&... args);
 
     template <class FUNC, class ... ARGS>
@@ -302,12 +456,31 @@ private:
     void
     enqueueAllImpl(void* opaque, int queueId, bool isHighPriority, FUNC&& func, ARGS&&... args);
 
+    /// @brief Adds a universal task to all the pending queues and schedules it if possible
+    /// @param task the task to add
+    void enqueueUniversalTask(const std::shared_ptr<SequencerTask<SequenceKey>>& task);
+
     Dispatcher&                  _dispatcher;
     std::atomic_bool             _drain;
     SequencerKeyData<SequenceKey> _universalTaskQueue;
-    PendingTaskQueueMap          _pendingTaskQueueMap;
+    Hash                         _hash;
+    std::vector<std::unique_ptr<Stripe>> _stripes;
+    std::vector<size_t>          _allStripes;
+    std::chrono::milliseconds    _idleKeyTimeout;
+    size_t                       _idleKeyEvictionStepSize;
+    bool                         _collectLatencyStatistics;
+    size_t                       _maxPendingTasksPerKey;
+    SequencerPendingLimitPolicy  _pendingLimitPolicy;
+    bool                         _keyAffinity;
+    size_t                       _keyAffinityRebalanceThreshold;
+    size_t                       _fairShareMaxRunningTasks;
+    FairShareGroupFunction       _fairShareGroupFunction;
+    FairShareWeightFunction      _fairShareWeightFunction;
+    SpinLock                     _fairShareSpinlock;
+    FairShareFlowMap             _fairShareFlows; // the groups with ready tasks
+    std::deque<size_t>           _activeFairShareGroups; // the groups in _fairShareFlows in round robin order
+    size_t                       _numRunningFairShareTasks;
     ExceptionCallback            _exceptionCallback;
-    quantum::Mutex               _mutex;
     std::shared_ptr<SequenceKeyStatisticsWriter> _taskStats;
 };
 
@@ -23,6 +23,7 @@
 #define BLOOMBERG_QUANTUM_SEQUENCER_TASK_EXPERIMENTAL_H
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -44,15 +45,26 @@ struct SequencerTask
         bool universal,
         void* opaque,
         int queueId,
-        bool isHighPriority);
+        bool isHighPriority,
+        std::chrono::steady_clock::time_point enqueueTime);
 
     Function<int(VoidContextPtr)> _func; // the function to run
     std::vector<SequencerKeyData<SequenceKey>*> _keyData; // pointers to the key data of my keys
-    unsigned int _pendingKeyCount; // number of key queues where I am not at the head
+    std::vector<size_t> _stripes; // sorted indexes of the stripes holding my keys
+    // Number of key queues where I am not at the head. It's atomic because the queues of a task may belong to
+    // different stripes, which are updated under different locks. A universal task is only added behind other tasks
+    // of a new key queue while it is itself behind another universal task, so the count cannot drop to 0 early.
+    std::atomic_uint _pendingKeyCount;
     bool _universal; // true of universal tasks
     void* _opaque; // opaque pointer passed by user
     int _queueId; // the queue to enqueue the task
     bool _isHighPriority; // high priority task
+    std::chrono::steady_clock::time_point _enqueueTime; // only set when latency statistics are collected
+    // Set once the task has left all the pending queues. Only added by drains while the task is in its queues,
+    // whose stripes are locked when the task is removed, so they are read without locking after the removal.
+    std::vector<std::shared_ptr<Promise<int>>> _drainPromises;
+    size_t _fairShareGroup; // the fair-share group of my key
+    size_t _fairShareWeight; // the weight of my fair-share group, 0 unless I am fair-share scheduled
 };
 
 template <class SequenceKey>
@@ -62,6 +74,10 @@ struct SequencerKeyData
 
     std::list<std::shared_ptr<SequencerTask<SequenceKey>>> _tasks; // task queue
     std::shared_ptr<SequenceKeyStatisticsWriter> _stats; // stats for all tasks sharing this key
+    const SequenceKey* _key; // the key of the map entry holding this data (null for the universal queue)
+    std::chrono::steady_clock::time_point _idleSince; // when the task queue last became empty (idle eviction only)
+    bool _isIdleTracked; // true while the key is queued for idle eviction
+    int _queueId; // the coroutine queue of the key (key affinity only)
 };
 
 }}}
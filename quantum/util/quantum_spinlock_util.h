@@ -17,7 +17,9 @@
 #define QUANTUM_QUANTUM_SPINLOCK_UTIL_H
 
 #include <quantum/quantum_spinlock_traits.h>
+#include <quantum/quantum_lock_profiler.h>
 #include <atomic>
+#include <chrono>
 
 namespace Bloomberg {
 namespace quantum {
@@ -25,30 +27,63 @@ namespace quantum {
 //Adapted from https://geidav.wordpress.com/tag/test-and-test-and-set/
 struct SpinLockUtil {
     static bool lockWrite(std::atomic_uint32_t& flag,
-                          LockTraits::Attempt);
+                          LockTraits::Attempt,
+                          AdaptiveSpinLimits* limits = nullptr,
+                          LockProfiler::Counters* counters = nullptr);
     static bool lockRead(std::atomic_uint32_t& flag,
-                         LockTraits::Attempt);
+                         LockTraits::Attempt,
+                         AdaptiveSpinLimits* limits = nullptr,
+                         LockProfiler::Counters* counters = nullptr);
     static bool upgradeToWrite(std::atomic_uint32_t& flag,
-                               LockTraits::Attempt);
+                               LockTraits::Attempt,
+                               AdaptiveSpinLimits* limits = nullptr,
+                               LockProfiler::Counters* counters = nullptr);
     static bool upgradeToWrite(std::atomic_uint32_t& flag,
                                bool& pendingUpgrade,
-                               LockTraits::Attempt);
+                               LockTraits::Attempt,
+                               AdaptiveSpinLimits* limits = nullptr,
+                               LockProfiler::Counters* counters = nullptr);
     static void unlockRead(std::atomic_uint32_t& flag);
     static void unlockWrite(std::atomic_uint32_t& flag);
     static bool isLocked(const std::atomic_uint32_t& flag);
     static bool isWriteLocked(const std::atomic_uint32_t& flag);
     static uint16_t numReaders(const std::atomic_uint32_t& flag);
     static uint16_t numPendingWriters(const std::atomic_uint32_t& flag);
+    //Building blocks for locks which manage their own state
+    template <class PREDICATE>
+    static void spinWait(PREDICATE&& isBlocked,
+                         AdaptiveSpinLimits* limits = nullptr);
 private:
+    static void pauseCPU();
+    //Tracks the cost of a single acquisition for the Adaptive backoff policy and the lock profiler
+    class Contention {
+    public:
+        Contention(AdaptiveSpinLimits* limits, LockProfiler::Counters* counters);
+        size_t spinLimit() const;
+        std::chrono::microseconds sleepDuration() const;
+        void spin(size_t num);
+        void yielded();
+        void slept();
+        void spinLimitReached();
+        void acquired();
+    private:
+        AdaptiveSpinLimits*                     _limits;
+        LockProfiler::Counters*                 _counters;
+        size_t                                  _spins{0};
+        size_t                                  _yields{0};
+        size_t                                  _sleeps{0};
+        bool                                    _spinLimitReached{false};
+        std::chrono::steady_clock::time_point   _start;
+    };
     static bool upgradeToWriteImpl(std::atomic_uint32_t& flag,
                                    bool& pendingUpgrade,
-                                   LockTraits::Attempt);
-    static void yieldOrSleep(size_t& num);
+                                   LockTraits::Attempt,
+                                   Contention& contention);
+    static void yieldOrSleep(size_t& num, Contention& contention);
     static size_t generateBackoff();
-    static void backoff(size_t& num);
-    static void spinWaitWriter(std::atomic_uint32_t& flag);
-    static void spinWaitReader(std::atomic_uint32_t& flag);
-    static void pauseCPU();
+    static void backoff(size_t& num, Contention& contention);
+    static void spinWaitWriter(std::atomic_uint32_t& flag, Contention& contention);
+    static void spinWaitReader(std::atomic_uint32_t& flag, Contention& contention);
     //Bit manipulations
     static uint32_t set(int16_t upgrades, int16_t owners);
     static uint32_t add(uint32_t n, int16_t upgrade, int16_t owner);
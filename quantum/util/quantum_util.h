@@ -26,6 +26,7 @@
 #include <utility>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <iterator>
 #include <mutex>
@@ -81,6 +82,13 @@ struct Util
                                 FUNC&& func,
                                 size_t numCoroutineThreads);
     
+    template <class INPUT_IT, class FUNC>
+    static int parallelForCoro(VoidContextPtr ctx,
+                               INPUT_IT first,
+                               size_t num,
+                               FUNC&& func,
+                               size_t grainSize);
+    
     //------------------------------------------------------------------------------------------
     //                                      MapReduce
     //------------------------------------------------------------------------------------------
@@ -103,7 +111,84 @@ struct Util
                                   INPUT_IT inputIt,
                                   size_t num,
                                   const Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>& mapper,
-                                  const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer);
+                                  const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer,
+                                  const Functions::CombineFunc<MAPPED_TYPE>& combiner);
+    
+    template <class KEY,
+              class MAPPED_TYPE,
+              class REDUCED_TYPE,
+              template <class...> class OUTPUT,
+              class INPUT_IT>
+    static typename Traits::MapReduceOutput<OUTPUT, KEY, REDUCED_TYPE>::Type
+    mapReducePartitionedCoro(VoidContextPtr ctx,
+                             INPUT_IT inputIt,
+                             size_t num,
+                             const Functions::MapFunc<KEY, MAPPED_TYPE, INPUT_IT>& mapper,
+                             const Functions::ReduceFunc<KEY, MAPPED_TYPE, REDUCED_TYPE>& reducer,
+                             const Functions::CombineFunc<MAPPED_TYPE>& combiner);
+    
+    //------------------------------------------------------------------------------------------
+    //                                      Reduce & Scan
+    //------------------------------------------------------------------------------------------
+    template <class T, class INPUT_IT, class FUNC>
+    static T reduceCoro(VoidContextPtr ctx,
+                        INPUT_IT first,
+                        size_t num,
+                        T init,
+                        FUNC&& func);
+    
+    template <class T, class INPUT_IT, class REDUCE_FUNC, class TRANSFORM_FUNC>
+    static T transformReduceCoro(VoidContextPtr ctx,
+                                 INPUT_IT first,
+                                 size_t num,
+                                 T init,
+                                 REDUCE_FUNC&& reduceFunc,
+                                 TRANSFORM_FUNC&& transformFunc);
+    
+    template <class INPUT_IT, class OUTPUT_IT, class FUNC>
+    static OUTPUT_IT inclusiveScanCoro(VoidContextPtr ctx,
+                                       INPUT_IT first,
+                                       size_t num,
+                                       OUTPUT_IT outputIt,
+                                       FUNC&& func);
+    
+    template <class T, class INPUT_IT, class OUTPUT_IT, class FUNC>
+    static OUTPUT_IT exclusiveScanCoro(VoidContextPtr ctx,
+                                       INPUT_IT first,
+                                       size_t num,
+                                       OUTPUT_IT outputIt,
+                                       T init,
+                                       FUNC&& func);
+    
+    template <class T, class INPUT_IT, class OUTPUT_IT, class FUNC>
+    static OUTPUT_IT scanCoro(VoidContextPtr ctx,
+                              INPUT_IT first,
+                              size_t num,
+                              OUTPUT_IT outputIt,
+                              const T* init,
+                              FUNC& func);
+    
+    //------------------------------------------------------------------------------------------
+    //                                      Sort & Partition
+    //------------------------------------------------------------------------------------------
+    template <class RANDOM_IT, class COMPARE>
+    static int sortCoro(VoidContextPtr ctx,
+                        RANDOM_IT first,
+                        size_t num,
+                        COMPARE&& compare);
+    
+    template <class RANDOM_IT, class PREDICATE>
+    static RANDOM_IT partitionCoro(VoidContextPtr ctx,
+                                   RANDOM_IT first,
+                                   size_t num,
+                                   PREDICATE&& predicate);
+    
+    template <class RANDOM_IT, class COMPARE>
+    static int nthElementCoro(VoidContextPtr ctx,
+                              RANDOM_IT first,
+                              size_t nth,
+                              size_t num,
+                              COMPARE&& compare);
     
 #ifdef __QUANTUM_PRINT_DEBUG
     //Synchronize logging
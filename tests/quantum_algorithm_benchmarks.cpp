@@ -0,0 +1,149 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: This file is built into a separate optimized benchmark binary which is not run by ctest.
+#include <gtest/gtest.h>
+#include <quantum/quantum.h>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+#ifdef QUANTUM_BENCHMARK_PARALLEL_STL
+#include <execution>
+#endif
+
+using namespace Bloomberg::quantum;
+using Clock = std::chrono::steady_clock;
+
+const size_t numRepetitions = 5;
+
+Configuration makeDispatcherConfiguration()
+{
+    Configuration config;
+    config.setNumCoroutineThreads(4).setNumIoThreads(1);
+    return config;
+}
+
+// Returns the best of several runs to filter out the noise
+template <class FUNC>
+std::chrono::nanoseconds measure(FUNC&& func)
+{
+    std::chrono::nanoseconds best = std::chrono::nanoseconds::max();
+    for (size_t i = 0; i < numRepetitions; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        func();
+        best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start));
+    }
+    return best;
+}
+
+void printResult(const std::string& name, size_t num, std::chrono::nanoseconds time)
+{
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << num << " elements"
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << std::chrono::duration<double, std::micro>(time).count() << "us"
+              << std::setw(10) << (double)time.count() / num << "ns/element"
+              << std::endl;
+}
+
+TEST(AlgorithmBenchmark, Reduce)
+{
+    Dispatcher dispatcher(makeDispatcherConfiguration());
+    for (size_t num : {10000, 1000000, 10000000})
+    {
+        std::vector<double> values(num);
+        std::iota(values.begin(), values.end(), 0.0);
+        double expected = std::accumulate(values.begin(), values.end(), 0.0);
+        volatile double result = 0; //keeps the sequential version from being hoisted out of the timing loop
+
+        printResult("std::accumulate", num, measure([&]{
+            result = std::accumulate(values.begin(), values.end(), 0.0);
+        }));
+#ifdef QUANTUM_BENCHMARK_PARALLEL_STL
+        printResult("std::reduce(par)", num, measure([&]{
+            result = std::reduce(std::execution::par, values.begin(), values.end(), 0.0);
+        }));
+        EXPECT_DOUBLE_EQ(expected, result);
+#endif
+        printResult("Dispatcher::reduce", num, measure([&]{
+            result = dispatcher.reduce(values.begin(), values.end(), 0.0, std::plus<double>())->get();
+        }));
+        EXPECT_DOUBLE_EQ(expected, result);
+    }
+}
+
+TEST(AlgorithmBenchmark, TransformReduce)
+{
+    Dispatcher dispatcher(makeDispatcherConfiguration());
+    auto transform = [](double value)->double { return std::sqrt(value); };
+    for (size_t num : {10000, 1000000, 10000000})
+    {
+        std::vector<double> values(num);
+        std::iota(values.begin(), values.end(), 0.0);
+        volatile double result = 0; //keeps the sequential version from being hoisted out of the timing loop
+
+        printResult("sequential transform-reduce", num, measure([&]{
+            double sum = 0;
+            for (double value : values)
+            {
+                sum += transform(value);
+            }
+            result = sum;
+        }));
+        double expected = result;
+#ifdef QUANTUM_BENCHMARK_PARALLEL_STL
+        printResult("std::transform_reduce(par)", num, measure([&]{
+            result = std::transform_reduce(std::execution::par, values.begin(), values.end(), 0.0,
+                                           std::plus<double>(), transform);
+        }));
+        EXPECT_NEAR(expected, result, 1e-9 * expected);
+#endif
+        printResult("Dispatcher::transformReduce", num, measure([&]{
+            result = dispatcher.transformReduce(values.begin(), values.end(), 0.0,
+                                                std::plus<double>(), transform)->get();
+        }));
+        EXPECT_NEAR(expected, result, 1e-9 * expected);
+    }
+}
+
+TEST(AlgorithmBenchmark, InclusiveScan)
+{
+    Dispatcher dispatcher(makeDispatcherConfiguration());
+    for (size_t num : {10000, 1000000, 10000000})
+    {
+        std::vector<long> values(num, 1);
+        std::vector<long> results(num);
+
+        printResult("std::partial_sum", num, measure([&]{
+            std::partial_sum(values.begin(), values.end(), results.begin());
+        }));
+#ifdef QUANTUM_BENCHMARK_PARALLEL_STL
+        printResult("std::inclusive_scan(par)", num, measure([&]{
+            std::inclusive_scan(std::execution::par, values.begin(), values.end(), results.begin());
+        }));
+        EXPECT_EQ((long)num, results.back());
+#endif
+        printResult("Dispatcher::inclusiveScan", num, measure([&]{
+            dispatcher.inclusiveScan(values.begin(), values.end(), results.begin(), std::plus<long>())->get();
+        }));
+        EXPECT_EQ((long)num, results.back());
+    }
+}
@@ -0,0 +1,188 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+#include <quantum/quantum_dispatcher.h>
+#include <quantum/util/quantum_async_cache.h>
+#include <quantum_fixture.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Bloomberg::quantum;
+
+namespace {
+
+using Cache = AsyncCache<int, std::string>;
+
+std::vector<ThreadContextPtr<std::string>>
+fetchConcurrently(Dispatcher& dispatcher,
+                  Cache& cache,
+                  int key,
+                  int numCallers,
+                  std::atomic_int& numLoads)
+{
+    std::vector<ThreadContextPtr<std::string>> results;
+    for (int i = 0; i < numCallers; ++i) {
+        results.push_back(dispatcher.post([&cache, &numLoads, key](VoidContextPtr ctx)->std::string {
+            return cache.get(ctx, key, [&numLoads, key](VoidContextPtr loaderCtx)->std::string {
+                ++numLoads;
+                loaderCtx->sleep(std::chrono::milliseconds(20)); //give other callers time to join
+                return std::to_string(key);
+            });
+        }));
+    }
+    return results;
+}
+
+}
+
+TEST(AsyncCache, SingleFlight)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache;
+    std::atomic_int numLoads{0};
+    auto results = fetchConcurrently(dispatcher, cache, 7, 20, numLoads);
+    for (auto&& result : results) {
+        EXPECT_EQ("7", result->get());
+    }
+    EXPECT_EQ(1, numLoads);
+    EXPECT_EQ(1u, cache.size());
+    
+    //cached
+    results = fetchConcurrently(dispatcher, cache, 7, 5, numLoads);
+    for (auto&& result : results) {
+        EXPECT_EQ("7", result->get());
+    }
+    EXPECT_EQ(1, numLoads);
+    
+    //invalidated
+    EXPECT_TRUE(cache.erase(7));
+    EXPECT_FALSE(cache.erase(7));
+    results = fetchConcurrently(dispatcher, cache, 7, 5, numLoads);
+    for (auto&& result : results) {
+        EXPECT_EQ("7", result->get());
+    }
+    EXPECT_EQ(2, numLoads);
+}
+
+TEST(AsyncCache, AsyncIoLoader)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache;
+    std::atomic_int numLoads{0};
+    std::vector<ThreadContextPtr<std::string>> results;
+    for (int i = 0; i < 10; ++i) {
+        results.push_back(dispatcher.post([&cache, &numLoads](VoidContextPtr ctx)->std::string {
+            return cache.getAsyncIo(ctx, 3, [&numLoads](const std::string& prefix)->std::string {
+                ++numLoads;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return prefix + "3";
+            }, std::string("io"));
+        }));
+    }
+    for (auto&& result : results) {
+        EXPECT_EQ("io3", result->get());
+    }
+    EXPECT_EQ(1, numLoads);
+}
+
+TEST(AsyncCache, LoaderExceptionIsNotCached)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache;
+    std::atomic_int numLoads{0};
+    auto fetch = [&](bool fail)->ThreadContextPtr<std::string> {
+        return dispatcher.post([&cache, &numLoads, fail](VoidContextPtr ctx)->std::string {
+            return cache.get(ctx, 1, [&numLoads, fail](VoidContextPtr)->std::string {
+                ++numLoads;
+                if (fail) {
+                    throw std::runtime_error("load failed");
+                }
+                return "1";
+            });
+        });
+    };
+    EXPECT_THROW(fetch(true)->get(), std::runtime_error);
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ("1", fetch(false)->get());
+    EXPECT_EQ(2, numLoads);
+}
+
+TEST(AsyncCache, TimeToLive)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache(0, std::chrono::milliseconds(50));
+    std::atomic_int numLoads{0};
+    EXPECT_EQ("5", fetchConcurrently(dispatcher, cache, 5, 1, numLoads).front()->get());
+    EXPECT_EQ("5", fetchConcurrently(dispatcher, cache, 5, 1, numLoads).front()->get());
+    EXPECT_EQ(1, numLoads);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ("5", fetchConcurrently(dispatcher, cache, 5, 1, numLoads).front()->get());
+    EXPECT_EQ(2, numLoads);
+}
+
+TEST(AsyncCache, LruEviction)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache(2, std::chrono::milliseconds::zero(), 1);
+    std::atomic_int numLoads{0};
+    auto fetch = [&](int key) {
+        EXPECT_EQ(std::to_string(key), fetchConcurrently(dispatcher, cache, key, 1, numLoads).front()->get());
+    };
+    fetch(1);
+    fetch(2);
+    fetch(1); //2 is now the least recently used
+    fetch(3); //evicts 2
+    EXPECT_EQ(3, numLoads);
+    EXPECT_EQ(2u, cache.size());
+    fetch(1);
+    EXPECT_EQ(3, numLoads);
+    fetch(2);
+    EXPECT_EQ(4, numLoads);
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST(AsyncCache, LoadingKeysAreNotEvicted)
+{
+    Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    Cache cache(1, std::chrono::milliseconds::zero(), 1);
+    std::atomic_int numSlowLoads{0};
+    auto fetchSlow = [&]()->ThreadContextPtr<std::string> {
+        return dispatcher.post([&cache, &numSlowLoads](VoidContextPtr ctx)->std::string {
+            return cache.get(ctx, 1, [&numSlowLoads](VoidContextPtr loaderCtx)->std::string {
+                ++numSlowLoads;
+                loaderCtx->sleep(std::chrono::milliseconds(100));
+                return "1";
+            });
+        });
+    };
+    auto first = fetchSlow();
+    while (numSlowLoads == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    //Fill the shard while key 1 is still loading
+    std::atomic_int numLoads{0};
+    EXPECT_EQ("2", fetchConcurrently(dispatcher, cache, 2, 1, numLoads).front()->get());
+    //Key 1 must still be in flight so the second caller shares the first load
+    auto second = fetchSlow();
+    EXPECT_EQ("1", first->get());
+    EXPECT_EQ("1", second->get());
+    EXPECT_EQ(1, numSlowLoads);
+    EXPECT_EQ(1u, cache.size());
+}
@@ -0,0 +1,217 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: This file is built into a separate test binary with __QUANTUM_ENABLE_LOCK_PROFILING defined.
+#include <gtest/gtest.h>
+#include <quantum/quantum.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace Bloomberg::quantum;
+using ms = std::chrono::milliseconds;
+
+static_assert(LockProfiler::isEnabled(), "Lock profiling must be enabled for these tests");
+
+//Holds which took longer than ~8ms. Bucket 'i' counts [2^i, 2^(i+1)) nanoseconds.
+size_t numLongHolds(const LockStatistics& stats)
+{
+    LockStatistics::HoldTimeHistogram histogram = stats.holdTimeHistogram();
+    size_t num = 0;
+    for (size_t i = 23; i < histogram.size(); ++i) {
+        num += histogram[i];
+    }
+    return num;
+}
+
+LockStatistics& resetStatistics(const std::string& name)
+{
+    LockStatistics& stats = LockProfiler::instance().statistics(name);
+    stats.reset();
+    return stats;
+}
+
+TEST(LockProfiler, ContendedSpinLock)
+{
+    SpinLock lock("LockProfilerTest::spinlock");
+    SpinLock unnamed;
+    LockStatistics& stats = resetStatistics("LockProfilerTest::spinlock");
+
+    lock.lock();
+    unnamed.lock();
+    std::thread waiter([&]{
+        SpinLock::Guard guard(lock);
+    });
+    std::this_thread::sleep_for(ms(20));
+    unnamed.unlock();
+    lock.unlock();
+    waiter.join();
+
+    //The waiter exhausts its spins and yields before sleeping
+    EXPECT_EQ(2, stats.numAcquisitions());
+    EXPECT_EQ(1, stats.numContendedAcquisitions());
+    EXPECT_EQ(SpinLockTraits::maxSpins(), stats.numSpins());
+    EXPECT_EQ(SpinLockTraits::numYieldsBeforeSleep(), stats.numYields());
+    EXPECT_LT(0, stats.numSleeps());
+    EXPECT_EQ(1, numLongHolds(stats));
+
+    //Uncontended acquisitions are counted but do not spin
+    stats.reset();
+    for (int i = 0; i < 10; ++i) {
+        SpinLock::Guard guard(lock);
+    }
+    EXPECT_TRUE(lock.tryLock());
+    lock.unlock();
+    EXPECT_EQ(11, stats.numAcquisitions());
+    EXPECT_EQ(0, stats.numContendedAcquisitions());
+    EXPECT_EQ(0, stats.numSpins());
+}
+
+TEST(LockProfiler, ContendedMutexOnThread)
+{
+    Mutex mutex("LockProfilerTest::mutex");
+    LockStatistics& stats = resetStatistics("LockProfilerTest::mutex");
+
+    mutex.lock();
+    std::thread waiter([&]{
+        Mutex::Guard guard(mutex);
+    });
+    std::this_thread::sleep_for(ms(20));
+    mutex.unlock();
+    waiter.join();
+
+    EXPECT_EQ(2, stats.numAcquisitions());
+    EXPECT_EQ(1, stats.numContendedAcquisitions());
+    EXPECT_EQ(0, stats.numSpins());
+    EXPECT_LT(0, stats.numYields());
+    EXPECT_EQ(1, numLongHolds(stats));
+}
+
+TEST(LockProfiler, CoroutineYieldsAreChargedToTheirOwnLock)
+{
+    Configuration config;
+    config.setNumCoroutineThreads(1).setNumIoThreads(1);
+    Dispatcher dispatcher(config);
+    Mutex contended("LockProfilerTest::contendedMutex");
+    Mutex uncontended("LockProfilerTest::uncontendedMutex");
+    LockStatistics& contendedStats = resetStatistics("LockProfilerTest::contendedMutex");
+    LockStatistics& uncontendedStats = resetStatistics("LockProfilerTest::uncontendedMutex");
+    const int numYields = 100;
+
+    //All three coroutines share the same thread and run in posting order
+    auto owner = dispatcher.post([&](VoidContextPtr ctx)->int {
+        Mutex::Guard guard(ctx, contended);
+        for (int i = 0; i < numYields; ++i) {
+            ctx->yield();
+        }
+        return 0;
+    });
+    auto waiter = dispatcher.post([&](VoidContextPtr ctx)->int {
+        Mutex::Guard guard(ctx, contended);
+        return 0;
+    });
+    auto other = dispatcher.post([&](VoidContextPtr ctx)->int {
+        for (int i = 0; i < numYields; ++i) {
+            Mutex::Guard guard(ctx, uncontended);
+            ctx->yield();
+        }
+        return 0;
+    });
+    owner->get();
+    waiter->get();
+    other->get();
+
+    EXPECT_EQ(2, contendedStats.numAcquisitions());
+    EXPECT_EQ(1, contendedStats.numContendedAcquisitions());
+    EXPECT_LT(0, contendedStats.numYields());
+    //The waiter's yields are not charged to the other coroutine's lock
+    EXPECT_EQ(numYields, uncontendedStats.numAcquisitions());
+    EXPECT_EQ(0, uncontendedStats.numContendedAcquisitions());
+    EXPECT_EQ(0, uncontendedStats.numYields());
+}
+
+TEST(LockProfiler, ContendedReadWriteSpinLock)
+{
+    ReadWriteSpinLock lock("LockProfilerTest::rwlock");
+    LockStatistics& stats = resetStatistics("LockProfilerTest::rwlock");
+
+    //Reader blocked by a writer
+    lock.lockWrite();
+    std::thread reader([&]{
+        ReadWriteSpinLock::Guard guard(lock, lock::acquireRead);
+    });
+    std::this_thread::sleep_for(ms(20));
+    lock.unlockWrite();
+    reader.join();
+    EXPECT_EQ(2, stats.numAcquisitions());
+    EXPECT_EQ(1, stats.numContendedAcquisitions());
+    EXPECT_LT(0, stats.numSpins());
+    EXPECT_EQ(1, numLongHolds(stats));
+
+    //Upgrade blocked by a second reader
+    stats.reset();
+    lock.lockRead();
+    std::thread upgrader([&]{
+        lock.lockRead();
+        lock.upgradeToWrite();
+        lock.unlockWrite();
+    });
+    std::this_thread::sleep_for(ms(20));
+    lock.unlockRead();
+    upgrader.join();
+    EXPECT_EQ(3, stats.numAcquisitions());
+    EXPECT_EQ(1, stats.numContendedAcquisitions());
+    EXPECT_LT(0, stats.numSpins());
+    //Only exclusive ownership is timed
+    size_t numHolds = 0;
+    for (size_t count : stats.holdTimeHistogram()) {
+        numHolds += count;
+    }
+    EXPECT_EQ(1, numHolds);
+
+    //Try-locks are never contended
+    stats.reset();
+    EXPECT_TRUE(lock.tryLockRead());
+    EXPECT_TRUE(lock.tryUpgradeToWrite());
+    lock.unlockWrite();
+    EXPECT_TRUE(lock.tryLockWrite());
+    lock.unlockWrite();
+    EXPECT_EQ(3, stats.numAcquisitions());
+    EXPECT_EQ(0, stats.numContendedAcquisitions());
+}
+
+TEST(LockProfiler, TaskQueueLocksAreNamedPerQueue)
+{
+    Configuration config;
+    config.setNumCoroutineThreads(2).setNumIoThreads(1);
+    {
+        Dispatcher dispatcher(config);
+        for (int queueId = 0; queueId < 2; ++queueId) {
+            dispatcher.post(queueId, false, [](VoidContextPtr)->int {
+                return 0;
+            })->get();
+        }
+    }
+    std::set<std::string> names;
+    LockProfiler::instance().forEach([&](const LockStatistics& stats) {
+        if (stats.numAcquisitions() > 0) {
+            names.insert(stats.name());
+        }
+    });
+    EXPECT_EQ(1, names.count("TaskQueue[0]::runQueueLock"));
+    EXPECT_EQ(1, names.count("TaskQueue[1]::runQueueLock"));
+    EXPECT_EQ(0, names.count("TaskQueue::runQueueLock"));
+}
@@ -14,12 +14,14 @@
 ** limitations under the License.
 */
 #include <quantum_fixture.h>
+#include <quantum_perf_utils.h>
 #include <gtest/gtest.h>
 #include <quantum/quantum.h>
 #include <chrono>
 #include <ctime>
 #include <thread>
 #include <memory>
+#include <sstream>
 
 using namespace Bloomberg::quantum;
 using us = std::chrono::microseconds;
@@ -169,6 +171,116 @@ TEST(Locks, Spinlock_HighContention)
     spinlockSettings(0, 0, us(10), 2000, i++, enable); //6
 }
 
+TEST(Locks, Spinlock_AdaptiveLimits)
+{
+    size_t minSpins = SpinLockTraits::minSpins();
+    size_t maxSpins = SpinLockTraits::maxSpins();
+    us sleepDuration = SpinLockTraits::sleepDuration();
+    SpinLockTraits::minSpins() = 100;
+    SpinLockTraits::maxSpins() = 5000;
+    SpinLockTraits::sleepDuration() = us(200);
+    
+    AdaptiveSpinLimits limits;
+    EXPECT_EQ(100u, limits.spinLimit());
+    EXPECT_EQ(us(1), limits.sleepDuration());
+    
+    //Short critical sections raise the spin limit
+    for (int i = 0; i < 100; ++i) {
+        limits.update(1000, false, std::chrono::microseconds(2));
+    }
+    EXPECT_GT(limits.spinLimit(), 2000u);
+    EXPECT_LE(limits.spinLimit(), 2100u);
+    EXPECT_EQ(us(1), limits.sleepDuration());
+    
+    //Long critical sections keep exhausting the limit so it grows up to maxSpins
+    size_t previous = limits.spinLimit();
+    int numUpdates = 0;
+    while (limits.spinLimit() < 5000u) {
+        limits.update(limits.spinLimit(), true, std::chrono::microseconds(100));
+        EXPECT_GT(limits.spinLimit(), previous);
+        previous = limits.spinLimit();
+        ASSERT_LT(++numUpdates, 100);
+    }
+    //...and lengthen the sleep up to the configured duration
+    for (int i = 0; i < 100; ++i) {
+        limits.update(2100, true, std::chrono::microseconds(100));
+    }
+    EXPECT_EQ(5000u, limits.spinLimit());
+    EXPECT_GT(limits.sleepDuration(), us(40));
+    EXPECT_LE(limits.sleepDuration(), us(50));
+    for (int i = 0; i < 100; ++i) {
+        limits.update(2100, true, std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(us(200), limits.sleepDuration());
+    
+    //Short critical sections decay it back towards the spins which sufficed
+    for (int i = 0; i < 200; ++i) {
+        limits.update(10, false, std::chrono::nanoseconds(100));
+        EXPECT_LE(limits.spinLimit(), previous);
+        previous = limits.spinLimit();
+    }
+    //The fixed point average converges to the samples instead of stalling above them
+    EXPECT_EQ(120u, limits.spinLimit());
+    EXPECT_EQ(us(1), limits.sleepDuration());
+    
+    SpinLockTraits::minSpins() = minSpins;
+    SpinLockTraits::maxSpins() = maxSpins;
+    SpinLockTraits::sleepDuration() = sleepDuration;
+}
+
+TEST(Locks, Spinlock_AdaptiveBackoff)
+{
+    SpinLockTraits::BackoffPolicy policy = SpinLockTraits::backoffPolicy();
+    SpinLockTraits::backoffPolicy() = SpinLockTraits::BackoffPolicy::Adaptive;
+    
+    //Short critical sections
+    val = 0;
+    SpinLock spin;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < spins; ++i) {
+                SpinLock::Guard guard(spin);
+                ++val;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(4*spins, val);
+    
+    //Long critical sections
+    val = 0;
+    runThreads(20);
+    EXPECT_EQ(20*numLockAcquires, val);
+    
+    //Readers and writers
+    ReadWriteSpinLock rwlock;
+    threads.clear();
+    val = 0;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < spins/10; ++i) {
+                if (t == 0) {
+                    ReadWriteSpinLock::Guard guard(rwlock, lock::acquireWrite);
+                    ++val;
+                }
+                else {
+                    ReadWriteSpinLock::Guard guard(rwlock, lock::acquireRead);
+                    EXPECT_GE(val, 0);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(spins/10, val);
+    
+    SpinLockTraits::backoffPolicy() = policy;
+}
+
 TEST(Locks, ReadWriteSpinLock_LockReadMultipleTimes)
 {
     ReadWriteSpinLock spin;
@@ -574,6 +686,193 @@ TEST(Locks, ReadWriteSpinLock_UpgradeMultipleReaders)
     EXPECT_EQ(numThreads, data.size());
 }
 
+//==============================================================================
+//                      SHARDEDREADWRITESPINLOCK TESTS
+//==============================================================================
+
+TEST(Locks, ShardedReadWriteSpinLock_SingleLocks)
+{
+    ShardedReadWriteSpinLock lock(4);
+    EXPECT_EQ(4, lock.numSlots());
+
+    EXPECT_FALSE(lock.isLocked());
+    EXPECT_EQ(0, lock.numReaders());
+
+    lock.lockRead();
+    lock.lockRead();
+    EXPECT_TRUE(lock.isLocked());
+    EXPECT_TRUE(lock.isReadLocked());
+    EXPECT_FALSE(lock.isWriteLocked());
+    EXPECT_EQ(2, lock.numReaders());
+    EXPECT_FALSE(lock.tryLockWrite());
+    EXPECT_FALSE(lock.tryUpgradeToWrite());
+    EXPECT_EQ(2, lock.numReaders());
+    lock.unlockRead();
+    EXPECT_TRUE(lock.tryUpgradeToWrite());
+    EXPECT_TRUE(lock.isWriteLocked());
+    EXPECT_EQ(0, lock.numReaders());
+    EXPECT_FALSE(lock.tryLockRead());
+    lock.unlockRead(); //no-op
+    EXPECT_TRUE(lock.isWriteLocked());
+    lock.unlockWrite();
+    EXPECT_FALSE(lock.isLocked());
+
+    lock.lockWrite();
+    EXPECT_TRUE(lock.isWriteLocked());
+    EXPECT_FALSE(lock.tryLockWrite());
+    lock.unlockWrite();
+    lock.unlockWrite(); //no-op
+    EXPECT_FALSE(lock.isLocked());
+
+    {
+        ShardedReadWriteSpinLock::Guard guard(lock, lock::acquireRead);
+        EXPECT_TRUE(guard.ownsReadLock());
+        guard.upgradeToWrite();
+        EXPECT_TRUE(guard.ownsWriteLock());
+        EXPECT_TRUE(lock.isWriteLocked());
+    }
+    EXPECT_FALSE(lock.isLocked());
+}
+
+TEST(Locks, ShardedReadWriteSpinLock_LockReadAndWrite)
+{
+    int num = spins;
+    int val = 0;
+    ShardedReadWriteSpinLock spin;
+    auto reader = [&, num]() mutable {
+        while (num--) {
+            ShardedReadWriteSpinLock::Guard guard(spin, lock::acquireRead);
+            EXPECT_TRUE((val == 0) || (val == 1));
+        }
+    };
+    auto writer = [&, num]() mutable {
+        while (num--) {
+            ShardedReadWriteSpinLock::Guard guard(spin, lock::acquireWrite);
+            ++val;
+            --val;
+        }
+    };
+    std::thread t1(reader);
+    std::thread t2(reader);
+    std::thread t3(reader);
+    std::thread t4(writer);
+    std::thread t5(writer);
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    t5.join();
+    EXPECT_EQ(0, val);
+    EXPECT_FALSE(spin.isLocked());
+}
+
+TEST(Locks, ShardedReadWriteSpinLock_UpgradeMultipleReaders)
+{
+    ShardedReadWriteSpinLock lock;
+    std::vector<std::thread> threads;
+    std::vector<int> data; //container to be modified under write lock
+    auto timeToWake = std::chrono::system_clock::now() + ms(10);
+    std::atomic_int count{0};
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back([&lock, &timeToWake, &count, &data, i]() {
+            lock.lockRead();
+            ++count;
+            std::this_thread::sleep_until(timeToWake);
+            lock.upgradeToWrite();
+            data.push_back(i);
+            EXPECT_TRUE(lock.isWriteLocked());
+            lock.unlockWrite();
+        });
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(0, lock.numReaders());
+    EXPECT_EQ(0, lock.numPendingWriters());
+    EXPECT_FALSE(lock.isLocked());
+    EXPECT_EQ(numThreads, data.size());
+}
+
+TEST(Locks, ShardedReadWriteSpinLock_UnmatchedUnlockRead)
+{
+    ShardedReadWriteSpinLock lock(4);
+    lock.unlockRead(); //no-op
+    EXPECT_FALSE(lock.isLocked());
+    EXPECT_EQ(0, lock.numReaders());
+    //a writer must still see the lock as free
+    EXPECT_TRUE(lock.tryLockWrite());
+    lock.unlockWrite();
+
+    lock.lockRead();
+    lock.unlockRead();
+    lock.unlockRead(); //no-op
+    EXPECT_FALSE(lock.isLocked());
+    lock.lockRead();
+    EXPECT_EQ(1, lock.numReaders());
+    EXPECT_FALSE(lock.tryLockWrite());
+    lock.unlockRead();
+    EXPECT_TRUE(lock.tryLockWrite());
+    lock.unlockWrite();
+}
+
+TEST(Locks, ShardedReadWriteSpinLock_NumPendingWriters)
+{
+    const int numWriters = 3;
+    ShardedReadWriteSpinLock lock;
+    EXPECT_EQ(0, lock.numPendingWriters());
+    lock.lockRead();
+    std::vector<std::thread> writers;
+    for (int i = 0; i < numWriters; ++i) {
+        writers.emplace_back([&lock]() {
+            ShardedReadWriteSpinLock::Guard guard(lock, lock::acquireWrite);
+        });
+    }
+    while (lock.numPendingWriters() < numWriters) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(numWriters, lock.numPendingWriters());
+    lock.unlockRead();
+    for (auto&& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(0, lock.numPendingWriters());
+    EXPECT_FALSE(lock.isLocked());
+}
+
+template <class LOCK>
+void runReadScaling(const char* name, int numReaders)
+{
+    LOCK spin;
+    std::vector<int> table(16, 1);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numReaders; ++i) {
+        threads.emplace_back([&]() {
+            int sum = 0;
+            for (int n = 0; n < spins; ++n) {
+                typename LOCK::Guard guard(spin, lock::acquireRead);
+                sum += table[n % table.size()];
+            }
+            EXPECT_EQ(spins, sum);
+        });
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    //Results are saved in the test report (e.g. --gtest_output=xml)
+    ::testing::Test::RecordProperty(std::string(name) + ".readers" + std::to_string(numReaders) + ".elapsedUs",
+        (int)std::chrono::duration_cast<us>(end-start).count());
+}
+
+TEST(Locks, ShardedReadWriteSpinLock_ReadScaling)
+{
+    for (int numReaders : {1, 2, 4, 8}) {
+        runReadScaling<ReadWriteSpinLock>("ReadWriteSpinLock", numReaders);
+        runReadScaling<ShardedReadWriteSpinLock>("ShardedReadWriteSpinLock", numReaders);
+    }
+}
+
 //==============================================================================
 //                         READWRITEMUTEX TESTS
 //==============================================================================
@@ -1020,3 +1319,355 @@ TEST(Locks, ReadWriteMutex_MultipleReadLocks) {
     EXPECT_FALSE(mutex.isLocked());
     EXPECT_EQ(0, mutex.numReaders());
 }
+
+//==============================================================================
+//                      PARKINGREADWRITEMUTEX TESTS
+//==============================================================================
+
+TEST(Locks, ParkingReadWriteMutex_SingleLocks)
+{
+    ParkingReadWriteMutex mutex;
+
+    EXPECT_TRUE(mutex.preferWriters());
+    EXPECT_FALSE(mutex.isLocked());
+    EXPECT_EQ(0, mutex.numReaders());
+
+    mutex.lockRead();
+    EXPECT_TRUE(mutex.isReadLocked());
+    EXPECT_FALSE(mutex.isWriteLocked());
+    EXPECT_EQ(1, mutex.numReaders());
+    EXPECT_TRUE(mutex.tryLockRead());
+    EXPECT_EQ(2, mutex.numReaders());
+    EXPECT_FALSE(mutex.tryLockWrite());
+    EXPECT_FALSE(mutex.tryUpgradeToWrite());
+    mutex.unlockRead();
+    EXPECT_TRUE(mutex.tryUpgradeToWrite());
+    EXPECT_FALSE(mutex.isReadLocked());
+    EXPECT_TRUE(mutex.isWriteLocked());
+    EXPECT_EQ(0, mutex.numReaders());
+    EXPECT_FALSE(mutex.tryLockRead());
+    EXPECT_FALSE(mutex.tryLockWrite());
+    mutex.unlockWrite();
+    EXPECT_FALSE(mutex.isLocked());
+
+    mutex.lockWrite();
+    EXPECT_TRUE(mutex.isWriteLocked());
+    mutex.unlockWrite();
+    EXPECT_FALSE(mutex.isLocked());
+
+    {
+        ParkingReadWriteMutex::Guard guard(mutex, lock::acquireRead);
+        EXPECT_TRUE(guard.ownsReadLock());
+        guard.upgradeToWrite();
+        EXPECT_TRUE(guard.ownsWriteLock());
+        EXPECT_TRUE(mutex.isWriteLocked());
+    }
+    EXPECT_FALSE(mutex.isLocked());
+    {
+        ParkingReadWriteMutex::Guard guard(mutex, lock::acquireWrite, lock::tryToLock);
+        EXPECT_TRUE(guard.ownsWriteLock());
+        ParkingReadWriteMutex::Guard guard2(mutex, lock::acquireRead, lock::tryToLock);
+        EXPECT_FALSE(guard2.ownsLock());
+    }
+    EXPECT_FALSE(mutex.isLocked());
+}
+
+TEST(Locks, ParkingReadWriteMutex_WriterPreference)
+{
+    ParkingReadWriteMutex mutex(true);
+    std::atomic_bool writerDone{false};
+
+    mutex.lockRead();
+    std::thread writer([&]() {
+        ParkingReadWriteMutex::Guard guard(mutex, lock::acquireWrite);
+        writerDone = true;
+    });
+    while (mutex.numPendingWriters() == 0) {
+        std::this_thread::yield();
+    }
+    //new readers must queue behind the parked writer
+    EXPECT_FALSE(mutex.tryLockRead());
+    std::thread reader([&]() {
+        ParkingReadWriteMutex::Guard guard(mutex, lock::acquireRead);
+        //writer was served first
+        EXPECT_TRUE(writerDone);
+    });
+    while (mutex.numPendingReaders() == 0) {
+        std::this_thread::yield();
+    }
+    mutex.unlockRead();
+    writer.join();
+    reader.join();
+    EXPECT_FALSE(mutex.isLocked());
+    
+    //without preference readers keep entering while the writer is parked
+    ParkingReadWriteMutex readerMutex(false);
+    readerMutex.lockRead();
+    std::thread writer2([&]() {
+        ParkingReadWriteMutex::Guard guard(readerMutex, lock::acquireWrite);
+    });
+    while (readerMutex.numPendingWriters() == 0) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(readerMutex.tryLockRead());
+    EXPECT_EQ(2, readerMutex.numReaders());
+    readerMutex.unlockRead();
+    readerMutex.unlockRead();
+    writer2.join();
+    EXPECT_FALSE(readerMutex.isLocked());
+}
+
+TEST(Locks, ParkingReadWriteMutex_BatchReaderWakeup)
+{
+    ParkingReadWriteMutex mutex;
+    std::atomic_int numReaders{0};
+    std::atomic_bool run{true};
+
+    mutex.lockWrite();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 10; ++i) {
+        threads.emplace_back([&]() {
+            ParkingReadWriteMutex::Guard guard(mutex, lock::acquireRead);
+            ++numReaders;
+            while (run) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (mutex.numPendingReaders() < 10) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0, numReaders);
+    //releasing the writer hands over the lock to all readers at once
+    mutex.unlockWrite();
+    EXPECT_EQ(10, mutex.numReaders());
+    EXPECT_EQ(0, mutex.numPendingReaders());
+    while (numReaders < 10) {
+        std::this_thread::yield();
+    }
+    run = false;
+    for (auto&& t : threads) {
+        t.join();
+    }
+    EXPECT_FALSE(mutex.isLocked());
+}
+
+TEST(Locks, ParkingReadWriteMutex_CoroUpgradeToWrite)
+{
+    int numCoros = numThreads*10; //increase load
+    const TestConfiguration noCoroSharingConfig(false, false);
+    quantum::Dispatcher& dispatcher = DispatcherSingleton::instance(noCoroSharingConfig);
+    
+    ParkingReadWriteMutex rwMutex;
+    int locksAcquired = -1;
+    ConditionVariable cond;
+    Mutex mutex;
+    std::atomic<int> numReadLocks{0};
+    
+    auto job = [&](VoidContextPtr ctx) mutable -> int {
+        ParkingReadWriteMutex::Guard rwGuard(ctx, rwMutex, lock::acquireRead);
+        numReadLocks++;
+        {
+            Mutex::Guard guard(ctx, mutex);
+            cond.wait(ctx, mutex, [&]() -> bool { return locksAcquired == 0; });
+        }
+        rwGuard.upgradeToWrite(ctx);
+        locksAcquired++;
+        //hold lock for a small period of time
+        ctx->yield();
+        return 0;
+    };
+    
+    std::vector<ThreadContextPtr<int>> futures;
+    futures.reserve(numCoros);
+    
+    for (int i = 0; i < numCoros; i++) {
+        futures.emplace_back(dispatcher.post(job));
+    }
+    
+    while (numReadLocks < numCoros) {
+        std::this_thread::sleep_for(ms(100));
+    }
+    {
+        Mutex::Guard guard(mutex);
+        locksAcquired=0;
+    }
+    cond.notifyAll();
+    
+    for (auto&& f : futures) {
+        f->wait();
+    }
+    
+    EXPECT_EQ(numCoros, locksAcquired);
+    EXPECT_FALSE(rwMutex.isLocked());
+}
+
+template <class MUTEX>
+void runReadWriteRatio(const std::string& name, MUTEX& rwMutex, int writePercent)
+{
+    using ns = std::chrono::nanoseconds;
+    const int numCoros = 200;
+    const int numOps = 200;
+    quantum::Dispatcher& dispatcher = DispatcherSingleton::instance({false, false});
+    std::vector<int> table(100, 0);
+    std::atomic_int numWrites{0};
+    std::atomic<int64_t> maxWriteWait{0};
+    
+    ProcStats startStats = getProcStats();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ThreadContextPtr<int>> futures;
+    futures.reserve(numCoros);
+    for (int c = 0; c < numCoros; ++c) {
+        futures.emplace_back(dispatcher.post([&, c](VoidContextPtr ctx) -> int {
+            for (int i = 0; i < numOps; ++i) {
+                if (((c * numOps + i) % 100) < writePercent) {
+                    auto requested = std::chrono::steady_clock::now();
+                    typename MUTEX::Guard guard(ctx, rwMutex, lock::acquireWrite);
+                    int64_t wait = std::chrono::duration_cast<ns>(std::chrono::steady_clock::now() - requested).count();
+                    for (int64_t max = maxWriteWait; (wait > max) && !maxWriteWait.compare_exchange_weak(max, wait););
+                    ++table[i % table.size()];
+                    ++numWrites;
+                }
+                else {
+                    typename MUTEX::Guard guard(ctx, rwMutex, lock::acquireRead);
+                    volatile int sum = 0;
+                    for (int v : table) {
+                        sum += v;
+                    }
+                }
+                if ((i % 10) == 0) {
+                    ctx->yield();
+                }
+            }
+            return 0;
+        }));
+    }
+    for (auto&& f : futures) {
+        f->wait();
+    }
+    auto end = std::chrono::steady_clock::now();
+    ProcStats procStats = getProcStats() - startStats;
+    int total = 0;
+    for (int v : table) {
+        total += v;
+    }
+    EXPECT_EQ(numWrites, total);
+    EXPECT_FALSE(rwMutex.isLocked());
+    //Results are saved in the test report (e.g. --gtest_output=xml)
+    std::string prefix = name + ".writes" + std::to_string(writePercent) + "pct.";
+    ::testing::Test::RecordProperty(prefix + "elapsedUs",
+        (int)std::chrono::duration_cast<us>(end-start).count());
+    ::testing::Test::RecordProperty(prefix + "cpuTicks",
+        (int)(procStats._kernelModeTime + procStats._userModeTime));
+    ::testing::Test::RecordProperty(prefix + "maxWriteWaitUs", (int)(maxWriteWait / 1000));
+}
+
+TEST(Locks, ParkingReadWriteMutex_ReadWriteRatios)
+{
+    for (int writePercent : {0, 1, 10, 50}) {
+        ReadWriteMutex spinning;
+        ParkingReadWriteMutex parking(true);
+        ParkingReadWriteMutex parkingReaders(false);
+        runReadWriteRatio("ReadWriteMutex", spinning, writePercent);
+        runReadWriteRatio("ParkingReadWriteMutex.preferWriters", parking, writePercent);
+        runReadWriteRatio("ParkingReadWriteMutex.preferReaders", parkingReaders, writePercent);
+    }
+}
+
+TEST(Locks, ParkingReadWriteMutex_NoWriterStarvation)
+{
+    //Readers overlap each other so that the lock is never free of readers
+    const int numReaders = 4;
+    ParkingReadWriteMutex mutex(true);
+    std::atomic_bool done{false};
+    std::atomic_int numReadLocks{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < numReaders; ++i) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                ParkingReadWriteMutex::Guard guard(mutex, lock::acquireRead);
+                ++numReadLocks;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        });
+    }
+    while (numReadLocks < numReaders) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto start = std::chrono::steady_clock::now();
+    {
+        ParkingReadWriteMutex::Guard guard(mutex, lock::acquireWrite);
+        EXPECT_TRUE(mutex.isWriteLocked());
+        EXPECT_EQ(0, mutex.numReaders());
+    }
+    auto wait = std::chrono::steady_clock::now() - start;
+    done = true;
+    for (auto&& reader : readers) {
+        reader.join();
+    }
+    //The writer only waits for the readers already holding the lock
+    EXPECT_LT(wait, std::chrono::milliseconds(500));
+    EXPECT_FALSE(mutex.isLocked());
+}
+
+TEST(Locks, ParkingReadWriteMutex_ThreadParksWithoutSpinning)
+{
+    auto threadCpuTime = []() -> std::chrono::nanoseconds {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    };
+    const std::chrono::milliseconds holdTime(200);
+    ParkingReadWriteMutex mutex;
+    std::atomic_bool isWaiting{false};
+    std::chrono::nanoseconds cpuTime{0};
+    mutex.lockWrite();
+    std::thread waiter([&]() {
+        auto cpuStart = threadCpuTime();
+        isWaiting = true;
+        mutex.lockWrite();
+        cpuTime = threadCpuTime() - cpuStart;
+        mutex.unlockWrite();
+    });
+    while (!isWaiting || (mutex.numPendingWriters() == 0)) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(holdTime);
+    mutex.unlockWrite();
+    waiter.join();
+    //A spinning or yielding thread would burn CPU for most of the hold time
+    EXPECT_LT(cpuTime, holdTime / 4);
+    EXPECT_FALSE(mutex.isLocked());
+}
+
+//==============================================================================
+//                           LOCK PROFILER TESTS
+//==============================================================================
+
+TEST(Locks, LockProfiler_Statistics)
+{
+    LockStatistics& stats = LockProfiler::instance().statistics("LocksTest::stats");
+    EXPECT_EQ(&stats, &LockProfiler::instance().statistics("LocksTest::stats"));
+    stats.reset();
+    stats.recordAcquisition(false, 0, 0, 0);
+    stats.recordAcquisition(true, 10, 2, 1);
+    stats.recordHoldTime(std::chrono::nanoseconds(1));
+    stats.recordHoldTime(std::chrono::nanoseconds(1000)); //bucket 9
+    stats.recordHoldTime(std::chrono::hours(1)); //last bucket
+    EXPECT_EQ(2, stats.numAcquisitions());
+    EXPECT_EQ(1, stats.numContendedAcquisitions());
+    EXPECT_EQ(10, stats.numSpins());
+    EXPECT_EQ(2, stats.numYields());
+    EXPECT_EQ(1, stats.numSleeps());
+    LockStatistics::HoldTimeHistogram histogram = stats.holdTimeHistogram();
+    EXPECT_EQ(1, histogram[0]);
+    EXPECT_EQ(1, histogram[9]);
+    EXPECT_EQ(1, histogram[LockStatistics::numHoldTimeBuckets-1]);
+    
+    std::ostringstream out;
+    LockProfiler::instance().dump(out);
+    EXPECT_NE(std::string::npos, out.str().find("LocksTest::stats"));
+    LockProfiler::instance().reset();
+    EXPECT_EQ(0, stats.numAcquisitions());
+}
+
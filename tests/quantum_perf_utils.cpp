@@ -21,6 +21,7 @@
 #include <fstream>
 #include <iostream>
 #include <unistd.h>
+#include <time.h>
 #endif // __linux__
 
 namespace Bloomberg {
@@ -59,6 +60,20 @@ ProcStats getProcStats()
 #endif // __linux__
 }
 
+std::chrono::nanoseconds getProcCpuTime()
+{
+#ifdef __linux__
+    timespec time;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#else
+    return std::chrono::nanoseconds::zero();
+#endif // __linux__
+}
+
 ProcStats operator- (const ProcStats& s1, const ProcStats& s2)
 {
     ProcStats s;
@@ -32,6 +32,9 @@ ProcStats operator-(const ProcStats& s1, const ProcStats& s2);
 
 ProcStats getProcStats();
 
+// CPU time used by all the threads of the process, with a finer resolution than getProcStats()
+std::chrono::nanoseconds getProcCpuTime();
+
 
 class Timer
 {
@@ -0,0 +1,254 @@
+/*
+** Copyright 2022 Bloomberg Finance L.P.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+//NOTE: This file is built into a separate optimized benchmark binary which is not run by ctest.
+#include <gtest/gtest.h>
+#include <quantum/quantum.h>
+#include <quantum_perf_utils.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef BLOOMBERG_QUANTUM_SEQUENCER_SUPPORT
+
+using namespace Bloomberg::quantum;
+using Clock = std::chrono::steady_clock;
+
+enum class KeyDistribution
+{
+    SingleKey,  ///< All the tasks share one key
+    Uniform,    ///< Keys are drawn uniformly
+    Zipf        ///< Key 'k' is drawn with a probability proportional to 1/(k+1)
+};
+
+struct BenchmarkScenario
+{
+    KeyDistribution             _distribution;
+    unsigned int                _keyCount;
+    unsigned int                _taskCount;
+    std::chrono::microseconds   _taskDuration;      // busy time of each task
+    unsigned int                _multiKeyTaskFreq;  // every Nth task has 3 keys, 0 for none
+    unsigned int                _universalTaskFreq; // every Nth task is enqueued with enqueueAll, 0 for none
+};
+
+struct BenchmarkResult
+{
+    double                      _throughput = 0;    // tasks per second
+    std::chrono::nanoseconds    _p50;               // enqueue to completion latencies
+    std::chrono::nanoseconds    _p99;
+    std::chrono::nanoseconds    _p999;
+    std::chrono::nanoseconds    _cpuPerTask;
+    size_t                      _postedTaskCount = 0;
+};
+
+const unsigned int defaultTaskCount = 20000;
+const unsigned int defaultKeyCount = 1000;
+
+Configuration makeDispatcherConfiguration()
+{
+    Configuration config;
+    config.setNumCoroutineThreads(4).setNumIoThreads(1);
+    return config;
+}
+
+std::string toString(const BenchmarkScenario& scenario)
+{
+    std::ostringstream name;
+    switch (scenario._distribution)
+    {
+        case KeyDistribution::SingleKey: name << "single key"; break;
+        case KeyDistribution::Uniform: name << "uniform(" << scenario._keyCount << ")"; break;
+        case KeyDistribution::Zipf: name << "zipf(" << scenario._keyCount << ")"; break;
+    }
+    name << " " << scenario._taskDuration.count() << "us";
+    if (scenario._multiKeyTaskFreq)
+    {
+        name << " multi/" << scenario._multiKeyTaskFreq;
+    }
+    if (scenario._universalTaskFreq)
+    {
+        name << " all/" << scenario._universalTaskFreq;
+    }
+    return name.str();
+}
+
+// The keys are drawn before the measurement starts
+std::vector<int> makeKeys(const BenchmarkScenario& scenario)
+{
+    std::mt19937 generator(scenario._taskCount);
+    std::vector<int> keys(scenario._taskCount, 0);
+    if (scenario._distribution == KeyDistribution::Uniform)
+    {
+        std::uniform_int_distribution<int> distribution(0, scenario._keyCount - 1);
+        std::generate(keys.begin(), keys.end(), [&]{ return distribution(generator); });
+    }
+    else if (scenario._distribution == KeyDistribution::Zipf)
+    {
+        std::vector<double> weights(scenario._keyCount);
+        for (size_t k = 0; k < weights.size(); ++k)
+        {
+            weights[k] = 1.0 / (k + 1);
+        }
+        std::discrete_distribution<int> distribution(weights.begin(), weights.end());
+        std::generate(keys.begin(), keys.end(), [&]{ return distribution(generator); });
+    }
+    return keys;
+}
+
+void spin(std::chrono::microseconds duration)
+{
+    Clock::time_point end = Clock::now() + duration;
+    while (Clock::now() < end);
+}
+
+// The tasks are enqueued in a single burst, so their latencies include the time spent queued behind earlier tasks
+template <class Sequencer>
+BenchmarkResult runBenchmark(Dispatcher& dispatcher,
+                             const BenchmarkScenario& scenario,
+                             const std::vector<int>& keys)
+{
+    Sequencer sequencer(dispatcher);
+    std::vector<Clock::time_point> enqueueTimes(scenario._taskCount);
+    // each task writes its own slot
+    std::vector<std::chrono::nanoseconds> latencies(scenario._taskCount);
+    std::chrono::microseconds taskDuration = scenario._taskDuration;
+
+    std::chrono::nanoseconds startCpuTime = getProcCpuTime();
+    Clock::time_point startTime = Clock::now();
+    for (unsigned int id = 0; id < scenario._taskCount; ++id)
+    {
+        auto task = [&enqueueTimes, &latencies, id, taskDuration](VoidContextPtr)->int
+        {
+            spin(taskDuration);
+            latencies[id] = Clock::now() - enqueueTimes[id];
+            return 0;
+        };
+        enqueueTimes[id] = Clock::now();
+        if (scenario._universalTaskFreq && (id % scenario._universalTaskFreq == 0))
+        {
+            sequencer.enqueueAll(std::move(task));
+        }
+        else if (scenario._multiKeyTaskFreq && (id % scenario._multiKeyTaskFreq == 0))
+        {
+            int key = keys[id];
+            sequencer.enqueue(std::vector<int>{key,
+                                               (key + 1) % (int)scenario._keyCount,
+                                               (key + 2) % (int)scenario._keyCount},
+                              std::move(task));
+        }
+        else
+        {
+            sequencer.enqueue(keys[id], std::move(task));
+        }
+    }
+    sequencer.drain();
+    Clock::duration elapsed = Clock::now() - startTime;
+    std::chrono::nanoseconds cpuTime = getProcCpuTime() - startCpuTime;
+
+    BenchmarkResult result;
+    result._throughput = scenario._taskCount / std::chrono::duration<double>(elapsed).count();
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double quantile)->std::chrono::nanoseconds
+    {
+        return latencies[std::min(latencies.size() - 1, (size_t)(quantile * latencies.size()))];
+    };
+    result._p50 = percentile(0.5);
+    result._p99 = percentile(0.99);
+    result._p999 = percentile(0.999);
+    result._cpuPerTask = cpuTime / scenario._taskCount;
+    result._postedTaskCount = sequencer.getTaskStatistics().getPostedTaskCount();
+    return result;
+}
+
+void printResult(const std::string& sequencerName,
+                 const BenchmarkScenario& scenario,
+                 const BenchmarkResult& result)
+{
+    auto us = [](std::chrono::nanoseconds time)->double
+    {
+        return std::chrono::duration<double, std::micro>(time).count();
+    };
+    std::cout << std::left << std::setw(24) << sequencerName
+              << std::setw(36) << toString(scenario) << std::right
+              << std::fixed << std::setprecision(0)
+              << std::setw(10) << result._throughput << " tasks/s"
+              << std::setprecision(1)
+              << "  p50 " << std::setw(9) << us(result._p50) << "us"
+              << "  p99 " << std::setw(9) << us(result._p99) << "us"
+              << "  p999 " << std::setw(9) << us(result._p999) << "us"
+              << "  CPU " << std::setw(7) << us(result._cpuPerTask) << "us/task"
+              << std::endl;
+}
+
+// Runs a scenario with both sequencer implementations on the same keys
+void runBenchmarks(const BenchmarkScenario& scenario)
+{
+    Dispatcher dispatcher(makeDispatcherConfiguration());
+    std::vector<int> keys = makeKeys(scenario);
+
+    BenchmarkResult result = runBenchmark<Sequencer<int>>(dispatcher, scenario, keys);
+    printResult("Sequencer", scenario, result);
+    //+1 for the drain
+    EXPECT_EQ(scenario._taskCount + 1, result._postedTaskCount);
+
+    result = runBenchmark<experimental::Sequencer<int>>(dispatcher, scenario, keys);
+    printResult("experimental::Sequencer", scenario, result);
+    EXPECT_EQ(scenario._taskCount + 1, result._postedTaskCount);
+}
+
+TEST(SequencerBenchmark, KeyDistributions)
+{
+    for (KeyDistribution distribution : {KeyDistribution::SingleKey, KeyDistribution::Uniform, KeyDistribution::Zipf})
+    {
+        for (std::chrono::microseconds taskDuration : {std::chrono::microseconds(0), std::chrono::microseconds(10)})
+        {
+            // a single key runs its tasks one at a time
+            bool isSingleKey = distribution == KeyDistribution::SingleKey;
+            runBenchmarks({distribution,
+                           isSingleKey ? 1 : defaultKeyCount,
+                           isSingleKey ? defaultTaskCount / 4 : defaultTaskCount,
+                           taskDuration,
+                           0,
+                           0});
+        }
+    }
+}
+
+TEST(SequencerBenchmark, MultiKeyAndUniversalTasks)
+{
+    const std::chrono::microseconds taskDuration(10);
+    runBenchmarks({KeyDistribution::Uniform, defaultKeyCount, defaultTaskCount, taskDuration, 0, 0});
+    runBenchmarks({KeyDistribution::Uniform, defaultKeyCount, defaultTaskCount, taskDuration, 10, 0});
+    runBenchmarks({KeyDistribution::Uniform, defaultKeyCount, defaultTaskCount, taskDuration, 0, 1000});
+    runBenchmarks({KeyDistribution::Uniform, defaultKeyCount, defaultTaskCount, taskDuration, 10, 100});
+    runBenchmarks({KeyDistribution::Zipf, defaultKeyCount, defaultTaskCount, taskDuration, 10, 100});
+}
+
+TEST(SequencerBenchmark, TaskDurations)
+{
+    for (int durationUs : {1, 10, 100, 1000})
+    {
+        // about 2 seconds of work per run
+        unsigned int taskCount = std::min(defaultTaskCount, 2000000u / durationUs);
+        runBenchmarks({KeyDistribution::Uniform, defaultKeyCount, taskCount, std::chrono::microseconds(durationUs), 0, 0});
+    }
+}
+
+#endif // BLOOMBERG_QUANTUM_SEQUENCER_SUPPORT
@@ -17,6 +17,7 @@
 #include <quantum_fixture.h>
 #include <quantum_sequencer_test_common.h>
 #include <gtest/gtest.h>
+#include <set>
 #include <sstream>
 
 #ifdef BLOOMBERG_QUANTUM_SEQUENCER_SUPPORT
@@ -310,6 +311,383 @@ TEST_P(SequencerExperimentalTest, TrimKeys)
     EXPECT_EQ(sequencer.getSequenceKeyCount(), 0u);
 }
 
+TEST_P(SequencerExperimentalTest, IdleKeyEviction)
+{
+    using namespace Bloomberg::quantum;
+
+    const int transientKeyCount = 100;
+    const int taskCount = 100;
+    const SequencerExperimentalTestData::SequenceKey hotKey = transientKeyCount;
+    const std::chrono::milliseconds idleKeyTimeout(200);
+    SequencerExperimentalTestData testData;
+
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(0, config.getIdleKeyTimeoutMs().count());
+    EXPECT_EQ(8u, config.getIdleKeyEvictionStepSize());
+    config.setIdleKeyTimeoutMs(idleKeyTimeout).setIdleKeyEvictionStepSize(0);
+    EXPECT_THROW(SequencerExperimentalTestData::TaskSequencer(getDispatcher(), config), std::invalid_argument);
+    // keys are only examined in the stripes of the completed tasks
+    config.setStripeCount(1);
+    config.setIdleKeyEvictionStepSize(4);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    // one task per transient key
+    for(SequencerExperimentalTestData::TaskId id = 0; id < transientKeyCount; ++id)
+    {
+        sequencer.enqueue(id, testData.makeTask(id));
+    }
+    sequencer.drain();
+    EXPECT_EQ((int)sequencer.getSequenceKeyCount(), transientKeyCount);
+    EXPECT_EQ(1u, sequencer.getStatistics(0).getPostedTaskCount());
+
+    // once idle for long enough, the transient keys are evicted a few at a time as new tasks are processed
+    std::this_thread::sleep_for(2 * idleKeyTimeout);
+    for(SequencerExperimentalTestData::TaskId id = transientKeyCount; id < transientKeyCount + taskCount; ++id)
+    {
+        sequencer.enqueue(hotKey, testData.makeTask(id));
+    }
+    // a pending universal task would keep all the keys busy, so wait for the tasks before draining
+    Promise<int> done;
+    sequencer.enqueue(hotKey, [&done](VoidContextPtr ctx)->int
+    {
+        return done.set(ctx, 0);
+    });
+    done.getIThreadFuture()->get();
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), transientKeyCount + taskCount);
+    EXPECT_EQ(1u, sequencer.getSequenceKeyCount());
+    EXPECT_EQ(0u, sequencer.getStatistics(0).getPostedTaskCount());
+    EXPECT_EQ((size_t)taskCount + 1, sequencer.getStatistics(hotKey).getPostedTaskCount());
+}
+
+TEST_P(SequencerExperimentalTest, LatencyStatistics)
+{
+    using namespace Bloomberg::quantum;
+
+    const int slowTaskCount = 3;
+    const int fastTaskCount = 10;
+    const SequencerExperimentalTestData::SequenceKey slowKey = 0;
+    const SequencerExperimentalTestData::SequenceKey fastKey = 1;
+    const std::chrono::milliseconds slowTaskDuration(10);
+    SequencerExperimentalTestData testData;
+
+    // latencies are not collected by default
+    SequencerExperimentalTestData::TaskSequencer defaultSequencer(getDispatcher());
+    defaultSequencer.enqueue(slowKey, testData.makeTask(0));
+    defaultSequencer.drain();
+    EXPECT_FALSE(defaultSequencer.getStatistics(slowKey).hasLatencyStatistics());
+    EXPECT_EQ(0u, defaultSequencer.getStatistics(slowKey).getCompletedTaskCount());
+    EXPECT_TRUE(defaultSequencer.getSlowestSequenceKeys(1).empty());
+
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_FALSE(config.getCollectLatencyStatistics());
+    config.setCollectLatencyStatistics(true);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+    for(int i = 0; i < slowTaskCount; ++i)
+    {
+        sequencer.enqueue(slowKey, [slowTaskDuration](VoidContextPtr ctx)->int
+        {
+            ctx->sleep(slowTaskDuration);
+            return 0;
+        });
+    }
+    for(int i = 0; i < fastTaskCount; ++i)
+    {
+        sequencer.enqueue(fastKey, [](VoidContextPtr)->int
+        {
+            return 0;
+        });
+    }
+    sequencer.drain();
+
+    SequenceKeyStatistics slowStats = sequencer.getStatistics(slowKey);
+    EXPECT_TRUE(slowStats.hasLatencyStatistics());
+    EXPECT_EQ((size_t)slowTaskCount, slowStats.getCompletedTaskCount());
+    EXPECT_LE(slowTaskCount * slowTaskDuration, slowStats.getTotalRunTime());
+    EXPECT_LE(slowTaskDuration, slowStats.getMaxRunTime());
+    // the tasks of the slow key queue behind each other
+    EXPECT_LE((slowTaskCount - 1) * slowTaskDuration, slowStats.getMaxWaitTime());
+    size_t numRunTimes = 0;
+    size_t numWaitTimes = 0;
+    for(size_t i = 0; i < SequenceKeyStatistics::numLatencyBuckets; ++i)
+    {
+        numRunTimes += slowStats.getRunTimeHistogram()[i];
+        numWaitTimes += slowStats.getWaitTimeHistogram()[i];
+    }
+    EXPECT_EQ((size_t)slowTaskCount, numRunTimes);
+    EXPECT_EQ((size_t)slowTaskCount, numWaitTimes);
+    // +1 for the drain
+    EXPECT_EQ((size_t)(slowTaskCount + fastTaskCount + 1), sequencer.getTaskStatistics().getCompletedTaskCount());
+    EXPECT_EQ(1u, sequencer.getStatistics().getCompletedTaskCount());
+
+    auto slowestKeys = sequencer.getSlowestSequenceKeys(1);
+    ASSERT_EQ(1u, slowestKeys.size());
+    EXPECT_EQ(slowKey, slowestKeys.front().first);
+    EXPECT_EQ(slowStats.getTotalRunTime(), slowestKeys.front().second.getTotalRunTime());
+    slowestKeys = sequencer.getSlowestSequenceKeys(10);
+    ASSERT_EQ(2u, slowestKeys.size());
+    EXPECT_EQ(fastKey, slowestKeys.back().first);
+    EXPECT_EQ((size_t)fastTaskCount, slowestKeys.back().second.getCompletedTaskCount());
+}
+
+TEST_P(SequencerExperimentalTest, PendingTaskLimit)
+{
+    using namespace Bloomberg::quantum;
+
+    const SequencerExperimentalTestData::SequenceKey sequenceKey = 0;
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(0u, config.getMaxPendingTasksPerKey());
+    EXPECT_EQ(SequencerPendingLimitPolicy::Reject, config.getPendingLimitPolicy());
+    config.setMaxPendingTasksPerKey(2);
+
+    for(SequencerPendingLimitPolicy policy : { SequencerPendingLimitPolicy::Reject,
+                                               SequencerPendingLimitPolicy::Coalesce,
+                                               SequencerPendingLimitPolicy::Block })
+    {
+        config.setPendingLimitPolicy(policy);
+        SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+        Promise<int> started;
+        Promise<int> release;
+        // tasks for the same key never run concurrently so no locking is needed
+        std::vector<int> order;
+        auto makeTask = [&order](int id)->std::function<int(VoidContextPtr)>
+        {
+            return [&order, id](VoidContextPtr)->int
+            {
+                order.push_back(id);
+                return 0;
+            };
+        };
+
+        // the first task holds the key so that the next ones stay pending
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, [&](VoidContextPtr ctx)->int
+        {
+            started.set(ctx, 0);
+            release.getICoroFuture()->wait(ctx);
+            order.push_back(0);
+            return 0;
+        }));
+        started.getIThreadFuture()->wait();
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(1)));
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(2)));
+        // tasks with several keys are not limited
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued,
+                  sequencer.enqueue(std::vector<SequencerExperimentalTestData::SequenceKey>{sequenceKey + 1},
+                                    [](VoidContextPtr)->int { return 0; }));
+
+        std::vector<int> expected;
+        if (policy == SequencerPendingLimitPolicy::Reject)
+        {
+            EXPECT_EQ(SequencerEnqueueStatus::Rejected, sequencer.enqueue(sequenceKey, makeTask(3)));
+            release.set(0);
+            expected = {0, 1, 2};
+        }
+        else if (policy == SequencerPendingLimitPolicy::Coalesce)
+        {
+            EXPECT_EQ(SequencerEnqueueStatus::Coalesced, sequencer.enqueue(sequenceKey, makeTask(3)));
+            EXPECT_EQ(SequencerEnqueueStatus::Coalesced, sequencer.enqueue(sequenceKey, makeTask(4)));
+            release.set(0);
+            expected = {0, 1, 4};
+        }
+        else
+        {
+            std::atomic_bool isEnqueued{false};
+            std::thread producer([&]()
+            {
+                EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(3)));
+                isEnqueued = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            EXPECT_FALSE(isEnqueued);
+            release.set(0);
+            producer.join();
+            expected = {0, 1, 2, 3};
+        }
+        sequencer.drain();
+        EXPECT_EQ(expected, order);
+    }
+}
+
+TEST_P(SequencerExperimentalTest, KeyAffinity)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 100;
+    const int sequenceKeyCount = 4;
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_FALSE(config.getKeyAffinity());
+    EXPECT_EQ(0u, config.getKeyAffinityRebalanceThreshold());
+    config.setKeyAffinity(true);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    // tasks for the same key never run concurrently so each key records its threads without locking
+    std::vector<std::set<std::thread::id>> threadIds(sequenceKeyCount);
+    for(int id = 0; id < taskCount; ++id)
+    {
+        SequencerExperimentalTestData::SequenceKey sequenceKey = id % sequenceKeyCount;
+        sequencer.enqueue(sequenceKey, [&threadIds, sequenceKey](VoidContextPtr ctx)->int
+        {
+            threadIds[sequenceKey].insert(std::this_thread::get_id());
+            ctx->yield();
+            return 0;
+        });
+    }
+    sequencer.drain();
+    for(const std::set<std::thread::id>& keyThreadIds : threadIds)
+    {
+        EXPECT_EQ(1u, keyThreadIds.size());
+    }
+
+    // a key is moved away from its queue once the queue is overloaded
+    config.setKeyAffinityRebalanceThreshold(1);
+    SequencerExperimentalTestData::TaskSequencer rebalancingSequencer(getDispatcher(), config);
+    const SequencerExperimentalTestData::SequenceKey sequenceKey = 0;
+    const std::pair<int, int>& range = getDispatcher().getCoroQueueIdRangeForAny();
+    int queueId = range.first + (int)(std::hash<SequencerExperimentalTestData::SequenceKey>()(sequenceKey) %
+                                      (size_t)(range.second - range.first + 1));
+    std::thread::id blockedThreadId = getDispatcher().post(queueId, false,
+        [](CoroContextPtr<std::thread::id> ctx)->int
+        {
+            return ctx->set(std::this_thread::get_id());
+        })->get();
+    Promise<int> release;
+    std::vector<ThreadContextPtr<int>> blockers;
+    for(int i = 0; i < 2; ++i)
+    {
+        blockers.push_back(getDispatcher().post(queueId, false, [&release](VoidContextPtr ctx)->int
+        {
+            release.getICoroFuture()->wait(ctx);
+            return 0;
+        }));
+    }
+    Promise<std::thread::id> taskThreadId;
+    rebalancingSequencer.enqueue(sequenceKey, [&taskThreadId](VoidContextPtr ctx)->int
+    {
+        return taskThreadId.set(ctx, std::this_thread::get_id());
+    });
+    std::thread::id rebalancedThreadId = taskThreadId.getIThreadFuture()->get();
+    release.set(0);
+    for(const ThreadContextPtr<int>& blocker : blockers)
+    {
+        blocker->get();
+    }
+    rebalancingSequencer.drain();
+    EXPECT_NE(blockedThreadId, rebalancedThreadId);
+}
+
+TEST_P(SequencerExperimentalTest, FairShareScheduling)
+{
+    using namespace Bloomberg::quantum;
+
+    const int noisyKeyCount = 10;
+    const int noisyTaskCount = 5;
+    const int quietKeyCount = 2;
+    const int quietTaskCount = 3;
+    const SequencerExperimentalTestData::SequenceKey quietKey = 100;
+    const SequencerExperimentalTestData::SequenceKey blockerKey = 1000;
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(0u, config.getFairShareMaxRunningTasks());
+    // the noisy keys share group 0 and the quiet keys share group 1, which gets twice as many tasks per round
+    config.setFairShareMaxRunningTasks(1)
+          .setFairShareGroupFunction([=](const SequencerExperimentalTestData::SequenceKey& key)->size_t
+          {
+              return key < quietKey ? 0 : key < blockerKey ? 1 : 2;
+          })
+          .setFairShareWeightFunction([](size_t group)->size_t
+          {
+              return group == 1 ? 2 : 1;
+          });
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    // the blocker takes the only slot until all the other tasks are ready
+    Promise<int> release;
+    sequencer.enqueue(blockerKey, [&release](VoidContextPtr ctx)->int
+    {
+        release.getICoroFuture()->wait(ctx);
+        return 0;
+    });
+    // a single task runs at a time so the groups are recorded without locking
+    std::vector<size_t> groups;
+    for(int i = 0; i < noisyTaskCount; ++i)
+    {
+        for(SequencerExperimentalTestData::SequenceKey key = 0; key < noisyKeyCount; ++key)
+        {
+            sequencer.enqueue(key, [&groups](VoidContextPtr)->int
+            {
+                groups.push_back(0);
+                return 0;
+            });
+        }
+    }
+    for(int i = 0; i < quietTaskCount; ++i)
+    {
+        for(SequencerExperimentalTestData::SequenceKey key = quietKey; key < quietKey + quietKeyCount; ++key)
+        {
+            sequencer.enqueue(key, [&groups](VoidContextPtr)->int
+            {
+                groups.push_back(1);
+                return 0;
+            });
+        }
+    }
+    release.set(0);
+    sequencer.drain();
+
+    // the quiet tasks do not wait for the ready noisy tasks
+    std::vector<size_t> expected{0, 1, 1, 0, 1, 1, 0, 1, 1};
+    expected.resize(noisyKeyCount * noisyTaskCount + quietKeyCount * quietTaskCount, 0);
+    EXPECT_EQ(expected, groups);
+}
+
+TEST_P(SequencerExperimentalTest, KeyDrain)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 10;
+    const SequencerExperimentalTestData::SequenceKey blockedKey = 0;
+    const SequencerExperimentalTestData::SequenceKey sequenceKey = 1;
+    const std::chrono::milliseconds timeout(10);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher());
+
+    Promise<int> release;
+    std::atomic_int blockedCount{0};
+    std::atomic_int count{0};
+    for(int id = 0; id < taskCount; ++id)
+    {
+        sequencer.enqueue(blockedKey, [&release, &blockedCount](VoidContextPtr ctx)->int
+        {
+            release.getICoroFuture()->wait(ctx);
+            ++blockedCount;
+            return 0;
+        });
+        sequencer.enqueue(sequenceKey, [&count](VoidContextPtr)->int
+        {
+            ++count;
+            return 0;
+        });
+    }
+
+    // a key drains while the other one is blocked, and tasks can still be enqueued
+    EXPECT_TRUE(sequencer.drain(sequenceKey));
+    EXPECT_EQ(taskCount, count);
+    EXPECT_TRUE(sequencer.drain(SequencerExperimentalTestData::SequenceKey(42), timeout));
+    EXPECT_FALSE(sequencer.drain(blockedKey, timeout));
+    EXPECT_FALSE(sequencer.drain(std::vector<SequencerExperimentalTestData::SequenceKey>{sequenceKey, blockedKey}, timeout));
+    EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, [&count](VoidContextPtr)->int
+    {
+        ++count;
+        return 0;
+    }));
+
+    release.set(0);
+    EXPECT_TRUE(sequencer.drain(std::vector<SequencerExperimentalTestData::SequenceKey>{sequenceKey, blockedKey}));
+    EXPECT_EQ(taskCount, blockedCount);
+    EXPECT_EQ(taskCount + 1, count);
+    EXPECT_EQ(0u, sequencer.getStatistics(blockedKey).getPendingTaskCount());
+    sequencer.drain();
+}
+
 TEST_P(SequencerExperimentalTest, ExceptionHandler)
 {
     using namespace Bloomberg::quantum;
@@ -670,6 +1048,34 @@ TEST_P(SequencerExperimentalTest, PerformanceTest)
         0);
 }
 
+TEST_P(SequencerExperimentalTest, ManyProducersPerformanceTest)
+{
+    using namespace Bloomberg::quantum;
+    const unsigned int producerCount = 8;
+    const unsigned int keyCountPerProducer = 128;
+    const unsigned int taskCount = 2000;
+
+    // a single stripe is equivalent to one mutex guarding all the keys
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    config.setStripeCount(1);
+    EXPECT_EQ(0u, testSequencerProducerPerformance<SequencerExperimentalTestData::TaskSequencer>(
+        "Many producers, single stripe",
+        getDispatcher(),
+        config,
+        producerCount,
+        keyCountPerProducer,
+        taskCount));
+
+    config.setStripeCount(16);
+    EXPECT_EQ(0u, testSequencerProducerPerformance<SequencerExperimentalTestData::TaskSequencer>(
+        "Many producers, 16 stripes",
+        getDispatcher(),
+        config,
+        producerCount,
+        keyCountPerProducer,
+        taskCount));
+}
+
 TEST_P(SequencerExperimentalTest, CoroSafety)
 {
     // This test demonstrates that it is safe to call the experimental::Sequencer from within a
@@ -740,4 +1146,124 @@ TEST_P(SequencerExperimentalTest, EnqueueAfterDrainThrows)
     EXPECT_THROW(sequencer.enqueueAll(testData.makeTask(id)), SequencerDrainingException);
 }
 
+TEST_P(SequencerExperimentalTest, StripeCount)
+{
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(16u, config.getStripeCount());
+    EXPECT_EQ(4u, config.setStripeCount(4).getStripeCount());
+
+    config.setStripeCount(0);
+    EXPECT_THROW(SequencerExperimentalTestData::TaskSequencer(getDispatcher(), config), std::invalid_argument);
+}
+
+TEST_P(SequencerExperimentalTest, SingleStripeTaskOrder)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 200;
+    const int sequenceKeyCount = 5;
+    const int universalTaskFrequency = 17;
+    SequencerExperimentalTestData testData;
+    SequencerExperimentalTestData::SequenceKeyMap sequenceKeys;
+    std::vector<SequencerExperimentalTestData::TaskId> universal;
+
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    config.setStripeCount(1);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    for(SequencerExperimentalTestData::TaskId id = 0; id < taskCount; ++id)
+    {
+        if (id % universalTaskFrequency == 0)
+        {
+            universal.push_back(id);
+            sequencer.enqueueAll(testData.makeTask(id));
+        }
+        else
+        {
+            SequencerExperimentalTestData::SequenceKey sequenceKey = id % sequenceKeyCount;
+            sequenceKeys[sequenceKey].push_back(id);
+            sequencer.enqueue(sequenceKey, testData.makeTask(id));
+        }
+    }
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), taskCount);
+    EXPECT_EQ((int)sequencer.getSequenceKeyCount(), sequenceKeyCount);
+    for(auto sequenceKeyData : sequenceKeys)
+    {
+        for(size_t i = 1; i < sequenceKeyData.second.size(); ++i)
+        {
+            testData.ensureOrder(sequenceKeyData.second[i-1], sequenceKeyData.second[i]);
+        }
+    }
+    for (auto universalTaskId : universal)
+    {
+        for(SequencerExperimentalTestData::TaskId taskId = 0; taskId < taskCount; ++taskId)
+        {
+            if (taskId < universalTaskId)
+            {
+                testData.ensureOrder(taskId, universalTaskId);
+            }
+            else if (taskId > universalTaskId)
+            {
+                testData.ensureOrder(universalTaskId, taskId);
+            }
+        }
+    }
+}
+
+TEST_P(SequencerExperimentalTest, MultiSequenceKeyTasksAcrossStripes)
+{
+    using namespace Bloomberg::quantum;
+
+    // each task uses two adjacent keys, which fall in different stripes
+    const int taskCount = 400;
+    const int sequenceKeyCount = 12;
+    const int universalTaskFrequency = 50;
+    SequencerExperimentalTestData testData;
+    std::vector<std::vector<SequencerExperimentalTestData::SequenceKey>> taskKeys(taskCount);
+
+    SequencerExperimentalTestData::TaskSequencerConfiguration config;
+    config.setStripeCount(4);
+    SequencerExperimentalTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    for(SequencerExperimentalTestData::TaskId id = 0; id < taskCount; ++id)
+    {
+        if (id and id % universalTaskFrequency == 0)
+        {
+            sequencer.enqueueAll(testData.makeTask(id));
+        }
+        else
+        {
+            taskKeys[id] = { id % sequenceKeyCount, (id + 1) % sequenceKeyCount };
+            sequencer.enqueue(taskKeys[id], testData.makeTask(id));
+        }
+    }
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), taskCount);
+    EXPECT_EQ((int)sequencer.getSequenceKeyCount(), sequenceKeyCount);
+    EXPECT_EQ(0u, sequencer.getTaskStatistics().getPendingTaskCount());
+
+    for(SequencerExperimentalTestData::TaskId id = 1; id < taskCount; ++id)
+    {
+        for(SequencerExperimentalTestData::TaskId refId = 0; refId < id; ++refId)
+        {
+            bool isUniversal = taskKeys[id].empty() or taskKeys[refId].empty();
+            bool sharesKey = false;
+            for(auto key : taskKeys[id])
+            {
+                for(auto refKey : taskKeys[refId])
+                {
+                    sharesKey = sharesKey or (key == refKey);
+                }
+            }
+            if (isUniversal or sharesKey)
+            {
+                testData.ensureOrder(refId, id);
+            }
+        }
+    }
+}
+
 #endif // BLOOMBERG_QUANTUM_SEQUENCER_SUPPORT
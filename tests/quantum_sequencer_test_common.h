@@ -20,6 +20,8 @@
 #include <chrono>
 #include <iostream>
 #include <atomic>
+#include <thread>
+#include <vector>
 
 namespace Bloomberg {
 namespace quantum {
@@ -94,6 +96,61 @@ void testSequencerPerformance(
               << std::endl;
 }
 
+// Enqueues trivial tasks from several producer threads at once, each producer using its own set of keys.
+// Returns the number of tasks which ran out of order within their key.
+template<typename Sequencer>
+size_t testSequencerProducerPerformance(
+    const std::string& name,
+    quantum::Dispatcher& dispatcher,
+    const typename Sequencer::Configuration& configuration,
+    unsigned int producerCount,
+    unsigned int keyCountPerProducer,
+    unsigned int taskCountPerProducer)
+{
+    Sequencer sequencer(dispatcher, configuration);
+    std::vector<unsigned int> lastRun(producerCount * keyCountPerProducer, 0);
+    std::atomic<size_t> outOfOrderCount{0};
+
+    ProcStats startStats = getProcStats();
+    {
+        Timer timer;
+        std::vector<std::thread> producers;
+        for(unsigned int producer = 0; producer < producerCount; ++producer)
+        {
+            producers.emplace_back([&, producer]()
+            {
+                for(unsigned int id = 0; id < taskCountPerProducer; ++id)
+                {
+                    int key = producer * keyCountPerProducer + id % keyCountPerProducer;
+                    unsigned int rank = id / keyCountPerProducer + 1;
+                    sequencer.enqueue(key, [&lastRun, &outOfOrderCount, key, rank](VoidContextPtr)->int
+                    {
+                        // tasks sharing a key never run concurrently
+                        if (lastRun[key] + 1 != rank)
+                        {
+                            ++outOfOrderCount;
+                        }
+                        lastRun[key] = rank;
+                        return 0;
+                    });
+                }
+            });
+        }
+        for(auto& producer : producers)
+        {
+            producer.join();
+        }
+        sequencer.drain();
+    }
+    ProcStats procStats = getProcStats() - startStats;
+
+    std::cout << name << ": elapsed "
+              << Timer::elapsed<std::chrono::milliseconds>() << " ms, "
+              << procStats._kernelModeTime + procStats._userModeTime << " CPU ticks"
+              << std::endl;
+    return outOfOrderCount;
+}
+
 }}
 
 #endif // BLOOMBERG_QUANTUM_SEQUENCER_TEST_COMMON_H
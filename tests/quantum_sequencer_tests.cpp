@@ -16,6 +16,7 @@
 #include <quantum_fixture.h>
 #include <quantum_sequencer_test_common.h>
 #include <gtest/gtest.h>
+#include <set>
 
 using namespace quantum;
 
@@ -183,6 +184,316 @@ TEST_P(SequencerTest, TrimKeys)
     EXPECT_EQ(sequencer.getSequenceKeyCount(), 0u);
 }
 
+TEST_P(SequencerTest, IdleKeyEviction)
+{
+    using namespace Bloomberg::quantum;
+
+    const int transientKeyCount = 100;
+    const int taskCount = 100;
+    const SequencerTestData::SequenceKey hotKey = transientKeyCount;
+    const std::chrono::milliseconds idleKeyTimeout(200);
+    SequencerTestData testData;
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(0, config.getIdleKeyTimeoutMs().count());
+    EXPECT_EQ(8u, config.getIdleKeyEvictionStepSize());
+    config.setIdleKeyTimeoutMs(idleKeyTimeout).setIdleKeyEvictionStepSize(0);
+    EXPECT_THROW(SequencerTestData::TaskSequencer(getDispatcher(), config), std::invalid_argument);
+    config.setIdleKeyEvictionStepSize(4);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    // one task per transient key
+    for(SequencerTestData::TaskId id = 0; id < transientKeyCount; ++id)
+    {
+        sequencer.enqueue(id, testData.makeTask(id));
+    }
+    sequencer.drain();
+    EXPECT_EQ((int)sequencer.getSequenceKeyCount(), transientKeyCount);
+    EXPECT_EQ(1u, sequencer.getStatistics(0).getPostedTaskCount());
+
+    // once idle for long enough, the transient keys are evicted a few at a time as new tasks are processed
+    std::this_thread::sleep_for(2 * idleKeyTimeout);
+    for(SequencerTestData::TaskId id = transientKeyCount; id < transientKeyCount + taskCount; ++id)
+    {
+        sequencer.enqueue(hotKey, testData.makeTask(id));
+    }
+    Promise<int> done;
+    sequencer.enqueue(hotKey, [&done](VoidContextPtr ctx)->int
+    {
+        return done.set(ctx, 0);
+    });
+    done.getIThreadFuture()->get();
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), transientKeyCount + taskCount);
+    // the idle time runs from the last enqueue, so the hot key may be evicted as soon as its last task completes
+    EXPECT_GE(1u, sequencer.getSequenceKeyCount());
+    EXPECT_EQ(0u, sequencer.getStatistics(0).getPostedTaskCount());
+}
+
+TEST_P(SequencerTest, LatencyStatistics)
+{
+    using namespace Bloomberg::quantum;
+
+    const int slowTaskCount = 3;
+    const int fastTaskCount = 10;
+    const SequencerTestData::SequenceKey slowKey = 0;
+    const SequencerTestData::SequenceKey fastKey = 1;
+    const std::chrono::milliseconds slowTaskDuration(10);
+    SequencerTestData testData;
+
+    // latencies are not collected by default
+    SequencerTestData::TaskSequencer defaultSequencer(getDispatcher());
+    defaultSequencer.enqueue(slowKey, testData.makeTask(0));
+    defaultSequencer.drain();
+    EXPECT_FALSE(defaultSequencer.getStatistics(slowKey).hasLatencyStatistics());
+    EXPECT_EQ(0u, defaultSequencer.getStatistics(slowKey).getCompletedTaskCount());
+    EXPECT_TRUE(defaultSequencer.getSlowestSequenceKeys(1).empty());
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    EXPECT_FALSE(config.getCollectLatencyStatistics());
+    config.setCollectLatencyStatistics(true);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+    for(int i = 0; i < slowTaskCount; ++i)
+    {
+        sequencer.enqueue(slowKey, [slowTaskDuration](VoidContextPtr ctx)->int
+        {
+            ctx->sleep(slowTaskDuration);
+            return 0;
+        });
+    }
+    for(int i = 0; i < fastTaskCount; ++i)
+    {
+        sequencer.enqueue(fastKey, [](VoidContextPtr)->int
+        {
+            return 0;
+        });
+    }
+    sequencer.drain();
+
+    SequenceKeyStatistics slowStats = sequencer.getStatistics(slowKey);
+    EXPECT_TRUE(slowStats.hasLatencyStatistics());
+    EXPECT_EQ((size_t)slowTaskCount, slowStats.getCompletedTaskCount());
+    EXPECT_LE(slowTaskCount * slowTaskDuration, slowStats.getTotalRunTime());
+    EXPECT_LE(slowTaskDuration, slowStats.getMaxRunTime());
+    // the tasks of the slow key queue behind each other
+    EXPECT_LE((slowTaskCount - 1) * slowTaskDuration, slowStats.getMaxWaitTime());
+    size_t numRunTimes = 0;
+    size_t numWaitTimes = 0;
+    for(size_t i = 0; i < SequenceKeyStatistics::numLatencyBuckets; ++i)
+    {
+        numRunTimes += slowStats.getRunTimeHistogram()[i];
+        numWaitTimes += slowStats.getWaitTimeHistogram()[i];
+    }
+    EXPECT_EQ((size_t)slowTaskCount, numRunTimes);
+    EXPECT_EQ((size_t)slowTaskCount, numWaitTimes);
+    // +1 for the drain
+    EXPECT_EQ((size_t)(slowTaskCount + fastTaskCount + 1), sequencer.getTaskStatistics().getCompletedTaskCount());
+    EXPECT_EQ(1u, sequencer.getStatistics().getCompletedTaskCount());
+
+    auto slowestKeys = sequencer.getSlowestSequenceKeys(1);
+    ASSERT_EQ(1u, slowestKeys.size());
+    EXPECT_EQ(slowKey, slowestKeys.front().first);
+    EXPECT_EQ(slowStats.getTotalRunTime(), slowestKeys.front().second.getTotalRunTime());
+    slowestKeys = sequencer.getSlowestSequenceKeys(10);
+    ASSERT_EQ(2u, slowestKeys.size());
+    EXPECT_EQ(fastKey, slowestKeys.back().first);
+    EXPECT_EQ((size_t)fastTaskCount, slowestKeys.back().second.getCompletedTaskCount());
+}
+
+TEST_P(SequencerTest, PendingTaskLimit)
+{
+    using namespace Bloomberg::quantum;
+
+    const SequencerTestData::SequenceKey sequenceKey = 0;
+    SequencerTestData::TaskSequencerConfiguration config;
+    EXPECT_EQ(0u, config.getMaxPendingTasksPerKey());
+    EXPECT_EQ(SequencerPendingLimitPolicy::Reject, config.getPendingLimitPolicy());
+    config.setMaxPendingTasksPerKey(2);
+
+    for(SequencerPendingLimitPolicy policy : { SequencerPendingLimitPolicy::Reject,
+                                               SequencerPendingLimitPolicy::Coalesce,
+                                               SequencerPendingLimitPolicy::Block })
+    {
+        config.setPendingLimitPolicy(policy);
+        SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+        Promise<int> started;
+        Promise<int> release;
+        // tasks for the same key never run concurrently so no locking is needed
+        std::vector<int> order;
+        auto makeTask = [&order](int id)->std::function<int(VoidContextPtr)>
+        {
+            return [&order, id](VoidContextPtr)->int
+            {
+                order.push_back(id);
+                return 0;
+            };
+        };
+
+        // the first task holds the key so that the next ones stay pending
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, [&](VoidContextPtr ctx)->int
+        {
+            started.set(ctx, 0);
+            release.getICoroFuture()->wait(ctx);
+            order.push_back(0);
+            return 0;
+        }));
+        started.getIThreadFuture()->wait();
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(1)));
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(2)));
+        // tasks with several keys are not limited
+        EXPECT_EQ(SequencerEnqueueStatus::Enqueued,
+                  sequencer.enqueue(std::vector<SequencerTestData::SequenceKey>{sequenceKey + 1},
+                                    [](VoidContextPtr)->int { return 0; }));
+
+        std::vector<int> expected;
+        if (policy == SequencerPendingLimitPolicy::Reject)
+        {
+            EXPECT_EQ(SequencerEnqueueStatus::Rejected, sequencer.enqueue(sequenceKey, makeTask(3)));
+            release.set(0);
+            expected = {0, 1, 2};
+        }
+        else if (policy == SequencerPendingLimitPolicy::Coalesce)
+        {
+            EXPECT_EQ(SequencerEnqueueStatus::Coalesced, sequencer.enqueue(sequenceKey, makeTask(3)));
+            EXPECT_EQ(SequencerEnqueueStatus::Coalesced, sequencer.enqueue(sequenceKey, makeTask(4)));
+            release.set(0);
+            expected = {0, 1, 4};
+        }
+        else
+        {
+            std::atomic_bool isEnqueued{false};
+            std::thread producer([&]()
+            {
+                EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, makeTask(3)));
+                isEnqueued = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            EXPECT_FALSE(isEnqueued);
+            release.set(0);
+            producer.join();
+            expected = {0, 1, 2, 3};
+        }
+        sequencer.drain();
+        EXPECT_EQ(expected, order);
+    }
+}
+
+TEST_P(SequencerTest, KeyAffinity)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 100;
+    const int sequenceKeyCount = 4;
+    SequencerTestData::TaskSequencerConfiguration config;
+    EXPECT_FALSE(config.getKeyAffinity());
+    EXPECT_EQ(0u, config.getKeyAffinityRebalanceThreshold());
+    config.setKeyAffinity(true);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    // tasks for the same key never run concurrently so each key records its threads without locking
+    std::vector<std::set<std::thread::id>> threadIds(sequenceKeyCount);
+    for(int id = 0; id < taskCount; ++id)
+    {
+        SequencerTestData::SequenceKey sequenceKey = id % sequenceKeyCount;
+        sequencer.enqueue(sequenceKey, [&threadIds, sequenceKey](VoidContextPtr ctx)->int
+        {
+            threadIds[sequenceKey].insert(std::this_thread::get_id());
+            ctx->yield();
+            return 0;
+        });
+    }
+    sequencer.drain();
+    for(const std::set<std::thread::id>& keyThreadIds : threadIds)
+    {
+        EXPECT_EQ(1u, keyThreadIds.size());
+    }
+
+    // a key is moved away from its queue once the queue is overloaded
+    config.setKeyAffinityRebalanceThreshold(1);
+    SequencerTestData::TaskSequencer rebalancingSequencer(getDispatcher(), config);
+    const SequencerTestData::SequenceKey sequenceKey = 0;
+    const std::pair<int, int>& range = getDispatcher().getCoroQueueIdRangeForAny();
+    int queueId = range.first + (int)(std::hash<SequencerTestData::SequenceKey>()(sequenceKey) %
+                                      (size_t)(range.second - range.first + 1));
+    std::thread::id blockedThreadId = getDispatcher().post(queueId, false,
+        [](CoroContextPtr<std::thread::id> ctx)->int
+        {
+            return ctx->set(std::this_thread::get_id());
+        })->get();
+    Promise<int> release;
+    std::vector<ThreadContextPtr<int>> blockers;
+    for(int i = 0; i < 2; ++i)
+    {
+        blockers.push_back(getDispatcher().post(queueId, false, [&release](VoidContextPtr ctx)->int
+        {
+            release.getICoroFuture()->wait(ctx);
+            return 0;
+        }));
+    }
+    Promise<std::thread::id> taskThreadId;
+    rebalancingSequencer.enqueue(sequenceKey, [&taskThreadId](VoidContextPtr ctx)->int
+    {
+        return taskThreadId.set(ctx, std::this_thread::get_id());
+    });
+    std::thread::id rebalancedThreadId = taskThreadId.getIThreadFuture()->get();
+    release.set(0);
+    for(const ThreadContextPtr<int>& blocker : blockers)
+    {
+        blocker->get();
+    }
+    rebalancingSequencer.drain();
+    EXPECT_NE(blockedThreadId, rebalancedThreadId);
+}
+
+TEST_P(SequencerTest, KeyDrain)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 10;
+    const SequencerTestData::SequenceKey blockedKey = 0;
+    const SequencerTestData::SequenceKey sequenceKey = 1;
+    const std::chrono::milliseconds timeout(10);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher());
+
+    Promise<int> release;
+    std::atomic_int blockedCount{0};
+    std::atomic_int count{0};
+    for(int id = 0; id < taskCount; ++id)
+    {
+        sequencer.enqueue(blockedKey, [&release, &blockedCount](VoidContextPtr ctx)->int
+        {
+            release.getICoroFuture()->wait(ctx);
+            ++blockedCount;
+            return 0;
+        });
+        sequencer.enqueue(sequenceKey, [&count](VoidContextPtr)->int
+        {
+            ++count;
+            return 0;
+        });
+    }
+
+    // a key drains while the other one is blocked, and tasks can still be enqueued
+    EXPECT_TRUE(sequencer.drain(sequenceKey));
+    EXPECT_EQ(taskCount, count);
+    EXPECT_TRUE(sequencer.drain(SequencerTestData::SequenceKey(42), timeout));
+    EXPECT_FALSE(sequencer.drain(blockedKey, timeout));
+    EXPECT_FALSE(sequencer.drain(std::vector<SequencerTestData::SequenceKey>{sequenceKey, blockedKey}, timeout));
+    EXPECT_EQ(SequencerEnqueueStatus::Enqueued, sequencer.enqueue(sequenceKey, [&count](VoidContextPtr)->int
+    {
+        ++count;
+        return 0;
+    }));
+
+    release.set(0);
+    EXPECT_TRUE(sequencer.drain(std::vector<SequencerTestData::SequenceKey>{sequenceKey, blockedKey}));
+    EXPECT_EQ(taskCount, blockedCount);
+    EXPECT_EQ(taskCount + 1, count);
+    EXPECT_EQ(0u, sequencer.getStatistics(blockedKey).getPendingTaskCount());
+    sequencer.drain();
+}
+
 TEST_P(SequencerTest, ExceptionHandler)
 {
     using namespace Bloomberg::quantum;
@@ -464,6 +775,266 @@ TEST_P(SequencerTest, MultiSequenceKeyTasks)
     }
 }
 
+TEST_P(SequencerTest, ShardedControlQueues)
+{
+    using namespace Bloomberg::quantum;
+
+    const int sequenceKeyCount = 5;
+    const int taskCount = (2 << (sequenceKeyCount - 1)) - 1;
+    const int universalTaskFrequency = 7; // every 7th task is universal
+    SequencerTestData testData;
+    std::vector<std::vector<SequencerTestData::SequenceKey>> taskKeys(taskCount + 1);
+
+    // constructs a sequence key collection from the bitmap of the task id
+    auto getBitVector = [](unsigned int value)->std::vector<SequencerTestData::SequenceKey>
+    {
+        std::vector<SequencerTestData::SequenceKey> result;
+        for(int bit = 0; value; ++bit, value = value >> 1)
+        {
+            if ( value % 2 )
+            {
+                result.push_back(bit);
+            }
+        }
+        return result;
+    };
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setControlQueueId(1).setNumControlQueues(3);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+    for(SequencerTestData::TaskId id = 1; id <= taskCount; ++id)
+    {
+        if ( id % universalTaskFrequency == 0 )
+        {
+            sequencer.enqueueAll(testData.makeTask(id));
+        }
+        else
+        {
+            // single key tasks are scheduled by one partition only while the others span several
+            taskKeys[id] = getBitVector(id);
+            sequencer.enqueue(taskKeys[id], testData.makeTask(id));
+        }
+    }
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), taskCount);
+    EXPECT_EQ((int)sequencer.getSequenceKeyCount(), sequenceKeyCount);
+    EXPECT_EQ((int)sequencer.getTaskStatistics().getPostedTaskCount(), taskCount + 1); //+1 for the drain
+    EXPECT_EQ((int)sequencer.getTaskStatistics().getPendingTaskCount(), 0);
+    EXPECT_EQ((int)sequencer.getStatistics().getPostedTaskCount(), taskCount / universalTaskFrequency + 1);
+    EXPECT_EQ((int)sequencer.getStatistics(0).getPendingTaskCount(), 0);
+
+    for(SequencerTestData::TaskId id = 1; id <= taskCount; ++id)
+    {
+        for(SequencerTestData::TaskId refId = id + 1; refId <= taskCount; ++refId)
+        {
+            bool isUniversal = (id % universalTaskFrequency == 0) || (refId % universalTaskFrequency == 0);
+            if ( isUniversal or (id & refId) )
+            {
+                testData.ensureOrder(id, refId);
+            }
+        }
+    }
+    EXPECT_EQ((int)sequencer.trimSequenceKeys(), 0);
+}
+
+TEST_P(SequencerTest, ShardedControlQueuesInvalidRange)
+{
+    using namespace Bloomberg::quantum;
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setControlQueueId(1).setNumControlQueues(getDispatcher().getNumCoroutineThreads());
+    EXPECT_THROW(SequencerTestData::TaskSequencer(getDispatcher(), config), std::out_of_range);
+    config.setNumControlQueues(0);
+    EXPECT_THROW(SequencerTestData::TaskSequencer(getDispatcher(), config), std::out_of_range);
+}
+
+TEST_P(SequencerTest, ShardedControlQueuesPerformanceTest)
+{
+    using namespace Bloomberg::quantum;
+    const unsigned int producerCount = 8;
+    const unsigned int keyCountPerProducer = 128;
+    const unsigned int taskCount = 2000;
+    const size_t controlQueueCount = std::min(4, getDispatcher().getNumCoroutineThreads());
+
+    // a single control queue schedules every task of the sequencer
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setNumControlQueues(1);
+    EXPECT_EQ(0u, testSequencerProducerPerformance<SequencerTestData::TaskSequencer>(
+        "Many producers, 1 control queue",
+        getDispatcher(),
+        config,
+        producerCount,
+        keyCountPerProducer,
+        taskCount));
+
+    config.setNumControlQueues(controlQueueCount);
+    EXPECT_EQ(0u, testSequencerProducerPerformance<SequencerTestData::TaskSequencer>(
+        "Many producers, " + std::to_string(controlQueueCount) + " control queues",
+        getDispatcher(),
+        config,
+        producerCount,
+        keyCountPerProducer,
+        taskCount));
+}
+
+TEST_P(SequencerTest, TaskBatching)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 100;
+    const int sequenceKeyCount = 3;
+    const int universalTaskFrequency = 23; // every 23rd task is universal
+    const int multiKeyTaskFrequency = 17; // every 17th task uses all the keys
+    const size_t taskBatchSize = 8;
+    SequencerTestData testData;
+    SequencerTestData::SequenceKeyMap sequenceKeys;
+    std::vector<SequencerTestData::SequenceKey> allKeys;
+    for (SequencerTestData::SequenceKey sequenceKey = 0; sequenceKey < sequenceKeyCount; ++sequenceKey)
+    {
+        allKeys.push_back(sequenceKey);
+    }
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setTaskBatchSize(taskBatchSize).setTaskBatchTimeSliceMs(std::chrono::milliseconds(20));
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    for(SequencerTestData::TaskId id = 0; id < taskCount; ++id)
+    {
+        if ( id % universalTaskFrequency == 0 )
+        {
+            sequencer.enqueueAll(testData.makeTask(id));
+            for (auto&& keyTasks : sequenceKeys)
+            {
+                keyTasks.second.push_back(id);
+            }
+        }
+        else if ( id % multiKeyTaskFrequency == 0 )
+        {
+            sequencer.enqueue(allKeys, testData.makeTask(id));
+            for (SequencerTestData::SequenceKey sequenceKey : allKeys)
+            {
+                sequenceKeys[sequenceKey].push_back(id);
+            }
+        }
+        else
+        {
+            SequencerTestData::SequenceKey sequenceKey = id % sequenceKeyCount;
+            sequenceKeys[sequenceKey].push_back(id);
+            sequencer.enqueue(sequenceKey, testData.makeTask(id));
+        }
+    }
+    sequencer.drain();
+
+    EXPECT_EQ((int)testData.results().size(), taskCount);
+    EXPECT_EQ((int)sequencer.getTaskStatistics().getPostedTaskCount(), taskCount + 1); //+1 for the drain
+    EXPECT_EQ((int)sequencer.getTaskStatistics().getPendingTaskCount(), 0);
+    for (SequencerTestData::SequenceKey sequenceKey : allKeys)
+    {
+        EXPECT_EQ((int)sequencer.getStatistics(sequenceKey).getPendingTaskCount(), 0);
+    }
+    for(auto sequenceKeyData : sequenceKeys)
+    {
+        for(size_t i = 1; i < sequenceKeyData.second.size(); ++i)
+        {
+            testData.ensureOrder(sequenceKeyData.second[i-1], sequenceKeyData.second[i]);
+        }
+    }
+}
+
+TEST_P(SequencerTest, TaskBatchingSharesCoroutines)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 100;
+    const size_t taskBatchSize = 8;
+    const SequencerTestData::SequenceKey sequenceKey = 0;
+    Promise<int> release;
+    std::vector<int> order;
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setTaskBatchSize(taskBatchSize);
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    for(int id = 0; id < taskCount; ++id)
+    {
+        // tasks for the same key never run concurrently so no locking is needed
+        sequencer.enqueue(sequenceKey, [&, id](VoidContextPtr ctx)->int
+        {
+            if (id == 0)
+            {
+                // hold the first batch open until all the tasks are scheduled
+                release.getICoroFuture()->wait(ctx);
+            }
+            order.push_back(id);
+            return 0;
+        });
+    }
+    while (sequencer.getStatistics(sequenceKey).getPostedTaskCount() < (size_t)taskCount)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    release.set(0);
+    sequencer.drain();
+
+    ASSERT_EQ((int)order.size(), taskCount);
+    for(int id = 0; id < taskCount; ++id)
+    {
+        EXPECT_EQ(order[id], id);
+    }
+    EXPECT_EQ(sequencer.getTaskBatchCount(), (taskCount + taskBatchSize - 1) / taskBatchSize);
+    EXPECT_EQ(sequencer.getStatistics(sequenceKey).getPendingTaskCount(), 0u);
+}
+
+TEST_P(SequencerTest, TaskBatchingYieldsAfterTimeSlice)
+{
+    using namespace Bloomberg::quantum;
+
+    const int taskCount = 10;
+    const int queueId = 2;
+    const SequencerTestData::SequenceKey sequenceKey = 0;
+    Promise<int> release;
+    std::atomic_int numCompleted{0};
+    std::atomic_int numCompletedBeforeOther{-1};
+
+    SequencerTestData::TaskSequencerConfiguration config;
+    config.setTaskBatchSize(taskCount).setTaskBatchTimeSliceMs(std::chrono::milliseconds(5));
+    SequencerTestData::TaskSequencer sequencer(getDispatcher(), config);
+
+    for(int id = 0; id < taskCount; ++id)
+    {
+        sequencer.enqueue(nullptr, queueId, false, sequenceKey, [&, id](VoidContextPtr ctx)->int
+        {
+            if (id == 0)
+            {
+                // the first task outlasts the time slice and queues another coroutine behind the batch
+                release.getICoroFuture()->wait(ctx);
+                ctx->post(queueId, false, [&](VoidContextPtr)->int
+                {
+                    numCompletedBeforeOther = numCompleted.load();
+                    return 0;
+                });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // blocks the queue
+            ++numCompleted;
+            return 0;
+        });
+    }
+    while (sequencer.getStatistics(sequenceKey).getPostedTaskCount() < (size_t)taskCount)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release.set(0);
+    sequencer.drain();
+
+    EXPECT_EQ(numCompleted, taskCount);
+    EXPECT_EQ(sequencer.getTaskBatchCount(), 1u);
+    // the batch yielded before its second task instead of running all of them back-to-back
+    EXPECT_GE(numCompletedBeforeOther, 1);
+    EXPECT_LT(numCompletedBeforeOther, taskCount);
+}
+
 TEST_P(SequencerTest, CustomHashFunction)
 {
     using namespace Bloomberg::quantum;
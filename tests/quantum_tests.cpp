@@ -24,6 +24,9 @@
 #include <list>
 #include <memory>
 #include <functional>
+#include <numeric>
+#include <algorithm>
+#include <random>
 
 
 
@@ -536,6 +539,16 @@ TEST_P(ParamtersTest, CheckParameterPassingInCoroutines)
     EXPECT_DOUBLE_EQ(6.543, dbl);
 }
 
+TEST_P(ParamtersTest, CheckSmallCapturesAreMoved)
+{
+    //The capture fits in the inline storage of the task function and must be moved, not copied
+    //byte-wise, since short strings point to their own internal buffer.
+    auto func = [](VoidContextPtr, std::string byVal)->std::string {
+        return byVal;
+    };
+    EXPECT_EQ("short", getDispatcher().post2(func, std::string("short"))->get());
+}
+
 TEST_P(ExecutionTest, DrainAllTasks)
 {
     //Turn the drain on and make sure we cannot queue any tasks
@@ -1353,6 +1366,256 @@ TEST_P(ForEachTest, LargeBatchFromCoroutine)
     })->get();
 }
 
+TEST_P(ForEachTest, ParallelFor)
+{
+    std::vector<int> values(1000000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = (int)i;
+    }
+    getDispatcher().parallelFor(values.begin(), values.end(),
+        [](const VoidContextPtr&, int& val) {
+        val *= 2;
+    })->get();
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ((int)i*2, values[i]);
+    }
+}
+
+TEST_P(ForEachTest, ParallelForSkewedCost)
+{
+    //all the expensive elements are at the front so they start in the same worker's share
+    std::vector<int> visits(10000, 0);
+    getDispatcher().parallelFor(visits.begin(), visits.end(),
+        [&visits](const VoidContextPtr&, int& visit) {
+        if (&visit - visits.data() < 100) {
+            std::this_thread::sleep_for(us(500));
+        }
+        ++visit;
+    })->get();
+
+    for (int visit : visits) {
+        ASSERT_EQ(1, visit);
+    }
+}
+
+TEST_P(ForEachTest, ParallelForFromCoroutine)
+{
+    std::vector<int> values(batchNum, 1);
+    getDispatcher().post([&values](CoroContext<int>::Ptr ctx)->int {
+        //fixed grain size and a function which yields
+        ctx->parallelFor(values.begin(), values.end(),
+            [](VoidContextPtr ctx, int& val) {
+            ctx->yield();
+            val += 1;
+        }, 3)->get(ctx);
+        return ctx->set(0);
+    })->get();
+
+    EXPECT_EQ(std::vector<int>(batchNum, 2), values);
+}
+
+TEST_P(ForEachTest, ParallelForEmptyRange)
+{
+    std::vector<int> values;
+    EXPECT_EQ(0, getDispatcher().parallelFor(values.begin(), values.end(),
+        [](const VoidContextPtr&, int&) {
+        FAIL();
+    })->get());
+}
+
+TEST_P(ForEachTest, ParallelForException)
+{
+    std::vector<int> values(10000, 0);
+    std::atomic_int numVisited{0};
+    EXPECT_THROW(getDispatcher().parallelFor(values.begin(), values.end(),
+        [&numVisited](const VoidContextPtr&, int& val) {
+        if (++numVisited == 100) {
+            throw std::runtime_error("parallelFor");
+        }
+        val = 1;
+    })->get(), std::runtime_error);
+    EXPECT_GE(numVisited, 100);
+}
+
+TEST_P(ForEachTest, Reduce)
+{
+    std::vector<long> values(100001);
+    std::iota(values.begin(), values.end(), 0);
+    long sum = getDispatcher().reduce(values.begin(), values.end(), 10L, std::plus<long>())->get();
+    EXPECT_EQ(std::accumulate(values.begin(), values.end(), 10L), sum);
+}
+
+TEST_P(ForEachTest, ReduceNonCommutative)
+{
+    //concatenation is associative but not commutative so the order of the chunks must be preserved
+    std::vector<std::string> letters;
+    for (int i = 0; i < 1000; ++i) {
+        letters.emplace_back(1, char('a' + i % 26));
+    }
+    std::string result = getDispatcher().reduce(letters.begin(), letters.end(), std::string(">"),
+        [](std::string lhs, const std::string& rhs) { return lhs + rhs; })->get();
+    EXPECT_EQ(std::accumulate(letters.begin(), letters.end(), std::string(">")), result);
+}
+
+TEST_P(ForEachTest, ReduceEmptyRange)
+{
+    std::vector<int> values;
+    EXPECT_EQ(5, getDispatcher().reduce(values.begin(), values.end(), 5, std::plus<int>())->get());
+}
+
+TEST_P(ForEachTest, TransformReduce)
+{
+    std::vector<std::string> words{"a", "bb", "ccc", "dddd", "eeeee", "ffffff", "ggggggg"};
+    size_t totalLength = getDispatcher().transformReduce(words.begin(), words.end(), size_t(0),
+        std::plus<size_t>(),
+        [](const std::string& word) { return word.size(); })->get();
+    EXPECT_EQ(28u, totalLength);
+}
+
+TEST_P(ForEachTest, InclusiveScan)
+{
+    std::vector<int> values(10007);
+    std::iota(values.begin(), values.end(), -5000);
+    std::vector<int> expected(values.size());
+    std::partial_sum(values.begin(), values.end(), expected.begin());
+    std::vector<int> results(values.size());
+    auto end = getDispatcher().inclusiveScan(values.begin(), values.end(), results.begin(), std::plus<int>())->get();
+    EXPECT_TRUE(end == results.end());
+    EXPECT_EQ(expected, results);
+
+    //in place
+    getDispatcher().inclusiveScan(values.begin(), values.end(), values.begin(), std::plus<int>())->get();
+    EXPECT_EQ(expected, values);
+}
+
+TEST_P(ForEachTest, ExclusiveScan)
+{
+    std::vector<int> values(10007);
+    std::iota(values.begin(), values.end(), 1);
+    std::vector<int> expected(values.size());
+    expected[0] = 100;
+    for (size_t i = 1; i < values.size(); ++i) {
+        expected[i] = expected[i-1] + values[i-1];
+    }
+    std::vector<int> results(values.size());
+    getDispatcher().exclusiveScan(values.begin(), values.end(), results.begin(), 100, std::plus<int>())->get();
+    EXPECT_EQ(expected, results);
+
+    //in place
+    getDispatcher().exclusiveScan(values.begin(), values.end(), values.begin(), 100, std::plus<int>())->get();
+    EXPECT_EQ(expected, values);
+}
+
+TEST_P(ForEachTest, ScanEmptyRange)
+{
+    std::vector<int> values, results;
+    auto end = getDispatcher().inclusiveScan(values.begin(), values.end(), results.begin(), std::plus<int>())->get();
+    EXPECT_TRUE(end == results.begin());
+    end = getDispatcher().exclusiveScan(values.begin(), values.end(), results.begin(), 0, std::plus<int>())->get();
+    EXPECT_TRUE(end == results.begin());
+}
+
+TEST_P(ForEachTest, ReduceAndScanFromCoroutine)
+{
+    std::vector<int> values(1000, 1);
+    std::vector<int> results(values.size());
+    int sum = getDispatcher().post([&values, &results](CoroContextPtr<int> ctx)->int {
+        ctx->inclusiveScan(values.begin(), values.end(), results.begin(), std::plus<int>())->get(ctx);
+        return ctx->set(ctx->reduce(results.begin(), results.end(), 0, std::plus<int>())->get(ctx));
+    })->get();
+    EXPECT_EQ(1000, results.back());
+    EXPECT_EQ(1000*1001/2, sum);
+}
+
+TEST_P(ForEachTest, ReduceException)
+{
+    //every chunk accumulates at least 100 elements
+    std::vector<int> values(100000, 1);
+    EXPECT_THROW(getDispatcher().reduce(values.begin(), values.end(), 0, [](int lhs, int rhs)->int {
+        if (lhs == 100) {
+            throw std::runtime_error("reduce");
+        }
+        return lhs + rhs;
+    })->get(), std::runtime_error);
+}
+
+TEST_P(ForEachTest, Sort)
+{
+    //large enough to be split in several blocks and merged over several rounds
+    std::vector<int> values(100003);
+    std::mt19937 generator(1);
+    std::generate(values.begin(), values.end(), [&generator]{ return (int)(generator() % 1000); });
+    std::vector<int> expected(values);
+    std::sort(expected.begin(), expected.end());
+    getDispatcher().sort(values.begin(), values.end())->get();
+    EXPECT_EQ(expected, values);
+
+    //custom comparison on already sorted input
+    getDispatcher().sort(values.begin(), values.end(), std::greater<int>())->get();
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end(), std::greater<int>()));
+    EXPECT_TRUE(std::is_permutation(values.begin(), values.end(), expected.begin()));
+}
+
+TEST_P(ForEachTest, SortSmallAndEmptyRanges)
+{
+    std::vector<std::string> words{"delta", "alpha", "charlie", "bravo"};
+    getDispatcher().sort(words.begin(), words.end())->get();
+    EXPECT_EQ((std::vector<std::string>{"alpha", "bravo", "charlie", "delta"}), words);
+
+    std::vector<int> values;
+    getDispatcher().sort(values.begin(), values.end())->get();
+    EXPECT_TRUE(values.empty());
+}
+
+TEST_P(ForEachTest, SortFromCoroutine)
+{
+    std::vector<int> values(50000);
+    std::iota(values.rbegin(), values.rend(), 0);
+    getDispatcher().post([&values](VoidContextPtr ctx)->int {
+        return ctx->sort(values.begin(), values.end())->get(ctx);
+    })->get();
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+}
+
+TEST_P(ForEachTest, Partition)
+{
+    std::vector<int> values(100003);
+    std::iota(values.begin(), values.end(), 0);
+    std::shuffle(values.begin(), values.end(), std::mt19937(2));
+    auto isEven = [](int value) { return value % 2 == 0; };
+    auto partitionPoint = getDispatcher().partition(values.begin(), values.end(), isEven)->get();
+    EXPECT_EQ(50002, partitionPoint - values.begin());
+    EXPECT_TRUE(std::is_partitioned(values.begin(), values.end(), isEven));
+    std::sort(values.begin(), values.end());
+    for (int i = 0; i < (int)values.size(); ++i) {
+        ASSERT_EQ(i, values[i]);
+    }
+
+    //all the elements on one side
+    partitionPoint = getDispatcher().partition(values.begin(), values.end(), [](int) { return false; })->get();
+    EXPECT_TRUE(partitionPoint == values.begin());
+}
+
+TEST_P(ForEachTest, NthElement)
+{
+    //many duplicates so that the selected element may fall among the elements equal to a pivot
+    std::vector<int> values(200003);
+    std::mt19937 generator(3);
+    std::generate(values.begin(), values.end(), [&generator]{ return (int)(generator() % 100); });
+    std::vector<int> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t nth : {size_t(0), size_t(12345), values.size()/2, values.size() - 1}) {
+        std::vector<int> selected(values);
+        getDispatcher().nthElement(selected.begin(), selected.begin() + nth, selected.end())->get();
+        EXPECT_EQ(sorted[nth], selected[nth]);
+        EXPECT_TRUE(std::all_of(selected.begin(), selected.begin() + nth,
+                                [&](int value) { return value <= selected[nth]; }));
+        EXPECT_TRUE(std::all_of(selected.begin() + nth, selected.end(),
+                                [&](int value) { return value >= selected[nth]; }));
+    }
+}
+
 TEST_P(MapReduce, OccuranceCount)
 {
     //count the number of times a word of a specific length occurs
@@ -1471,6 +1734,178 @@ TEST_P(MapReduce, WordLengthFromCoroutine)
     })->get();
 }
 
+TEST_P(MapReduce, PartitionedOccuranceCount)
+{
+    //count the number of times a word occurs
+    std::vector<std::vector<std::string>> input = {
+        {"a", "b", "aa", "aaa", "cccc" },
+        {"bb", "bbb", "bbbb", "a", "bb"},
+        {"aaa", "bb", "eee", "cccc", "d", "ddddd"},
+        {"eee", "d", "a" }
+    };
+    auto mapper = [](VoidContextPtr, const std::vector<std::string>& input)->std::vector<std::pair<std::string, size_t>>
+    {
+        std::vector<std::pair<std::string, size_t>> out;
+        for (auto&& i : input) {
+            out.push_back({i, 1});
+        }
+        return out;
+    };
+    auto reducer = [](VoidContextPtr, std::pair<std::string, std::vector<size_t>>&& input)->std::pair<std::string, size_t>
+    {
+        size_t sum = 0;
+        for (auto&& i : input.second) {
+            sum += i;
+        }
+        return {std::move(input.first), sum};
+    };
+    std::map<std::string, size_t> expected = {
+        {"a", 3}, {"aa", 1}, {"aaa", 2}, {"b", 1}, {"bb", 3}, {"bbb", 1},
+        {"bbbb", 1}, {"cccc", 2}, {"d", 2}, {"ddddd", 1}, {"eee", 2}
+    };
+
+    std::unordered_map<std::string, size_t> hashed = getDispatcher().mapReducePartitioned(
+        input.begin(), input.size(), mapper, reducer)->get();
+    std::map<std::string, size_t> hashedSorted(hashed.begin(), hashed.end());
+    EXPECT_EQ(expected, hashedSorted);
+
+    std::map<std::string, size_t> sorted = getDispatcher().mapReducePartitioned<std::map>(
+        input.begin(), input.end(), mapper, reducer)->get();
+    EXPECT_EQ(expected, sorted);
+
+    std::vector<std::pair<std::string, size_t>> pairs = getDispatcher().mapReducePartitioned<std::vector>(
+        input.begin(), input.size(), mapper, reducer)->get();
+    std::sort(pairs.begin(), pairs.end());
+    std::vector<std::pair<std::string, size_t>> expectedPairs(expected.begin(), expected.end());
+    EXPECT_EQ(expectedPairs, pairs);
+}
+
+TEST_P(MapReduce, PartitionedFromCoroutine)
+{
+    //sum the numbers by remainder over a large input
+    std::vector<int> input(10000);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = (int)i;
+    }
+
+    getDispatcher().post([&input](CoroContext<int>::Ptr ctx)->int
+    {
+        std::map<int, long> result = ctx->mapReducePartitioned<std::map>(input.begin(), input.end(),
+        //mapper
+        [](VoidContextPtr, const int& value)->std::vector<std::pair<int, long>>
+        {
+            return {{value % 7, value}};
+        },
+        //reducer
+        [](VoidContextPtr, std::pair<int, std::vector<long>>&& input)->std::pair<int, long>
+        {
+            return {input.first, std::accumulate(input.second.begin(), input.second.end(), 0L)};
+        })->get(ctx);
+
+        EXPECT_EQ(7UL, result.size());
+        for (auto&& remainder : result) {
+            long expected = 0;
+            for (int value : input) {
+                if (value % 7 == remainder.first) {
+                    expected += value;
+                }
+            }
+            EXPECT_EQ(expected, remainder.second);
+        }
+        return ctx->set(0);
+    })->get();
+}
+
+TEST_P(MapReduce, PartitionedEmptyInput)
+{
+    std::vector<int> input;
+    std::unordered_map<int, int> result = getDispatcher().mapReducePartitioned(input.begin(), input.end(),
+        [](VoidContextPtr, const int& value)->std::vector<std::pair<int, int>>
+        {
+            return {{value, value}};
+        },
+        [](VoidContextPtr, std::pair<int, std::vector<int>>&& input)->std::pair<int, int>
+        {
+            return {input.first, (int)input.second.size()};
+        })->get();
+    EXPECT_TRUE(result.empty());
+}
+
+TEST_P(MapReduce, BatchWithCombiner)
+{
+    //count the occurrences of each remainder
+    std::vector<int> input(10000);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = (int)i;
+    }
+    std::atomic_size_t maxValuesPerKey{0};
+
+    std::map<int, size_t> result = getDispatcher().mapReduceBatch(input.begin(), input.end(),
+        //mapper
+        [](VoidContextPtr, const int& value)->std::vector<std::pair<int, size_t>>
+        {
+            return {{value % 10, 1}};
+        },
+        //reducer
+        [&maxValuesPerKey](VoidContextPtr, std::pair<int, std::vector<size_t>>&& input)->std::pair<int, size_t>
+        {
+            size_t numValues = input.second.size();
+            size_t current = maxValuesPerKey;
+            while ((numValues > current) && !maxValuesPerKey.compare_exchange_weak(current, numValues));
+            return {input.first, std::accumulate(input.second.begin(), input.second.end(), 0UL)};
+        },
+        //combiner
+        [](size_t& combined, size_t&& value)
+        {
+            combined += value;
+        })->get();
+
+    ASSERT_EQ(10UL, result.size());
+    for (auto&& count : result) {
+        EXPECT_EQ(1000UL, count.second);
+    }
+    //one value per key and batch
+    EXPECT_LE(maxValuesPerKey, (size_t)getDispatcher().getNumCoroutineThreads());
+}
+
+TEST_P(MapReduce, PartitionedWithCombiner)
+{
+    std::vector<int> input(10000);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = (int)i;
+    }
+
+    getDispatcher().post([&input](CoroContext<int>::Ptr ctx)->int
+    {
+        //one batch per queue
+        size_t numBatches = ctx->getCoroQueueIdRangeForAny().second - ctx->getCoroQueueIdRangeForAny().first + 1;
+        //minimum value by remainder
+        std::unordered_map<int, int> result = ctx->mapReducePartitioned(input.begin(), input.size(),
+        //mapper
+        [](VoidContextPtr, const int& value)->std::vector<std::pair<int, int>>
+        {
+            return {{value % 10, value}};
+        },
+        //reducer
+        [numBatches](VoidContextPtr, std::pair<int, std::vector<int>>&& input)->std::pair<int, int>
+        {
+            EXPECT_LE(input.second.size(), numBatches);
+            return {input.first, *std::min_element(input.second.begin(), input.second.end())};
+        },
+        //combiner
+        [](int& combined, int&& value)
+        {
+            combined = std::min(combined, value);
+        })->get(ctx);
+
+        EXPECT_EQ(10UL, result.size());
+        for (auto&& minimum : result) {
+            EXPECT_EQ(minimum.first, minimum.second);
+        }
+        return ctx->set(0);
+    })->get();
+}
+
 TEST_P(FutureJoinerTest, JoinThreadFutures)
 {
     std::vector<ThreadContext<int>::Ptr> futures;